@@ -1,9 +1,10 @@
 #include <mnml/debug.h>
-#include <mnml/lexer.h>
+#include <mnml/image.h>
 #include <mnml/module.h>
 #include <mnml/slab.h>
 #include <mnml/utils.h>
 #include <errno.h>
+#include <getopt.h>
 #include <limits.h>
 #include <signal.h>
 #include <stdio.h>
@@ -54,8 +55,9 @@ static void
 repl_parse_error_handler(const lisp_t lisp)
 {
   write(1, "^ parse error\n", 14);
-  if (IS_NULL(CDR(CDR(CAR(lisp->ichan))))) {
-    fwrite(": ", 1, 2, stdout);
+  if (IS_NULL(IO_CONTEXT_VALUES(lisp->ichan))) {
+    lisp_write(lisp, ": ", 2);
+    lisp_flush(lisp);
   }
 }
 
@@ -63,8 +65,9 @@ static void
 stage_prompt(const lisp_t lisp, UNUSED const atom_t cell,
              UNUSED const void* const data)
 {
-  if (IS_NULL(CDR(CDR(CAR(lisp->ichan))))) {
-    fwrite(": ", 1, 2, stdout);
+  if (IS_NULL(IO_CONTEXT_VALUES(lisp->ichan))) {
+    lisp_write(lisp, ": ", 2);
+    lisp_flush(lisp);
   }
 }
 
@@ -72,31 +75,35 @@ static void
 stage_newline(const lisp_t lisp, const atom_t cell,
               UNUSED const void* const data)
 {
-  fwrite("> ", 1, 2, stdout);
+  lisp_write(lisp, "> ", 2);
   lisp_prin(lisp, cell, true);
-  fwrite("\n", 1, 1, stdout);
+  lisp_write(lisp, "\n", 1);
 }
 
 /*
  * String evaluation.
  */
 
-static atom_t PAIRS;
-
-static void
-lisp_push(const lisp_t lisp, const atom_t cell)
-{
-  PAIRS = lisp_append(lisp, PAIRS, cell);
-}
-
 static atom_t
-lisp_pop(const lisp_t lisp)
+lisp_parse(const lisp_t lisp, char* const expr, const char* const cwd)
 {
-  atom_t rslt = lisp_car(lisp, PAIRS);
-  atom_t next = lisp_cdr(lisp, PAIRS);
-  X(lisp, PAIRS);
-  PAIRS = next;
-  return rslt;
+  builder_t bld;
+  lisp_builder_init(lisp, &bld);
+  /*
+   * Read the expression from memory.
+   */
+  FILE* handle = fmemopen(expr, strlen(expr), "r");
+  if (handle == NULL) {
+    return bld.head;
+  }
+  lisp_chan_push(lisp, &lisp->ichan, handle, cwd);
+  atom_t input;
+  while ((input = lisp_read(lisp, lisp_make_nil(lisp))) != NULL) {
+    lisp_builder_push(lisp, &bld, input);
+  }
+  lisp_chan_pop(lisp, &lisp->ichan);
+  fclose(handle);
+  return bld.head;
 }
 
 /*
@@ -106,14 +113,16 @@ lisp_pop(const lisp_t lisp)
 static void
 lisp_build_argv(const lisp_t lisp, const int argc, char** const argv)
 {
-  atom_t res = lisp_make_nil(lisp);
+  builder_t bld;
+  lisp_builder_init(lisp, &bld);
   /*
    * Build ARGV.
    */
   for (int i = 0; i < argc; i += 1) {
     atom_t str = lisp_make_string(lisp, argv[i], strlen(argv[i]));
-    res = lisp_append(lisp, res, str);
+    lisp_builder_push(lisp, &bld, str);
   }
+  atom_t res = bld.head;
   /*
    * Set the variable if the list is not NIL.
    */
@@ -187,7 +196,8 @@ static void
 lisp_build_env(const lisp_t lisp)
 {
   extern char** environ;
-  atom_t res = lisp_make_nil(lisp);
+  builder_t bld;
+  lisp_builder_init(lisp, &bld);
   /*
    * Parse environ and build the variable list.
    */
@@ -198,9 +208,10 @@ lisp_build_env(const lisp_t lisp)
       atom_t key = lisp_make_string(lisp, *p, len);
       atom_t val = lisp_make_string(lisp, n + 1, strlen(n + 1));
       atom_t con = lisp_cons(lisp, key, val);
-      res = lisp_append(lisp, res, con);
+      lisp_builder_push(lisp, &bld, con);
     }
   }
+  atom_t res = bld.head;
   /*
    * Set the variable if the list is not NIL.
    */
@@ -221,23 +232,35 @@ lisp_build_env(const lisp_t lisp)
 static void
 lisp_help(const char* const name)
 {
-  fprintf(stderr, "Usage: %s [-b|-d|-h|-v] [-e EXPR | FILE.L]\n", name);
+  fprintf(stderr,
+          "Usage: %s [-b|-d|-h|-v] [--image IMAGE] [--dump IMAGE] "
+          "[-e EXPR | FILE.L]\n",
+          name);
   fprintf(stderr, "Options:\n");
   fprintf(stderr, "\t-b: bare mode, don't load anything by default\n");
   fprintf(stderr, "\t-d: return non-zero status if slab is not empty\n");
   fprintf(stderr, "\t-e: evaluate EXPR\n");
   fprintf(stderr, "\t-h: print this help\n");
   fprintf(stderr, "\t-v: show Minima.l runtime information\n");
+  fprintf(stderr, "\t--dump IMAGE: save the global bindings to IMAGE\n");
+  fprintf(stderr, "\t--image IMAGE: start from the bindings saved in IMAGE\n");
 }
 
 /*
  * Main.
  */
 
+#define OPT_DUMP 256
+#define OPT_IMAGE 257
+
+static const struct option OPTIONS[] = { { "dump", 1, NULL, OPT_DUMP },
+                                         { "image", 1, NULL, OPT_IMAGE },
+                                         { NULL, 0, NULL, 0 } };
+
 #if defined(__linux__)
-#define GETOPT(_c, _v, _o) getopt(_c, _v, "+" _o)
+#define GETOPT(_c, _v, _o) getopt_long(_c, _v, "+" _o, OPTIONS, NULL)
 #elif defined(__MACH__) || defined(__OpenBSD__)
-#define GETOPT(_c, _v, _o) getopt(_c, _v, _o)
+#define GETOPT(_c, _v, _o) getopt_long(_c, _v, _o, OPTIONS, NULL)
 #else
 #error "Operating system not supported"
 #endif
@@ -251,6 +274,8 @@ main(const int argc, char** const argv)
   int c;
   bool check_slab = false, load_defaults = true;
   char* expr = NULL;
+  const char* dump = NULL;
+  const char* image = NULL;
   while ((c = GETOPT(argc, argv, "hvbde:")) != -1) {
     switch (c) {
       case 'b':
@@ -268,6 +293,12 @@ main(const int argc, char** const argv)
       case 'v':
         fprintf(stdout, "%s\n", MNML_VERSION);
         return 0;
+      case OPT_DUMP:
+        dump = optarg;
+        break;
+      case OPT_IMAGE:
+        image = optarg;
+        break;
       default:
         lisp_help(argv[0]);
         return __LINE__;
@@ -316,11 +347,20 @@ main(const int argc, char** const argv)
     fprintf(stderr, "Minima.l engine initialization failed.\n");
     return __LINE__;
   }
+  /*
+   * Load the image. It replaces the default modules.
+   */
+  if (image != NULL && !lisp_image_load(lisp, image)) {
+    fprintf(stderr, "Cannot load image %s.\n", image);
+    return __LINE__;
+  }
   /*
    * Load defaults.
    */
   if (load_defaults) {
-    module_load_defaults(lisp);
+    if (image == NULL) {
+      module_load_defaults(lisp);
+    }
     lisp_build_argv(lisp, argc - optind, &argv[optind]);
     lisp_build_config(lisp);
     lisp_build_env(lisp);
@@ -329,63 +369,60 @@ main(const int argc, char** const argv)
    */
   atom_t result;
   if (filename == NULL && expr == NULL) {
-    lisp_set_parse_error_handler(repl_parse_error_handler);
-    PUSH_IO_CONTEXT(lisp, lisp->ichan, stdin, cwd);
-    PUSH_IO_CONTEXT(lisp, lisp->ochan, stdout, cwd);
+    lisp_set_parse_error_handler(lisp, repl_parse_error_handler);
+    lisp_chan_push(lisp, &lisp->ichan, stdin, cwd);
+    lisp_chan_push(lisp, &lisp->ochan, stdout, cwd);
     result = run(lisp, stage_prompt, stage_newline, cwd);
-    POP_IO_CONTEXT(lisp, lisp->ichan);
-    POP_IO_CONTEXT(lisp, lisp->ochan);
+    lisp_chan_pop(lisp, &lisp->ichan);
+    lisp_chan_pop(lisp, &lisp->ochan);
   } else if (filename == NULL) {
-    /*
-     * Setup the PAIRS to NIL.
-     */
-    PAIRS = lisp_make_nil(lisp);
     /*
      * Parse the expression.
      */
-    lexer_t lexer = lexer_create(lisp, lisp_push);
-    size_t len = strlen(expr);
-    lexer_parse(lexer, expr, len, true);
-    lexer_destroy(lexer);
+    atom_t exprs = lisp_parse(lisp, expr, cwd);
     /*
      * Push the IO context.
      */
-    PUSH_IO_CONTEXT(lisp, lisp->ichan, stdin, cwd);
-    PUSH_IO_CONTEXT(lisp, lisp->ochan, stdout, cwd);
+    lisp_chan_push(lisp, &lisp->ichan, stdin, cwd);
+    lisp_chan_push(lisp, &lisp->ochan, stdout, cwd);
     /*
      * Evaluate the parsed expressions.
      */
     result = lisp_make_nil(lisp);
-    while (keep_running) {
+    atom_t cur = exprs;
+    while (keep_running && !IS_NULL(cur)) {
       atom_t nil = lisp_make_nil(lisp);
-      atom_t car = lisp_pop(lisp);
-      if (IS_NULL(car)) {
-        X(lisp, nil, car);
-        break;
-      }
       X(lisp, result);
-      result = lisp_eval(lisp, nil, car);
+      result = lisp_eval(lisp, nil, UP(CAR(cur)));
       X(lisp, nil);
+      cur = CDR(cur);
     }
     /*
      * Pop the IO context.
      */
-    POP_IO_CONTEXT(lisp, lisp->ichan);
-    POP_IO_CONTEXT(lisp, lisp->ochan);
+    lisp_chan_pop(lisp, &lisp->ichan);
+    lisp_chan_pop(lisp, &lisp->ochan);
     /*
-     * Clear the PAIRS.
+     * Clear the expressions.
      */
-    X(lisp, PAIRS);
+    X(lisp, exprs);
   } else {
-    PUSH_IO_CONTEXT(lisp, lisp->ochan, stdout, cwd);
+    lisp_chan_push(lisp, &lisp->ochan, stdout, cwd);
     result = lisp_load_file(lisp, filename);
-    POP_IO_CONTEXT(lisp, lisp->ochan);
+    lisp_chan_pop(lisp, &lisp->ochan);
   }
   /*
    * Compute the return status.
    */
   int status = IS_NULL(result) ? -1 : 0;
   X(lisp, result);
+  /*
+   * Save the image.
+   */
+  if (dump != NULL && !lisp_image_dump(lisp, dump)) {
+    fprintf(stderr, "Cannot save image %s.\n", dump);
+    status = __LINE__;
+  }
   /*
    * Unload modules.
    */
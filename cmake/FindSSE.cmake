@@ -5,6 +5,7 @@
 
 SET(SSE_FOUND false)
 SET(SSE_VERSION "")
+SET(AVX2_FOUND false)
 
 IF(CMAKE_SYSTEM_NAME MATCHES "Linux")
    EXEC_PROGRAM(cat ARGS "/proc/cpuinfo" OUTPUT_VARIABLE CPUINFO)
@@ -23,6 +24,12 @@ IF(CMAKE_SYSTEM_NAME MATCHES "Linux")
       SET(SSE_VERSION "4.2")
    ENDIF (SSE42_TRUE)
 
+   STRING(REGEX REPLACE "^.*(avx2).*$" "\\1" AVX2_THERE "${CPUINFO}")
+   STRING(COMPARE EQUAL "avx2" "${AVX2_THERE}" AVX2_TRUE)
+   IF (AVX2_TRUE)
+      SET(AVX2_FOUND true)
+   ENDIF (AVX2_TRUE)
+
 ELSEIF(CMAKE_SYSTEM_NAME MATCHES "Darwin")
    EXEC_PROGRAM("/usr/sbin/sysctl -n machdep.cpu.features" OUTPUT_VARIABLE CPUINFO)
 
@@ -40,6 +47,14 @@ ELSEIF(CMAKE_SYSTEM_NAME MATCHES "Darwin")
       SET(SSE_VERSION "4.2")
    ENDIF (SSE42_TRUE)
 
+   EXEC_PROGRAM("/usr/sbin/sysctl -n machdep.cpu.leaf7_features" OUTPUT_VARIABLE CPUINFO)
+
+   STRING(REGEX REPLACE "^.*(AVX2).*$" "\\1" AVX2_THERE "${CPUINFO}")
+   STRING(COMPARE EQUAL "AVX2" "${AVX2_THERE}" AVX2_TRUE)
+   IF (AVX2_TRUE)
+      SET(AVX2_FOUND true)
+   ENDIF (AVX2_TRUE)
+
 ENDIF(CMAKE_SYSTEM_NAME MATCHES "Linux")
 
-mark_as_advanced(SSE_FOUND SSE_VERSION)
+mark_as_advanced(SSE_FOUND SSE_VERSION AVX2_FOUND)
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <mnml/lisp.h>
+#include <stdbool.h>
+
+/*
+ * Array macros.
+ */
+
+#define ARRAY_MAX_LEN ((size_t)UINT32_MAX)
+
+#define ARRAY_KIND(__a) ((__a)->array.store->kind)
+#define ARRAY_LEN(__a) ((size_t)(__a)->array.length)
+#define ARRAY_ESIZE(__a) lisp_array_esize(ARRAY_KIND(__a))
+#define ARRAY_DATA(__a)                 \
+  ((__a)->array.store->data +           \
+   (size_t)(__a)->array.offset * ARRAY_ESIZE(__a))
+
+/*
+ * Size of the elements of an array kind.
+ */
+
+static inline size_t
+lisp_array_esize(const array_kind_t kind)
+{
+  switch (kind) {
+    case A_I64:
+      return sizeof(int64_t);
+    case A_I32:
+      return sizeof(int32_t);
+    default:
+      return sizeof(uint8_t);
+  }
+}
+
+/*
+ * Array kind conversion. Kinds are named i64, i32 and u8.
+ */
+
+bool lisp_array_kind(const atom_t sym, array_kind_t* const kind);
+const char* lisp_array_kind_name(const array_kind_t kind);
+
+/*
+ * Array allocation. The elements of a new array are zeroed.
+ */
+
+atom_t lisp_make_array(const lisp_t lisp, const array_kind_t kind,
+                       const size_t len);
+
+/*
+ * Zero-copy slice of LEN elements at OFF. Return NIL if out of bounds.
+ */
+
+atom_t lisp_array_slice(const lisp_t lisp, const atom_t cell,
+                        const size_t off, const size_t len);
+
+/*
+ * Release the store of an array. Called when the array is deallocated.
+ */
+
+void lisp_array_release(const atom_t cell);
+
+/*
+ * Make sure the store of an array is not shared before modifying it.
+ */
+
+bool lisp_array_own(const atom_t cell);
+
+/*
+ * Element access. Values are truncated to the kind of the array.
+ */
+
+int64_t lisp_array_get(const atom_t cell, const size_t idx);
+void lisp_array_set(const atom_t cell, const size_t idx, const int64_t val);
+
+/*
+ * List conversion. Return NIL if the list does not only contain numbers.
+ */
+
+atom_t lisp_array_from_list(const lisp_t lisp, const array_kind_t kind,
+                            const atom_t cell);
+atom_t lisp_array_to_list(const lisp_t lisp, const atom_t cell);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <mnml/lisp.h>
+
+/*
+ * Parse a decimal integer. Return a number if it fits in 64 bits, a big integer
+ * otherwise, and NIL if STR is not a valid integer.
+ */
+
+atom_t lisp_make_bignum(const lisp_t lisp, const char* const str,
+                        const size_t len);
+
+/*
+ * Release the limbs of a big integer. Called when the atom is deallocated.
+ */
+
+void lisp_bignum_release(const atom_t cell);
+
+/*
+ * Arbitrary-precision arithmetic. The operands are numbers, characters or big
+ * integers. Results that fit in 64 bits are returned as numbers. Division and
+ * modulo truncate toward zero and return NIL when dividing by zero.
+ */
+
+atom_t lisp_bignum_add(const lisp_t lisp, const atom_t a, const atom_t b);
+atom_t lisp_bignum_sub(const lisp_t lisp, const atom_t a, const atom_t b);
+atom_t lisp_bignum_mul(const lisp_t lisp, const atom_t a, const atom_t b);
+atom_t lisp_bignum_div(const lisp_t lisp, const atom_t a, const atom_t b);
+atom_t lisp_bignum_mod(const lisp_t lisp, const atom_t a, const atom_t b);
+
+/*
+ * Compare A and B. Return -1, 0 or 1.
+ */
+
+int lisp_bignum_cmp(const atom_t a, const atom_t b);
+
+/*
+ * Decimal representation of a big integer. The result must be freed.
+ */
+
+char* lisp_bignum_to_cstring(const atom_t cell);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <mnml/lisp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Binary serialization. A message is a magic byte followed by one value. Each
+ * value starts with a tag byte. Integers are zigzag-encoded varints, strings,
+ * buffers and symbol names are length-prefixed, and symbols are interned in a
+ * per-message table. Compound values that are shared within a message are
+ * flagged so that later occurences are written as back-references. Symbols
+ * marked as tail calls are flagged as well.
+ */
+
+#define BIN_MAGIC 0xB1
+
+typedef enum bin_tag
+{
+  B_NIL = 0,
+  B_TRUE = 1,
+  B_WILDCARD = 2,
+  B_CHAR = 3,
+  B_NUMBER = 4,
+  B_SYMBOL = 5,
+  B_SYMREF = 6,
+  B_LIST = 7,
+  B_STRING = 8,
+  B_BUFFER = 9,
+  B_ARRAY = 10,
+  B_BIGNUM = 11,
+  B_ROPE = 12,
+  B_RECORD = 13,
+  B_REF = 14,
+  B_NATIVE = 15
+} bin_tag_t;
+
+#define B_SHARED 0x80
+#define B_TAIL_CALL 0x40
+
+/*
+ * Write CELL to HANDLE. CELL is not consumed. Return false on error.
+ */
+bool lisp_bin_write(const lisp_t lisp, FILE* const handle, const atom_t cell);
+
+/*
+ * Read a value from HANDLE. Return NULL at the end of the file or if the input
+ * is not a valid message.
+ */
+atom_t lisp_bin_read(const lisp_t lisp, FILE* const handle);
+
+/*
+ * Native function addresses are only valid within a process. A module table
+ * lists the load address of native modules. When a table is given, the address
+ * of a native function that belongs to one of its modules is written as the
+ * index of the module and an offset, and relocated when read back.
+ */
+
+typedef struct bin_modules
+{
+  size_t count;
+  const uintptr_t* bases;
+} bin_modules_t;
+
+bool lisp_bin_write_with(const lisp_t lisp, FILE* const handle,
+                         const atom_t cell, const bin_modules_t* const mods);
+
+atom_t lisp_bin_read_with(const lisp_t lisp, FILE* const handle,
+                          const bin_modules_t* const mods);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
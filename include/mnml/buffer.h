@@ -0,0 +1,77 @@
+#pragma once
+
+#include <mnml/lisp.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+/*
+ * Buffer macros.
+ */
+
+#define BUFFER_DEFAULT_SIZE 4096ULL
+#define BUFFER_MAX_SIZE ((size_t)UINT32_MAX)
+
+#define BUFFER_DATA(__a) ((__a)->buffer.store->data + (__a)->buffer.offset)
+#define BUFFER_LEN(__a) ((size_t)(__a)->buffer.length)
+
+/*
+ * Buffer allocation. The content of the buffer is NOT processed for escapes.
+ */
+
+atom_t lisp_make_buffer(const lisp_t lisp, const size_t size);
+atom_t lisp_make_buffer_from(const lisp_t lisp, const char* const data,
+                             const size_t len);
+
+/*
+ * Zero-copy slice of LEN bytes at OFF. Return NIL if out of bounds.
+ */
+
+atom_t lisp_buffer_slice(const lisp_t lisp, const atom_t cell,
+                         const size_t off, const size_t len);
+
+/*
+ * Release the store of a buffer. Called when the buffer is deallocated.
+ */
+
+void lisp_buffer_release(const atom_t cell);
+
+/*
+ * Reserve LEN bytes past the end of the buffer and return a pointer to that
+ * area. The store is copied if it is shared. Return NULL on error.
+ */
+
+char* lisp_buffer_reserve(const atom_t cell, const size_t len);
+
+/*
+ * Append LEN reserved bytes to the buffer.
+ */
+
+void lisp_buffer_commit(const atom_t cell, const size_t len);
+
+/*
+ * Append LEN bytes from DATA to the buffer.
+ */
+
+bool lisp_buffer_append(const atom_t cell, const char* const data,
+                        const size_t len);
+
+/*
+ * Drop LEN bytes from the front of the buffer.
+ */
+
+void lisp_buffer_consume(const atom_t cell, const size_t len);
+
+/*
+ * Find the first occurence of NEEDLE in the buffer. Return -1 if not found.
+ */
+
+ssize_t lisp_buffer_find(const atom_t cell, const char* const needle,
+                         const size_t len);
+
+/*
+ * Make a list of characters out of a buffer.
+ */
+
+atom_t lisp_buffer_to_string(const lisp_t lisp, const atom_t cell);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -1,5 +1,7 @@
 #pragma once
 
 #define ALWAYS_INLINE __attribute__((always_inline))
+#define DESTRUCTOR __attribute__((destructor))
 #define USED __attribute__((used))
 #define UNUSED __attribute__((unused))
+#define THREAD_LOCAL __thread
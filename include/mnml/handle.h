@@ -0,0 +1,80 @@
+#pragma once
+
+#include <mnml/types.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Handle tables. Modules hand out handles to their native objects as numbers
+ * that index a table they own, never as addresses. A handle is made of the
+ * index of its slot and of the generation of the slot, so that a stale handle
+ * is not mistaken for the object that reuses its slot.
+ *
+ * Slots are allocated in pages that are never moved or freed, so handles are
+ * looked up without a lock and the table can be shared by threads. A lookup
+ * holds a reference on the slot until it is released. Closing a handle makes
+ * it invalid for new lookups, and the object is deleted with DEL once the last
+ * reference is released.
+ */
+
+#define HANDLE_PAGE_LEN 1024
+#define HANDLE_PAGE_COUNT 1024
+
+typedef void (*handle_delete_t)(void* const ptr);
+
+typedef struct handle_slot
+{
+  uint64_t state;
+  void* ptr;
+  size_t next;
+} handle_slot_t;
+
+typedef struct handle_table
+{
+  pthread_mutex_t lock;
+  handle_delete_t del;
+  size_t count;
+  size_t free;
+  handle_slot_t* pages[HANDLE_PAGE_COUNT];
+} handle_table_t;
+
+#define HANDLE_TABLE_INIT(__d)                                                 \
+  { .lock = PTHREAD_MUTEX_INITIALIZER, .del = (__d), .count = 0,               \
+    .free = SIZE_MAX }
+
+/*
+ * Register PTR in TABLE. Return its handle, or -1 if the table is full.
+ */
+
+int64_t lisp_handle_new(handle_table_t* const table, void* const ptr);
+
+/*
+ * Look up the object of handle H. Return NULL if H is not an open handle of
+ * TABLE. Otherwise, the object is kept alive until lisp_handle_put is called.
+ */
+
+void* lisp_handle_get(handle_table_t* const table, const atom_t H);
+
+/*
+ * Release the object of handle H acquired with lisp_handle_get.
+ */
+
+void lisp_handle_put(handle_table_t* const table, const atom_t H);
+
+/*
+ * Close the handle H. Return false if H is not an open handle of TABLE. Only
+ * one of concurrent closes succeeds.
+ */
+
+bool lisp_handle_close(handle_table_t* const table, const atom_t H);
+
+/*
+ * Release the pages of TABLE. The objects of the handles still open are not
+ * deleted. Modules call it when they are unloaded.
+ */
+
+void lisp_handle_fini(handle_table_t* const table);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
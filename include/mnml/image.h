@@ -0,0 +1,25 @@
+#pragma once
+
+#include <mnml/lisp.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+ * Heap images. An image holds the global bindings of a context and the list of
+ * the native modules they refer to. Loading an image re-opens the modules and
+ * restores the bindings, so that library scripts don't have to be evaluated
+ * again. The ARGV, CONFIG and ENV variables are not saved.
+ */
+
+bool lisp_image_dump(const lisp_t lisp, const char* const path);
+bool lisp_image_load(const lisp_t lisp, const char* const path);
+
+/*
+ * Write and read an image through HANDLE. A FULL image also holds the ARGV,
+ * CONFIG and ENV variables, for contexts that live in the same process.
+ */
+
+bool lisp_image_write(const lisp_t lisp, FILE* const handle, const bool full);
+bool lisp_image_read(const lisp_t lisp, FILE* const handle);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
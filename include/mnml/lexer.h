@@ -20,6 +20,7 @@ typedef struct lexer
   const char* te;
   size_t depth;
   size_t rem;
+  size_t off;
   lisp_t lisp;
   lisp_consumer_t consumer;
   void* parser;
@@ -32,7 +33,9 @@ lexer_t lexer_create(const lisp_t lisp, const lisp_consumer_t consumer);
 void lexer_destroy(const lexer_t lexer);
 
 /*
- * Lexer parse.
+ * Lexer parse. The lexer stops after each top-level form. The first REM bytes
+ * of STR must be preserved by the caller and new input appended after them.
+ * The scan resumes at OFF, so OFF < REM means that some input is left to parse.
  */
 void lexer_parse(const lexer_t lexer, char* const str, const size_t len,
                  const bool end);
@@ -4,7 +4,9 @@
 #include <mnml/debug.h>
 #include <mnml/slab.h>
 #include <mnml/types.h>
+#include <limits.h>
 #include <stdbool.h>
+#include <stdio.h>
 #include <string.h>
 
 /*
@@ -22,16 +24,60 @@
   (__p) = &(__p)->cdr->pair
 
 /*
- * Lisp context type.
+ * IO context type. The input and output channels are stacks of contexts. A
+ * context holds the channel's handle, the working directory of the code that
+ * runs in it, and the state of its reader or writer. The values read from an
+ * input channel but not consumed yet are queued in VALUES. The slots of a stack
+ * are kept when a context is popped so that pushing a context does not
+ * allocate.
  */
 
+typedef struct io_context
+{
+  FILE* handle;
+  int fd;
+  void* state;
+  atom_t values;
+  char pwd[PATH_MAX];
+}* io_context_t;
+
+typedef struct io_stack
+{
+  size_t depth;
+  size_t cap;
+  struct io_context* slots;
+  void (*release)(const io_context_t ctx);
+} io_stack_t;
+
+/*
+ * Lisp context type. A context and its slab are only used by one thread at a
+ * time.
+ */
+
+struct lisp;
+
+typedef void (*error_handler_t)(struct lisp* const lisp);
+
+/*
+ * Wait handler type. A scheduler that runs coroutines in a context installs a
+ * handler that parks the current coroutine until descriptor FD is ready for
+ * EVENTS. SCHEDULER holds its state.
+ */
+
+typedef bool (*wait_handler_t)(struct lisp* const lisp, const int fd,
+                               const short events);
+
 typedef struct lisp
 {
   slab_t slab;
   atom_t globals;
   atom_t modules;
-  atom_t ichan;
-  atom_t ochan;
+  io_stack_t ichan;
+  io_stack_t ochan;
+  error_handler_t parse_error_handler;
+  error_handler_t syntax_error_handler;
+  wait_handler_t wait_handler;
+  void* scheduler;
   size_t lrefs;
   size_t crefs;
   size_t grefs;
@@ -51,6 +97,34 @@ typedef atom_t (*function_t)(const lisp_t, const atom_t);
 lisp_t lisp_new(const slab_t slab);
 void lisp_delete(const lisp_t lisp);
 
+/*
+ * IO context functions. The current context of a channel is only valid until
+ * the next push on that channel.
+ */
+
+bool lisp_chan_push(const lisp_t lisp, io_stack_t* const chan,
+                    FILE* const handle, const char* const pwd);
+void lisp_chan_pop(const lisp_t lisp, io_stack_t* const chan);
+
+/*
+ * Wait for the EVENTS of descriptor FD. The current coroutine is parked if a
+ * scheduler is running, otherwise the call blocks in poll(). Return false on
+ * error.
+ */
+
+bool lisp_wait(const lisp_t lisp, const int fd, const short events);
+
+/*
+ * Wait for HANDLE to be readable before a read that could block. Only
+ * coroutines wait, and only if HANDLE has no buffered input.
+ */
+
+void lisp_wait_input(const lisp_t lisp, FILE* const handle);
+
+#define IO_CONTEXT(__c) (&(__c).slots[(__c).depth - 1])
+#define IO_CONTEXT_VALUES(__c) (IO_CONTEXT(__c)->values)
+#define IO_CONTEXT_EMPTY(__c) ((__c).depth == 0)
+
 /*
  * Atom allocation.
  */
@@ -345,7 +419,28 @@ atom_t lisp_prog(const lisp_t lisp, const atom_t closure, const atom_t cell,
  */
 
 atom_t lisp_read(const lisp_t lisp, const atom_t cell);
+void lisp_read_release(const io_context_t ctx);
 atom_t lisp_eval(const lisp_t lisp, const atom_t closure, const atom_t cell);
 void lisp_prin(const lisp_t lisp, const atom_t cell, const bool s);
 
+/*
+ * Output functions. Output is buffered per channel. A channel is flushed after
+ * each write, after each new line, or only when its buffer is full, depending
+ * on its mode. It is also flushed when it is released and when requested.
+ */
+
+typedef enum out_mode
+{
+  OUT_NONE,
+  OUT_LINE,
+  OUT_BLOCK
+} out_mode_t;
+
+out_mode_t lisp_get_out_mode(const lisp_t lisp);
+out_mode_t lisp_set_out_mode(const lisp_t lisp, const out_mode_t mode);
+
+void lisp_write(const lisp_t lisp, const void* const data, const size_t len);
+void lisp_write_release(const io_context_t ctx);
+void lisp_flush(const lisp_t lisp);
+
 // vim: tw=80:sw=2:ts=2:sts=2:et
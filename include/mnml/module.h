@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mnml/bignum.h>
 #include <mnml/debug.h>
 #include <mnml/lisp.h>
 #include <mnml/utils.h>
@@ -27,6 +28,13 @@ typedef struct module_entry
 
 atom_t module_load(const lisp_t lisp, const atom_t cell);
 
+/*
+ * Open the module NAME without loading any of its symbols. NAME is not
+ * consumed. Return the module's handle, or NULL if it cannot be found.
+ */
+
+void* module_open(const lisp_t lisp, const atom_t name);
+
 void module_load_defaults(const lisp_t lisp);
 
 /*
@@ -199,18 +207,44 @@ void module_load_defaults(const lisp_t lisp);
                                           : lisp_make_nil(l);      \
   }
 
-#define BINARY_NUMBER_GEN(_n, _o, _x, _y)                          \
+/*
+ * Arithmetic stays on 64 bits and falls back to big integers on overflow.
+ */
+
+#define BINARY_NUMBER_GEN(_n, _x, _y)                                 \
+  static atom_t lisp_function_##_n(const lisp_t l, const atom_t c)    \
+  {                                                                   \
+    LISP_ARGS(c, C, _x, _y);                                          \
+    int64_t r;                                                        \
+    if (likely(!IS_BIGN(_x) && !IS_BIGN(_y)) &&                       \
+        !__builtin_##_n##_overflow((_x)->number, (_y)->number, &r)) { \
+      return lisp_make_number(l, r);                                  \
+    }                                                                 \
+    return lisp_bignum_##_n(l, _x, _y);                               \
+  }
+
+#define BINARY_DIVIDE_GEN(_n, _o, _x, _y)                            \
+  static atom_t lisp_function_##_n(const lisp_t l, const atom_t c)   \
+  {                                                                  \
+    LISP_ARGS(c, C, _x, _y);                                         \
+    if (likely(!IS_BIGN(_x) && !IS_BIGN(_y)) && (_y)->number != 0 && \
+        (_y)->number != -1) {                                        \
+      return lisp_make_number(l, (_x)->number _o _y->number);        \
+    }                                                                \
+    return lisp_bignum_##_n(l, _x, _y);                              \
+  }
+
+#define BINARY_COMPARE_GEN(_n, _o, _x, _y)                         \
   static atom_t lisp_function_##_n(const lisp_t l, const atom_t c) \
   {                                                                \
     LISP_ARGS(c, C, _x, _y);                                       \
-    return lisp_make_number(l, (_x)->number _o _y->number);        \
-  }
-
-#define BINARY_COMPARE_GEN(_n, _o, _x, _y)                                    \
-  static atom_t lisp_function_##_n(const lisp_t l, const atom_t c)            \
-  {                                                                           \
-    LISP_ARGS(c, C, _x, _y);                                                  \
-    return (_x)->number _o _y->number ? lisp_make_true(l) : lisp_make_nil(l); \
+    bool r;                                                        \
+    if (likely(!IS_BIGN(_x) && !IS_BIGN(_y))) {                    \
+      r = (_x)->number _o _y->number;                              \
+    } else {                                                       \
+      r = lisp_bignum_cmp(_x, _y) _o 0;                            \
+    }                                                              \
+    return r ? lisp_make_true(l) : lisp_make_nil(l);               \
   }
 
 // vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <mnml/lisp.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Record macros.
+ */
+
+#define RECORD_MAX_LEN ((size_t)UINT16_MAX)
+
+#define RECORD_DESC(__a) ((__a)->record->desc)
+#define RECORD_NAME(__a) CAR((__a)->record->desc)
+#define RECORD_LEN(__a) ((__a)->record->count)
+#define RECORD_FIELD(__a, __i) ((__a)->record->fields[__i])
+
+/*
+ * Record allocation. DESC is consumed. The COUNT fields are not initialized and
+ * must all be set with RECORD_FIELD before the record is used. Return NIL if
+ * COUNT is larger than RECORD_MAX_LEN.
+ */
+
+atom_t lisp_make_record(const lisp_t lisp, const atom_t desc,
+                        const size_t count);
+
+/*
+ * Release the fields of a record. Called when the record is deallocated.
+ */
+
+void lisp_record_release(const lisp_t lisp, const atom_t cell);
+
+/*
+ * Compare two records.
+ */
+
+bool lisp_record_equ(const atom_t a, const atom_t b);
+
+/*
+ * Make the list (NAME FIELD ...) out of a record.
+ */
+
+atom_t lisp_record_to_list(const lisp_t lisp, const atom_t cell);
+
+/*
+ * Bind the pattern ARG to the list view of the record VAL without building it.
+ * ARG and VAL are consumed.
+ */
+
+atom_t lisp_record_bind(const lisp_t lisp, const atom_t closure,
+                        const atom_t arg, const atom_t val);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <mnml/lisp.h>
+#include <stdbool.h>
+
+/*
+ * Rope macros.
+ */
+
+#define ROPE_DEFAULT_CHUNKS 8
+
+#define ROPE_LEN(__a)                                  \
+  ((__a)->rope.count == 0                              \
+     ? 0                                               \
+     : (__a)->rope.chunks->items[(__a)->rope.count - 1].end)
+
+/*
+ * Rope allocation.
+ */
+
+atom_t lisp_make_rope(const lisp_t lisp);
+
+/*
+ * Make a new view of a rope that can be appended to. The chunks are shared if
+ * CELL is the most recent view of its chunks, copied otherwise.
+ */
+
+atom_t lisp_rope_dup(const lisp_t lisp, const atom_t cell);
+
+/*
+ * Release the chunks of a rope. Called when the rope is deallocated.
+ */
+
+void lisp_rope_release(const lisp_t lisp, const atom_t cell);
+
+/*
+ * Append ITEM to a rope returned by lisp_make_rope or lisp_rope_dup. ITEM is a
+ * string, a character, a buffer or a rope. Strings are copied into buffers,
+ * so the chunks of a rope are only characters and buffers. Return false if
+ * ITEM is not supported.
+ */
+
+bool lisp_rope_push(const lisp_t lisp, const atom_t cell, const atom_t item);
+
+/*
+ * Flatten a rope into DATA, which must hold ROPE_LEN(CELL) bytes.
+ */
+
+void lisp_rope_flatten(const atom_t cell, char* const data);
+
+/*
+ * Compare two ropes.
+ */
+
+bool lisp_rope_equ(const atom_t a, const atom_t b);
+
+/*
+ * Make a list of characters out of a rope.
+ */
+
+atom_t lisp_rope_to_string(const lisp_t lisp, const atom_t cell);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
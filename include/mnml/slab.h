@@ -21,7 +21,7 @@ typedef struct slab
  * Slab macros.
  */
 
-#define SLAB_SIZE (64ULL * 1024ULL * 1024ULL)
+#define SLAB_SIZE (256ULL * 1024ULL * 1024ULL)
 #define PAGE_SIZE 4096ULL
 
 #define CELL_COUNT ((slab->n_pages * PAGE_SIZE) / sizeof(struct atom))
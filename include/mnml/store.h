@@ -0,0 +1,14 @@
+#pragma once
+
+#include <mnml/types.h>
+
+/*
+ * Store functions. A store holds the raw data of buffers and arrays.
+ */
+
+store_t lisp_store_new(const size_t size, const array_kind_t kind);
+store_t lisp_store_dup(const store_t store, const size_t off,
+                       const size_t len, const size_t size);
+void lisp_store_release(const store_t store);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
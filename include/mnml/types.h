@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef LISP_ENABLE_SSE
@@ -36,7 +38,12 @@ typedef enum atom_type
   T_NUMBER = 4,
   T_PAIR = 5,
   T_SYMBOL = 6,
-  T_WILDCARD = 7
+  T_WILDCARD = 7,
+  T_BUFFER = 8,
+  T_ARRAY = 9,
+  T_BIGNUM = 10,
+  T_ROPE = 11,
+  T_RECORD = 12
 } atom_type_t;
 
 typedef enum atom_flag
@@ -46,7 +53,7 @@ typedef enum atom_flag
   F_WEAKREF = 0x4,
 } atom_flag_t;
 
-#define ATOM_TYPES 7
+#define ATOM_TYPES 12
 
 struct atom;
 
@@ -64,6 +71,85 @@ typedef union symbol
   int128_t tag;
 } __attribute__((packed)) * symbol_t;
 
+/*
+ * Stores are reference counted so that buffers and arrays can share them.
+ */
+
+typedef enum array_kind
+{
+  A_I64 = 0,
+  A_I32 = 1,
+  A_U8 = 2
+} array_kind_t;
+
+typedef struct store
+{
+  size_t refs;
+  size_t size;
+  array_kind_t kind;
+  char data[] __attribute__((aligned(16)));
+}* store_t;
+
+typedef struct buffer
+{
+  struct store* store;
+  uint32_t offset;
+  uint32_t length;
+} __attribute__((packed)) * buffer_t;
+
+typedef struct array
+{
+  struct store* store;
+  uint32_t offset;
+  uint32_t length;
+} __attribute__((packed)) * array_t;
+
+/*
+ * Ropes are views on a shared, append-only list of chunks.
+ */
+
+typedef struct chunk
+{
+  struct atom* atom;
+  size_t end;
+}* chunk_t;
+
+typedef struct chunks
+{
+  size_t refs;
+  size_t count;
+  size_t cap;
+  struct chunk* items;
+}* chunks_t;
+
+typedef struct rope
+{
+  struct chunks* chunks;
+  uint64_t count;
+} __attribute__((packed)) * rope_t;
+
+/*
+ * Big integers are stored as a sign and a little-endian array of 32-bit limbs.
+ */
+
+typedef struct bignum
+{
+  bool neg;
+  uint32_t size;
+  uint32_t limbs[];
+}* bignum_t;
+
+/*
+ * Records hold their type descriptor, (NAME FIELD ...), and their fields inline.
+ */
+
+typedef struct record
+{
+  struct atom* desc;
+  size_t count;
+  struct atom* fields[];
+}* record_t;
+
 #ifdef LISP_ENABLE_SSE
 #define NULL_TAG _mm_setzero_si128()
 #else
@@ -85,6 +171,11 @@ typedef struct atom
     int64_t number;
     union symbol symbol;
     struct pair pair;
+    struct buffer buffer;
+    struct array array;
+    struct bignum* bignum;
+    struct rope rope;
+    struct record* record;
   };
 } __attribute__((packed)) * atom_t;
 
@@ -98,6 +189,12 @@ typedef struct atom
 #define IS_NUMB(__a) ((__a)->type == T_NUMBER)
 #define IS_PAIR(__a) ((__a)->type == T_PAIR)
 #define IS_SYMB(__a) ((__a)->type == T_SYMBOL)
+#define IS_BUFF(__a) ((__a)->type == T_BUFFER)
+#define IS_ARRY(__a) ((__a)->type == T_ARRAY)
+#define IS_BIGN(__a) ((__a)->type == T_BIGNUM)
+#define IS_ROPE(__a) ((__a)->type == T_ROPE)
+#define IS_RECD(__a) ((__a)->type == T_RECORD)
+#define IS_INTG(__a) (IS_NUMB(__a) || IS_BIGN(__a))
 
 #define IS_LIST(__a) (IS_PAIR(__a) || IS_NULL(__a))
 #define IS_ATOM(__a) (!IS_LIST(__a))
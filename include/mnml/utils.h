@@ -9,10 +9,8 @@
 /*
  * Interpreter life cycle.
  */
-typedef void (*error_handler_t)(const lisp_t lisp);
-
-void lisp_set_parse_error_handler(const error_handler_t h);
-void lisp_set_syntax_error_handler(const error_handler_t h);
+void lisp_set_parse_error_handler(const lisp_t lisp, const error_handler_t h);
+void lisp_set_syntax_error_handler(const lisp_t lisp, const error_handler_t h);
 
 void lisp_fini(const lisp_t lisp);
 
@@ -31,6 +29,63 @@ size_t lisp_len(const atom_t cell);
  */
 atom_t lisp_append(const lisp_t lisp, const atom_t lst, const atom_t elt);
 
+/*
+ * List builder. It keeps track of the last pair of the list being built so
+ * that elements are appended in constant time. The list is in HEAD.
+ */
+typedef struct builder
+{
+  atom_t head;
+  atom_t tail;
+} builder_t;
+
+ALWAYS_INLINE inline void
+lisp_builder_init(const lisp_t lisp, builder_t* const bld)
+{
+  bld->head = lisp_make_nil(lisp);
+  bld->tail = NULL;
+}
+
+/*
+ * Append element ELT to the list.
+ */
+ALWAYS_INLINE inline void
+lisp_builder_push(const lisp_t lisp, builder_t* const bld, const atom_t elt)
+{
+  atom_t con = lisp_cons(lisp, elt, lisp_make_nil(lisp));
+  if (bld->tail == NULL) {
+    X(lisp, bld->head);
+    bld->head = con;
+  } else {
+    X(lisp, CDR(bld->tail));
+    CDR(bld->tail) = con;
+  }
+  bld->tail = con;
+}
+
+/*
+ * Concatenate list LST to the list. Like lisp_conc, a non-list LST terminates
+ * the list and is dropped by the next append.
+ */
+ALWAYS_INLINE inline void
+lisp_builder_conc(const lisp_t lisp, builder_t* const bld, const atom_t lst)
+{
+  if (bld->tail == NULL) {
+    X(lisp, bld->head);
+    bld->head = lst;
+  } else {
+    X(lisp, CDR(bld->tail));
+    CDR(bld->tail) = lst;
+  }
+  if (IS_PAIR(lst)) {
+    atom_t p = lst;
+    while (IS_PAIR(CDR(p))) {
+      p = CDR(p);
+    }
+    bld->tail = p;
+  }
+}
+
 /*
  * Equality A and B.
  */
@@ -128,26 +183,6 @@ lisp_symbol_compare(const atom_t a, const symbol_t b)
   return memcmp(a->symbol.val, b->val, LISP_SYMBOL_LENGTH);
 }
 
-/*
- * IO context helpers.
- */
-
-#define PUSH_IO_CONTEXT(__l, __c, __d, __p)             \
-  do {                                                  \
-    atom_t p = lisp_make_string(__l, __p, strlen(__p)); \
-    atom_t x = lisp_cons(__l, p, lisp_make_nil(__l));   \
-    atom_t n = lisp_make_number(__l, (int64_t)(__d));   \
-    atom_t y = lisp_cons(__l, n, x);                    \
-    (__c) = lisp_cons(__l, y, __c);                     \
-  } while (0)
-
-#define POP_IO_CONTEXT(__l, __c) \
-  do {                           \
-    atom_t old = __c;            \
-    (__c) = UP(CDR(__c));        \
-    X((__l), old);               \
-  } while (0)
-
 /*
  * Scan PATH-like string format.
  */
@@ -0,0 +1,212 @@
+#include <mnml/array.h>
+#include <mnml/debug.h>
+#include <mnml/lisp.h>
+#include <mnml/slab.h>
+#include <mnml/store.h>
+#include <string.h>
+
+/*
+ * Kind conversion.
+ */
+
+static const char* KINDS[] = { "i64", "i32", "u8" };
+
+bool
+lisp_array_kind(const atom_t sym, array_kind_t* const kind)
+{
+  if (!IS_SYMB(sym)) {
+    return false;
+  }
+  for (size_t i = 0; i < sizeof(KINDS) / sizeof(KINDS[0]); i += 1) {
+    if (strncmp(sym->symbol.val, KINDS[i], LISP_SYMBOL_LENGTH) == 0) {
+      *kind = (array_kind_t)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+const char*
+lisp_array_kind_name(const array_kind_t kind)
+{
+  return KINDS[kind];
+}
+
+/*
+ * Array allocation.
+ */
+
+static atom_t
+lisp_make_array_with(const lisp_t lisp, const store_t store, const size_t off,
+                     const size_t len)
+{
+  atom_t R = lisp_allocate(lisp);
+  R->type = T_ARRAY;
+  R->flags = 0;
+  R->refs = 1;
+  R->array.store = store;
+  R->array.offset = off;
+  R->array.length = len;
+  TRACE_MAKE_SEXP(R);
+  return R;
+}
+
+atom_t
+lisp_make_array(const lisp_t lisp, const array_kind_t kind, const size_t len)
+{
+  /*
+   * Check the length of the array.
+   */
+  if (len > ARRAY_MAX_LEN) {
+    ERROR("Array length too large: %lu", len);
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Allocate and clear the store.
+   */
+  const size_t size = len * lisp_array_esize(kind);
+  store_t store = lisp_store_new(size, kind);
+  if (store == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  memset(store->data, 0, size);
+  /*
+   * Build the array.
+   */
+  return lisp_make_array_with(lisp, store, 0, len);
+}
+
+atom_t
+lisp_array_slice(const lisp_t lisp, const atom_t cell, const size_t off,
+                 const size_t len)
+{
+  /*
+   * Check the boundaries.
+   */
+  if (off > ARRAY_LEN(cell) || len > ARRAY_LEN(cell) - off) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Share the store.
+   */
+  store_t store = cell->array.store;
+  store->refs += 1;
+  return lisp_make_array_with(lisp, store, cell->array.offset + off, len);
+}
+
+void
+lisp_array_release(const atom_t cell)
+{
+  lisp_store_release(cell->array.store);
+}
+
+/*
+ * Array operations.
+ */
+
+bool
+lisp_array_own(const atom_t cell)
+{
+  store_t store = cell->array.store;
+  /*
+   * Nothing to do if the store is not shared.
+   */
+  if (store->refs == 1) {
+    return true;
+  }
+  /*
+   * Copy the elements of the array into a new store.
+   */
+  const size_t len = ARRAY_LEN(cell) * ARRAY_ESIZE(cell);
+  const size_t off = cell->array.offset * ARRAY_ESIZE(cell);
+  store_t next = lisp_store_dup(store, off, len, len);
+  if (next == NULL) {
+    return false;
+  }
+  lisp_store_release(store);
+  /*
+   * Update the array.
+   */
+  cell->array.store = next;
+  cell->array.offset = 0;
+  return true;
+}
+
+int64_t
+lisp_array_get(const atom_t cell, const size_t idx)
+{
+  const char* data = ARRAY_DATA(cell);
+  switch (ARRAY_KIND(cell)) {
+    case A_I64:
+      return ((const int64_t*)data)[idx];
+    case A_I32:
+      return ((const int32_t*)data)[idx];
+    default:
+      return ((const uint8_t*)data)[idx];
+  }
+}
+
+void
+lisp_array_set(const atom_t cell, const size_t idx, const int64_t val)
+{
+  char* data = ARRAY_DATA(cell);
+  switch (ARRAY_KIND(cell)) {
+    case A_I64:
+      ((int64_t*)data)[idx] = val;
+      break;
+    case A_I32:
+      ((int32_t*)data)[idx] = (int32_t)val;
+      break;
+    default:
+      ((uint8_t*)data)[idx] = (uint8_t)val;
+      break;
+  }
+}
+
+/*
+ * List conversion.
+ */
+
+atom_t
+lisp_array_from_list(const lisp_t lisp, const array_kind_t kind,
+                     const atom_t cell)
+{
+  /*
+   * Check that the list only contains numbers.
+   */
+  size_t len = 0;
+  FOREACH(cell, p) {
+    if (!IS_NUMB(p->car)) {
+      return lisp_make_nil(lisp);
+    }
+    len += 1;
+    NEXT(p);
+  }
+  /*
+   * Allocate the array and copy the numbers.
+   */
+  atom_t res = lisp_make_array(lisp, kind, len);
+  if (IS_NULL(res)) {
+    return res;
+  }
+  size_t idx = 0;
+  FOREACH(cell, q) {
+    lisp_array_set(res, idx++, q->car->number);
+    NEXT(q);
+  }
+  return res;
+}
+
+atom_t
+lisp_array_to_list(const lisp_t lisp, const atom_t cell)
+{
+  const size_t len = ARRAY_LEN(cell);
+  atom_t res = lisp_make_nil(lisp);
+  for (size_t i = 0; i < len; i += 1) {
+    atom_t n = lisp_make_number(lisp, lisp_array_get(cell, len - i - 1));
+    res = lisp_cons(lisp, n, res);
+  }
+  return res;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,538 @@
+#include <mnml/bignum.h>
+#include <mnml/debug.h>
+#include <mnml/lisp.h>
+#include <mnml/slab.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Limb types.
+ */
+
+typedef uint32_t limb_t;
+typedef uint64_t dlimb_t;
+
+#define LIMB_BITS 32
+#define LIMB_BASE ((dlimb_t)1 << LIMB_BITS)
+
+/*
+ * Decimal chunks used for conversions.
+ */
+
+#define DEC_CHUNK 1000000000U
+#define DEC_DIGITS 9
+
+/*
+ * Operand view. Numbers are viewed as big integers using the local limbs.
+ */
+
+typedef struct operand
+{
+  bool neg;
+  size_t size;
+  const limb_t* limbs;
+  limb_t local[2];
+} operand_t;
+
+static void
+lisp_bignum_operand(const atom_t cell, operand_t* const op)
+{
+  /*
+   * Big integers are used as is.
+   */
+  if (IS_BIGN(cell)) {
+    op->neg = cell->bignum->neg;
+    op->size = cell->bignum->size;
+    op->limbs = cell->bignum->limbs;
+    return;
+  }
+  /*
+   * Other atoms are viewed through their number.
+   */
+  const int64_t val = cell->number;
+  const uint64_t mag = val < 0 ? -(uint64_t)val : (uint64_t)val;
+  op->neg = val < 0;
+  op->local[0] = (limb_t)mag;
+  op->local[1] = (limb_t)(mag >> LIMB_BITS);
+  op->size = op->local[1] != 0 ? 2 : op->local[0] != 0 ? 1 : 0;
+  op->limbs = op->local;
+}
+
+/*
+ * Allocation.
+ */
+
+static bignum_t
+lisp_bignum_alloc(const size_t size)
+{
+  bignum_t res = (bignum_t)calloc(1, sizeof(struct bignum) +
+                                       size * sizeof(limb_t));
+  if (res == NULL) {
+    ERROR("Cannot allocate a big integer of %lu limbs", size);
+    return NULL;
+  }
+  res->size = size;
+  return res;
+}
+
+static atom_t
+lisp_bignum_result(const lisp_t lisp, const bignum_t big)
+{
+  if (big == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Trim the leading zero limbs.
+   */
+  while (big->size > 0 && big->limbs[big->size - 1] == 0) {
+    big->size -= 1;
+  }
+  /*
+   * Return a number if the result fits in 64 bits.
+   */
+  if (big->size <= 2) {
+    uint64_t mag = big->size > 0 ? big->limbs[0] : 0;
+    mag |= big->size > 1 ? (uint64_t)big->limbs[1] << LIMB_BITS : 0;
+    if (mag <= INT64_MAX || (big->neg && mag == (uint64_t)INT64_MAX + 1)) {
+      const int64_t val = big->neg ? (int64_t)(0 - mag) : (int64_t)mag;
+      free(big);
+      return lisp_make_number(lisp, val);
+    }
+  }
+  /*
+   * Build the big integer.
+   */
+  atom_t R = lisp_allocate(lisp);
+  R->type = T_BIGNUM;
+  R->flags = 0;
+  R->refs = 1;
+  R->bignum = big;
+  TRACE_MAKE_SEXP(R);
+  return R;
+}
+
+void
+lisp_bignum_release(const atom_t cell)
+{
+  free(cell->bignum);
+}
+
+/*
+ * Magnitude operations.
+ */
+
+static int
+lisp_mag_cmp(const limb_t* const a, const size_t na, const limb_t* const b,
+             const size_t nb)
+{
+  if (na != nb) {
+    return na < nb ? -1 : 1;
+  }
+  for (size_t i = na; i > 0; i -= 1) {
+    if (a[i - 1] != b[i - 1]) {
+      return a[i - 1] < b[i - 1] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+/*
+ * R = A + B, with NA >= NB. R has NA + 1 limbs.
+ */
+
+static void
+lisp_mag_add(limb_t* const r, const limb_t* const a, const size_t na,
+             const limb_t* const b, const size_t nb)
+{
+  dlimb_t carry = 0;
+  for (size_t i = 0; i < na; i += 1) {
+    carry += (dlimb_t)a[i] + (i < nb ? b[i] : 0);
+    r[i] = (limb_t)carry;
+    carry >>= LIMB_BITS;
+  }
+  r[na] = (limb_t)carry;
+}
+
+/*
+ * R = A - B, with A >= B. R has NA limbs.
+ */
+
+static void
+lisp_mag_sub(limb_t* const r, const limb_t* const a, const size_t na,
+             const limb_t* const b, const size_t nb)
+{
+  dlimb_t borrow = 0;
+  for (size_t i = 0; i < na; i += 1) {
+    const dlimb_t sub = (dlimb_t)(i < nb ? b[i] : 0) + borrow;
+    borrow = a[i] < sub;
+    r[i] = (limb_t)((dlimb_t)a[i] + (borrow << LIMB_BITS) - sub);
+  }
+}
+
+/*
+ * R = A * B. R has NA + NB zeroed limbs.
+ */
+
+static void
+lisp_mag_mul(limb_t* const r, const limb_t* const a, const size_t na,
+             const limb_t* const b, const size_t nb)
+{
+  for (size_t i = 0; i < na; i += 1) {
+    dlimb_t carry = 0;
+    for (size_t j = 0; j < nb; j += 1) {
+      carry += (dlimb_t)a[i] * b[j] + r[i + j];
+      r[i + j] = (limb_t)carry;
+      carry >>= LIMB_BITS;
+    }
+    r[i + nb] = (limb_t)carry;
+  }
+}
+
+/*
+ * Divide A by a single limb in place and return the remainder.
+ */
+
+static limb_t
+lisp_mag_divmod_1(limb_t* const q, const limb_t* const a, const size_t na,
+                  const limb_t d)
+{
+  dlimb_t rem = 0;
+  for (size_t i = na; i > 0; i -= 1) {
+    const dlimb_t cur = (rem << LIMB_BITS) | a[i - 1];
+    q[i - 1] = (limb_t)(cur / d);
+    rem = cur % d;
+  }
+  return (limb_t)rem;
+}
+
+/*
+ * Knuth's algorithm D. Q has NA - NB + 1 limbs, R has NB limbs. NA >= NB >= 2
+ * and the most significant limb of B is not zero.
+ */
+
+static bool
+lisp_mag_divmod(limb_t* const q, limb_t* const r, const limb_t* const a,
+                const size_t na, const limb_t* const b, const size_t nb)
+{
+  limb_t* un = (limb_t*)malloc((na + 1 + nb) * sizeof(limb_t));
+  if (un == NULL) {
+    return false;
+  }
+  limb_t* vn = un + na + 1;
+  /*
+   * Normalize the operands so that the top limb of B has its high bit set.
+   */
+  const int s = __builtin_clz(b[nb - 1]);
+  for (size_t i = nb - 1; i > 0; i -= 1) {
+    vn[i] = (limb_t)(((dlimb_t)b[i] << s) | ((dlimb_t)b[i - 1] >> (32 - s)));
+  }
+  vn[0] = b[0] << s;
+  un[na] = (limb_t)((dlimb_t)a[na - 1] >> (32 - s));
+  for (size_t i = na - 1; i > 0; i -= 1) {
+    un[i] = (limb_t)(((dlimb_t)a[i] << s) | ((dlimb_t)a[i - 1] >> (32 - s)));
+  }
+  un[0] = a[0] << s;
+  /*
+   * Compute the quotient limb by limb.
+   */
+  for (size_t k = na - nb + 1; k > 0; k -= 1) {
+    const size_t j = k - 1;
+    const dlimb_t num = ((dlimb_t)un[j + nb] << LIMB_BITS) | un[j + nb - 1];
+    dlimb_t qhat = num / vn[nb - 1];
+    dlimb_t rhat = num % vn[nb - 1];
+    while (qhat >= LIMB_BASE ||
+           qhat * vn[nb - 2] > ((rhat << LIMB_BITS) | un[j + nb - 2])) {
+      qhat -= 1;
+      rhat += vn[nb - 1];
+      if (rhat >= LIMB_BASE) {
+        break;
+      }
+    }
+    /*
+     * Multiply and subtract.
+     */
+    int64_t borrow = 0, t = 0;
+    for (size_t i = 0; i < nb; i += 1) {
+      const dlimb_t p = qhat * vn[i];
+      t = (int64_t)un[i + j] - borrow - (int64_t)(p & 0xFFFFFFFFULL);
+      un[i + j] = (limb_t)t;
+      borrow = (int64_t)(p >> LIMB_BITS) - (t >> LIMB_BITS);
+    }
+    t = (int64_t)un[j + nb] - borrow;
+    un[j + nb] = (limb_t)t;
+    q[j] = (limb_t)qhat;
+    /*
+     * Add back if we subtracted too much.
+     */
+    if (t < 0) {
+      q[j] -= 1;
+      dlimb_t carry = 0;
+      for (size_t i = 0; i < nb; i += 1) {
+        carry += (dlimb_t)un[i + j] + vn[i];
+        un[i + j] = (limb_t)carry;
+        carry >>= LIMB_BITS;
+      }
+      un[j + nb] += (limb_t)carry;
+    }
+  }
+  /*
+   * Unnormalize the remainder.
+   */
+  for (size_t i = 0; i < nb - 1; i += 1) {
+    r[i] = (limb_t)(((dlimb_t)un[i] >> s) | ((dlimb_t)un[i + 1] << (32 - s)));
+  }
+  r[nb - 1] = un[nb - 1] >> s;
+  free(un);
+  return true;
+}
+
+/*
+ * Signed operations.
+ */
+
+static atom_t
+lisp_bignum_addsub(const lisp_t lisp, const atom_t a, const atom_t b,
+                   const bool sub)
+{
+  operand_t x, y;
+  lisp_bignum_operand(a, &x);
+  lisp_bignum_operand(b, &y);
+  y.neg = sub ? !y.neg : y.neg;
+  /*
+   * Make sure X is the largest operand.
+   */
+  const operand_t* u = &x;
+  const operand_t* v = &y;
+  if (lisp_mag_cmp(x.limbs, x.size, y.limbs, y.size) < 0) {
+    u = &y;
+    v = &x;
+  }
+  /*
+   * Add or subtract the magnitudes.
+   */
+  bignum_t res = lisp_bignum_alloc(u->size + 1);
+  if (res == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  if (u->neg == v->neg) {
+    lisp_mag_add(res->limbs, u->limbs, u->size, v->limbs, v->size);
+  } else {
+    lisp_mag_sub(res->limbs, u->limbs, u->size, v->limbs, v->size);
+  }
+  res->neg = u->neg;
+  return lisp_bignum_result(lisp, res);
+}
+
+atom_t
+lisp_bignum_add(const lisp_t lisp, const atom_t a, const atom_t b)
+{
+  return lisp_bignum_addsub(lisp, a, b, false);
+}
+
+atom_t
+lisp_bignum_sub(const lisp_t lisp, const atom_t a, const atom_t b)
+{
+  return lisp_bignum_addsub(lisp, a, b, true);
+}
+
+atom_t
+lisp_bignum_mul(const lisp_t lisp, const atom_t a, const atom_t b)
+{
+  operand_t x, y;
+  lisp_bignum_operand(a, &x);
+  lisp_bignum_operand(b, &y);
+  bignum_t res = lisp_bignum_alloc(x.size + y.size);
+  if (res == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  lisp_mag_mul(res->limbs, x.limbs, x.size, y.limbs, y.size);
+  res->neg = x.neg != y.neg;
+  return lisp_bignum_result(lisp, res);
+}
+
+static atom_t
+lisp_bignum_divmod(const lisp_t lisp, const atom_t a, const atom_t b,
+                   const bool mod)
+{
+  operand_t x, y;
+  lisp_bignum_operand(a, &x);
+  lisp_bignum_operand(b, &y);
+  /*
+   * Check for a division by zero.
+   */
+  if (y.size == 0) {
+    ERROR("Division by zero");
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * If |X| < |Y|, the quotient is 0 and the remainder is X.
+   */
+  if (lisp_mag_cmp(x.limbs, x.size, y.limbs, y.size) < 0) {
+    if (!mod) {
+      return lisp_make_number(lisp, 0);
+    }
+    return IS_BIGN(a) ? UP(a) : lisp_make_number(lisp, a->number);
+  }
+  /*
+   * Allocate the quotient and the remainder.
+   */
+  bignum_t quo = lisp_bignum_alloc(x.size - y.size + 1);
+  bignum_t rem = lisp_bignum_alloc(y.size);
+  if (quo == NULL || rem == NULL) {
+    free(quo);
+    free(rem);
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Divide the magnitudes.
+   */
+  if (y.size == 1) {
+    rem->limbs[0] = lisp_mag_divmod_1(quo->limbs, x.limbs, x.size, y.limbs[0]);
+  } else if (!lisp_mag_divmod(quo->limbs, rem->limbs, x.limbs, x.size,
+                              y.limbs, y.size)) {
+    free(quo);
+    free(rem);
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * The quotient is truncated toward zero, the remainder has the sign of X.
+   */
+  quo->neg = x.neg != y.neg;
+  rem->neg = x.neg;
+  if (mod) {
+    free(quo);
+    return lisp_bignum_result(lisp, rem);
+  }
+  free(rem);
+  return lisp_bignum_result(lisp, quo);
+}
+
+atom_t
+lisp_bignum_div(const lisp_t lisp, const atom_t a, const atom_t b)
+{
+  return lisp_bignum_divmod(lisp, a, b, false);
+}
+
+atom_t
+lisp_bignum_mod(const lisp_t lisp, const atom_t a, const atom_t b)
+{
+  return lisp_bignum_divmod(lisp, a, b, true);
+}
+
+int
+lisp_bignum_cmp(const atom_t a, const atom_t b)
+{
+  operand_t x, y;
+  lisp_bignum_operand(a, &x);
+  lisp_bignum_operand(b, &y);
+  /*
+   * Compare the signs. Zero is never negative.
+   */
+  if (x.neg != y.neg) {
+    return x.neg ? -1 : 1;
+  }
+  /*
+   * Compare the magnitudes.
+   */
+  const int res = lisp_mag_cmp(x.limbs, x.size, y.limbs, y.size);
+  return x.neg ? -res : res;
+}
+
+/*
+ * Decimal conversions.
+ */
+
+atom_t
+lisp_make_bignum(const lisp_t lisp, const char* const str, const size_t len)
+{
+  size_t idx = 0;
+  bool neg = false;
+  /*
+   * Grab the sign.
+   */
+  if (len > 0 && (str[0] == '-' || str[0] == '+')) {
+    neg = str[0] == '-';
+    idx = 1;
+  }
+  if (idx == len) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Allocate enough limbs: a limb holds at least 9 digits.
+   */
+  bignum_t res = lisp_bignum_alloc((len - idx) / DEC_DIGITS + 1);
+  if (res == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  size_t size = 0;
+  /*
+   * Process the digits by chunks of 9: R = R * 10^N + CHUNK.
+   */
+  while (idx < len) {
+    limb_t chunk = 0, scale = 1;
+    for (size_t n = 0; n < DEC_DIGITS && idx < len; n += 1, idx += 1) {
+      if (str[idx] < '0' || str[idx] > '9') {
+        free(res);
+        return lisp_make_nil(lisp);
+      }
+      chunk = chunk * 10 + (str[idx] - '0');
+      scale *= 10;
+    }
+    dlimb_t carry = chunk;
+    for (size_t i = 0; i < size; i += 1) {
+      carry += (dlimb_t)res->limbs[i] * scale;
+      res->limbs[i] = (limb_t)carry;
+      carry >>= LIMB_BITS;
+    }
+    if (carry != 0) {
+      res->limbs[size++] = (limb_t)carry;
+    }
+  }
+  /*
+   * Return the result.
+   */
+  res->neg = neg;
+  res->size = size;
+  return lisp_bignum_result(lisp, res);
+}
+
+char*
+lisp_bignum_to_cstring(const atom_t cell)
+{
+  const size_t size = cell->bignum->size;
+  /*
+   * A limb holds at most 10 digits. Account for the sign and the terminator.
+   */
+  const size_t len = size * 10 + 2;
+  char* res = (char*)malloc(len + size * sizeof(limb_t));
+  if (res == NULL) {
+    return NULL;
+  }
+  limb_t* tmp = (limb_t*)(res + len);
+  memcpy(tmp, cell->bignum->limbs, size * sizeof(limb_t));
+  /*
+   * Extract the digits backward, by chunks of 9.
+   */
+  size_t idx = len - 1, cur = size;
+  res[idx] = 0;
+  while (cur > 0) {
+    limb_t rem = lisp_mag_divmod_1(tmp, tmp, cur, DEC_CHUNK);
+    while (cur > 0 && tmp[cur - 1] == 0) {
+      cur -= 1;
+    }
+    for (size_t n = 0; n < DEC_DIGITS && (cur > 0 || rem > 0); n += 1) {
+      res[--idx] = (char)('0' + rem % 10);
+      rem /= 10;
+    }
+  }
+  if (cell->bignum->neg) {
+    res[--idx] = '-';
+  }
+  /*
+   * Move the string at the beginning of the buffer.
+   */
+  memmove(res, res + idx, len - idx);
+  return res;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
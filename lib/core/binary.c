@@ -0,0 +1,1027 @@
+#include <mnml/array.h>
+#include <mnml/bignum.h>
+#include <mnml/binary.h>
+#include <mnml/buffer.h>
+#include <mnml/debug.h>
+#include <mnml/lisp.h>
+#include <mnml/record.h>
+#include <mnml/rope.h>
+#include <mnml/slab.h>
+#include <mnml/tree.h>
+#include <mnml/utils.h>
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BIN_DEFAULT_SIZE 4096
+#define BIN_DEFAULT_SLOTS 64
+
+/*
+ * Open-addressing map from atoms to indexes. Symbols are keyed by name, other
+ * atoms by address.
+ */
+
+typedef struct bin_slot
+{
+  atom_t key;
+  size_t idx;
+}* bin_slot_t;
+
+typedef struct bin_map
+{
+  size_t cap;
+  size_t count;
+  struct bin_slot* slots;
+} bin_map_t;
+
+static size_t
+bin_hash(const atom_t cell)
+{
+  uint64_t h;
+  if (IS_SYMB(cell)) {
+    uint64_t w[2];
+    memcpy(w, cell->symbol.val, sizeof(w));
+    h = w[0] ^ (w[1] * 0x9E3779B97F4A7C15ULL);
+  } else {
+    h = (uintptr_t)cell >> 5;
+  }
+  return (size_t)((h * 0x9E3779B97F4A7C15ULL) >> 32);
+}
+
+static bool
+bin_same(const atom_t a, const atom_t b)
+{
+  return a == b ||
+         (IS_SYMB(a) && IS_SYMB(b) && lisp_symbol_match(a, &b->symbol));
+}
+
+static bool
+bin_map_init(bin_map_t* const map)
+{
+  map->cap = BIN_DEFAULT_SLOTS;
+  map->count = 0;
+  map->slots = (struct bin_slot*)calloc(map->cap, sizeof(struct bin_slot));
+  return map->slots != NULL;
+}
+
+static bin_slot_t
+bin_map_find(const bin_map_t* const map, const atom_t key)
+{
+  size_t i = bin_hash(key) & (map->cap - 1);
+  while (map->slots[i].key != NULL && !bin_same(map->slots[i].key, key)) {
+    i = (i + 1) & (map->cap - 1);
+  }
+  return &map->slots[i];
+}
+
+static bool
+bin_map_put(bin_map_t* const map, const atom_t key)
+{
+  /*
+   * Keep the load factor under 1/2.
+   */
+  if ((map->count + 1) * 2 > map->cap) {
+    bin_map_t next = { .cap = map->cap << 1, .count = map->count };
+    next.slots = (struct bin_slot*)calloc(next.cap, sizeof(struct bin_slot));
+    if (next.slots == NULL) {
+      return false;
+    }
+    for (size_t i = 0; i < map->cap; i += 1) {
+      if (map->slots[i].key != NULL) {
+        *bin_map_find(&next, map->slots[i].key) = map->slots[i];
+      }
+    }
+    free(map->slots);
+    *map = next;
+  }
+  /*
+   * Indexes are attributed in insertion order.
+   */
+  bin_slot_t slot = bin_map_find(map, key);
+  slot->key = key;
+  slot->idx = map->count;
+  map->count += 1;
+  return true;
+}
+
+/*
+ * Writer.
+ */
+
+typedef struct bin_writer
+{
+  bool error;
+  size_t len;
+  size_t cap;
+  char* data;
+  bin_map_t syms;
+  bin_map_t objs;
+  const bin_modules_t* mods;
+} bin_writer_t;
+
+static char*
+bin_reserve(bin_writer_t* const w, const size_t len)
+{
+  if (w->error) {
+    return NULL;
+  }
+  /*
+   * Grow the buffer if necessary.
+   */
+  if (w->len + len > w->cap) {
+    size_t cap = w->cap << 1;
+    while (cap < w->len + len) {
+      cap <<= 1;
+    }
+    char* data = (char*)realloc(w->data, cap);
+    if (data == NULL) {
+      ERROR("Cannot grow the serialization buffer to %lu bytes", cap);
+      w->error = true;
+      return NULL;
+    }
+    w->data = data;
+    w->cap = cap;
+  }
+  /*
+   */
+  char* res = w->data + w->len;
+  w->len += len;
+  return res;
+}
+
+static void
+bin_put_byte(bin_writer_t* const w, const uint8_t val)
+{
+  char* p = bin_reserve(w, 1);
+  if (p != NULL) {
+    *p = (char)val;
+  }
+}
+
+static void
+bin_put_uint(bin_writer_t* const w, uint64_t val)
+{
+  char* p = bin_reserve(w, 10);
+  if (p == NULL) {
+    return;
+  }
+  size_t n = 0;
+  while (val >= 0x80) {
+    p[n++] = (char)(val | 0x80);
+    val >>= 7;
+  }
+  p[n++] = (char)val;
+  w->len -= 10 - n;
+}
+
+static void
+bin_put_int(bin_writer_t* const w, const int64_t val)
+{
+  bin_put_uint(w, ((uint64_t)val << 1) ^ (uint64_t)(val >> 63));
+}
+
+static void
+bin_put_data(bin_writer_t* const w, const void* const data, const size_t len)
+{
+  bin_put_uint(w, len);
+  char* p = bin_reserve(w, len);
+  if (p != NULL) {
+    memcpy(p, data, len);
+  }
+}
+
+static bool
+bin_is_compound(const atom_t cell)
+{
+  switch (cell->type) {
+    case T_PAIR:
+    case T_BUFFER:
+    case T_ARRAY:
+    case T_BIGNUM:
+    case T_ROPE:
+    case T_RECORD:
+      return true;
+    default:
+      return false;
+  }
+}
+
+/*
+ * Lists of characters are written as strings. Unlike other lists, the sharing
+ * of their tail is not preserved since evaluated string literals share it with
+ * their definition.
+ */
+
+static size_t
+bin_string_len(const atom_t cell)
+{
+  size_t len = 0;
+  FOREACH(cell, p)
+  {
+    if (!IS_CHAR(p->car)) {
+      return 0;
+    }
+    len += 1;
+    NEXT(p);
+  }
+  return IS_NULL(p->cdr) ? len : 0;
+}
+
+/*
+ * Native functions are (ARGS DSCL . ADDRESS), with ARGS a list of symbols and
+ * DSCL the list of curried bindings. The address is relocated if it lies in
+ * one of the modules of the table.
+ */
+
+static bool
+bin_is_native(const atom_t cell)
+{
+  const atom_t next = CDR(cell);
+  if (!IS_PAIR(next) || !IS_NUMB(CDR(next)) || !IS_LIST(CAR(cell)) ||
+      !IS_LIST(CAR(next))) {
+    return false;
+  }
+  FOREACH(CAR(cell), p)
+  {
+    if (!IS_SYMB(p->car)) {
+      return false;
+    }
+    NEXT(p);
+  }
+  return IS_NULL(CAR(cell)) || IS_NULL(p->cdr);
+}
+
+static bool
+bin_write_native(bin_writer_t* const w, const atom_t cell)
+{
+  Dl_info info;
+  if (dladdr((void*)cell->number, &info) == 0 || info.dli_fbase == NULL) {
+    return false;
+  }
+  const uintptr_t base = (uintptr_t)info.dli_fbase;
+  for (size_t i = 0; i < w->mods->count; i += 1) {
+    if (w->mods->bases[i] == base) {
+      bin_put_byte(w, B_NATIVE);
+      bin_put_uint(w, i);
+      bin_put_uint(w, (uintptr_t)cell->number - base);
+      return true;
+    }
+  }
+  return false;
+}
+
+static void bin_write_value(bin_writer_t* const w, const atom_t cell);
+
+static void
+bin_write_pair(bin_writer_t* const w, const atom_t cell, const uint8_t flag)
+{
+  /*
+   * Write strings.
+   */
+  const size_t len = bin_string_len(cell);
+  if (len > 0) {
+    bin_put_byte(w, B_STRING | flag);
+    bin_put_uint(w, len);
+    char* p = bin_reserve(w, len);
+    if (p == NULL) {
+      return;
+    }
+    FOREACH(cell, q)
+    {
+      *p++ = (char)q->car->number;
+      NEXT(q);
+    }
+    return;
+  }
+  /*
+   * Count the elements up to the first shared pair. Native functions are
+   * written whole so that their address is found in tail position.
+   */
+  const bool native = w->mods != NULL && bin_is_native(cell);
+  size_t count = 1;
+  atom_t last = cell;
+  while (IS_PAIR(CDR(last)) && (native || CDR(last)->refs == 1)) {
+    last = CDR(last);
+    count += 1;
+  }
+  /*
+   * Write the elements and the tail.
+   */
+  bin_put_byte(w, B_LIST | flag);
+  bin_put_uint(w, count);
+  atom_t p = cell;
+  for (size_t i = 0; i < count; i += 1) {
+    bin_write_value(w, CAR(p));
+    p = CDR(p);
+  }
+  if (native && bin_write_native(w, p)) {
+    return;
+  }
+  bin_write_value(w, p);
+}
+
+static void
+bin_write_array(bin_writer_t* const w, const atom_t cell, const uint8_t flag)
+{
+  const size_t len = ARRAY_LEN(cell);
+  bin_put_byte(w, B_ARRAY | flag);
+  bin_put_byte(w, ARRAY_KIND(cell));
+  /*
+   * Bytes are written as is, other elements as varints.
+   */
+  if (ARRAY_KIND(cell) == A_U8) {
+    bin_put_data(w, ARRAY_DATA(cell), len);
+    return;
+  }
+  bin_put_uint(w, len);
+  for (size_t i = 0; i < len; i += 1) {
+    bin_put_int(w, lisp_array_get(cell, i));
+  }
+}
+
+static void
+bin_write_value(bin_writer_t* const w, const atom_t cell)
+{
+  uint8_t flag = 0;
+  /*
+   * Compound values referenced more than once may appear again in the message.
+   * Write a back-reference if that's the case, otherwise flag them.
+   */
+  if (cell->refs > 1 && bin_is_compound(cell)) {
+    bin_slot_t slot = bin_map_find(&w->objs, cell);
+    if (slot->key != NULL) {
+      bin_put_byte(w, B_REF);
+      bin_put_uint(w, slot->idx);
+      return;
+    }
+    flag = B_SHARED;
+  }
+  /*
+   * Write the value.
+   */
+  switch (cell->type) {
+    case T_NIL:
+      bin_put_byte(w, B_NIL);
+      break;
+    case T_TRUE:
+      bin_put_byte(w, B_TRUE);
+      break;
+    case T_WILDCARD:
+      bin_put_byte(w, B_WILDCARD);
+      break;
+    case T_CHAR:
+      bin_put_byte(w, B_CHAR);
+      bin_put_byte(w, (uint8_t)cell->number);
+      break;
+    case T_NUMBER:
+      bin_put_byte(w, B_NUMBER);
+      bin_put_int(w, cell->number);
+      break;
+    case T_SYMBOL: {
+      const uint8_t tail = IS_TAIL_CALL(cell) ? B_TAIL_CALL : 0;
+      bin_slot_t slot = bin_map_find(&w->syms, cell);
+      if (slot->key != NULL) {
+        bin_put_byte(w, B_SYMREF | tail);
+        bin_put_uint(w, slot->idx);
+        break;
+      }
+      const size_t len = strnlen(cell->symbol.val, LISP_SYMBOL_LENGTH);
+      bin_put_byte(w, B_SYMBOL | tail);
+      bin_put_data(w, cell->symbol.val, len);
+      w->error |= !bin_map_put(&w->syms, cell);
+      break;
+    }
+    case T_PAIR:
+      bin_write_pair(w, cell, flag);
+      break;
+    case T_BUFFER:
+      bin_put_byte(w, B_BUFFER | flag);
+      bin_put_data(w, BUFFER_DATA(cell), BUFFER_LEN(cell));
+      break;
+    case T_ARRAY:
+      bin_write_array(w, cell, flag);
+      break;
+    case T_BIGNUM: {
+      char* str = lisp_bignum_to_cstring(cell);
+      if (str == NULL) {
+        w->error = true;
+        break;
+      }
+      bin_put_byte(w, B_BIGNUM | flag);
+      bin_put_data(w, str, strlen(str));
+      free(str);
+      break;
+    }
+    case T_ROPE: {
+      const size_t len = ROPE_LEN(cell);
+      bin_put_byte(w, B_ROPE | flag);
+      bin_put_uint(w, len);
+      char* p = bin_reserve(w, len);
+      if (p != NULL) {
+        lisp_rope_flatten(cell, p);
+      }
+      break;
+    }
+    case T_RECORD:
+      bin_put_byte(w, B_RECORD | flag);
+      bin_write_value(w, RECORD_DESC(cell));
+      bin_put_uint(w, RECORD_LEN(cell));
+      for (size_t i = 0; i < RECORD_LEN(cell); i += 1) {
+        bin_write_value(w, RECORD_FIELD(cell, i));
+      }
+      break;
+    default:
+      w->error = true;
+      break;
+  }
+  /*
+   * Register the shared value once it has been written.
+   */
+  if (flag != 0 && !w->error) {
+    w->error = !bin_map_put(&w->objs, cell);
+  }
+}
+
+bool
+lisp_bin_write(const lisp_t lisp, FILE* const handle, const atom_t cell)
+{
+  return lisp_bin_write_with(lisp, handle, cell, NULL);
+}
+
+bool
+lisp_bin_write_with(UNUSED const lisp_t lisp, FILE* const handle,
+                    const atom_t cell, const bin_modules_t* const mods)
+{
+  bin_writer_t w = {
+    .error = false, .len = 0, .cap = BIN_DEFAULT_SIZE, .mods = mods
+  };
+  /*
+   * Allocate the state.
+   */
+  w.data = (char*)malloc(w.cap);
+  if (w.data == NULL) {
+    return false;
+  }
+  if (!bin_map_init(&w.syms)) {
+    free(w.data);
+    return false;
+  }
+  if (!bin_map_init(&w.objs)) {
+    free(w.syms.slots);
+    free(w.data);
+    return false;
+  }
+  /*
+   * Serialize the value and write the message at once.
+   */
+  bin_put_byte(&w, BIN_MAGIC);
+  bin_write_value(&w, cell);
+  bool res = !w.error && fwrite(w.data, 1, w.len, handle) == w.len;
+  /*
+   * Clean-up.
+   */
+  free(w.objs.slots);
+  free(w.syms.slots);
+  free(w.data);
+  return res;
+}
+
+/*
+ * Reader.
+ */
+
+typedef struct bin_reader
+{
+  FILE* handle;
+  bool error;
+  size_t nsyms;
+  size_t csyms;
+  atom_t* syms;
+  size_t nobjs;
+  size_t cobjs;
+  atom_t* objs;
+  const bin_modules_t* mods;
+} bin_reader_t;
+
+static uint8_t
+bin_get_byte(bin_reader_t* const r)
+{
+  const int c = getc_unlocked(r->handle);
+  if (c == EOF) {
+    r->error = true;
+    return 0;
+  }
+  return (uint8_t)c;
+}
+
+static uint64_t
+bin_get_uint(bin_reader_t* const r)
+{
+  uint64_t val = 0;
+  for (size_t shift = 0; shift < 64; shift += 7) {
+    const uint8_t c = bin_get_byte(r);
+    val |= (uint64_t)(c & 0x7F) << shift;
+    if ((c & 0x80) == 0) {
+      return val;
+    }
+  }
+  r->error = true;
+  return 0;
+}
+
+static int64_t
+bin_get_int(bin_reader_t* const r)
+{
+  const uint64_t val = bin_get_uint(r);
+  return (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+}
+
+static bool
+bin_get_data(bin_reader_t* const r, void* const data, const size_t len)
+{
+  if (fread(data, 1, len, r->handle) != len) {
+    r->error = true;
+  }
+  return !r->error;
+}
+
+/*
+ * Grow DATA to hold at least NEED bytes, doubling its capacity up to MAX.
+ * Lengths come from the input, so storage grows with the data actually read
+ * rather than being allocated upfront.
+ */
+
+static bool
+bin_grow(bin_reader_t* const r, char** const data, size_t* const cap,
+         const size_t need, const size_t max)
+{
+  if (need <= *cap) {
+    return true;
+  }
+  size_t next = *cap == 0 ? BIN_DEFAULT_SIZE : *cap << 1;
+  if (next < need) {
+    next = need;
+  }
+  if (next > max) {
+    next = max;
+  }
+  char* res = (char*)realloc(*data, next);
+  if (res == NULL) {
+    r->error = true;
+    return false;
+  }
+  *data = res;
+  *cap = next;
+  return true;
+}
+
+/*
+ * Read LEN bytes in bounded steps. The result is null-terminated and must be
+ * freed.
+ */
+
+static char*
+bin_get_bytes(bin_reader_t* const r, const size_t len)
+{
+  char* data = NULL;
+  size_t cap = 0;
+  size_t off = 0;
+  do {
+    const size_t n =
+      len - off < BIN_DEFAULT_SIZE ? len - off : BIN_DEFAULT_SIZE;
+    if (!bin_grow(r, &data, &cap, off + n + 1, len + 1) ||
+        !bin_get_data(r, data + off, n)) {
+      free(data);
+      return NULL;
+    }
+    off += n;
+  } while (off < len);
+  data[len] = 0;
+  return data;
+}
+
+/*
+ * Read a length-prefixed chunk of bytes. The result must be freed.
+ */
+
+static char*
+bin_get_chunk(bin_reader_t* const r, size_t* const len)
+{
+  *len = bin_get_uint(r);
+  if (r->error || *len > BUFFER_MAX_SIZE) {
+    r->error = true;
+    return NULL;
+  }
+  return bin_get_bytes(r, *len);
+}
+
+static bool
+bin_push(atom_t** const tab, size_t* const cnt, size_t* const cap,
+         const atom_t cell)
+{
+  if (*cnt == *cap) {
+    const size_t next = *cap == 0 ? BIN_DEFAULT_SLOTS : *cap << 1;
+    atom_t* res = (atom_t*)realloc(*tab, next * sizeof(atom_t));
+    if (res == NULL) {
+      return false;
+    }
+    *tab = res;
+    *cap = next;
+  }
+  (*tab)[*cnt] = cell;
+  *cnt += 1;
+  return true;
+}
+
+static atom_t bin_read_value(const lisp_t lisp, bin_reader_t* const r);
+
+static atom_t
+bin_read_list(const lisp_t lisp, bin_reader_t* const r)
+{
+  const uint64_t count = bin_get_uint(r);
+  builder_t bld;
+  lisp_builder_init(lisp, &bld);
+  /*
+   * Read the elements.
+   */
+  for (uint64_t i = 0; i < count && !r->error; i += 1) {
+    atom_t elt = bin_read_value(lisp, r);
+    if (elt == NULL) {
+      break;
+    }
+    lisp_builder_push(lisp, &bld, elt);
+  }
+  /*
+   * Read the tail.
+   */
+  atom_t tail = r->error ? NULL : bin_read_value(lisp, r);
+  if (tail == NULL) {
+    X(lisp, bld.head);
+    return NULL;
+  }
+  lisp_builder_conc(lisp, &bld, tail);
+  return bld.head;
+}
+
+static atom_t
+bin_read_string(const lisp_t lisp, bin_reader_t* const r)
+{
+  size_t len;
+  char* data = bin_get_chunk(r, &len);
+  if (data == NULL) {
+    return NULL;
+  }
+  /*
+   * Escapes are not processed.
+   */
+  builder_t bld;
+  lisp_builder_init(lisp, &bld);
+  for (size_t i = 0; i < len; i += 1) {
+    lisp_builder_push(lisp, &bld, lisp_make_char(lisp, data[i]));
+  }
+  free(data);
+  return bld.head;
+}
+
+static atom_t
+bin_read_symbol(const lisp_t lisp, bin_reader_t* const r)
+{
+  char data[LISP_SYMBOL_LENGTH];
+  const uint64_t len = bin_get_uint(r);
+  if (r->error || len > LISP_SYMBOL_LENGTH ||
+      !bin_get_data(r, data, len)) {
+    r->error = true;
+    return NULL;
+  }
+  /*
+   * Keep a reference in the symbol table.
+   */
+  atom_t R = lisp_make_symbol_from_string(lisp, data, len);
+  if (!bin_push(&r->syms, &r->nsyms, &r->csyms, R)) {
+    X(lisp, R);
+    r->error = true;
+    return NULL;
+  }
+  return UP(R);
+}
+
+static atom_t
+bin_read_array(const lisp_t lisp, bin_reader_t* const r)
+{
+  const uint8_t kind = bin_get_byte(r);
+  const uint64_t len = bin_get_uint(r);
+  if (r->error || kind > A_U8 || len > ARRAY_MAX_LEN) {
+    r->error = true;
+    return NULL;
+  }
+  /*
+   * Read the elements.
+   */
+  const size_t esize = lisp_array_esize((array_kind_t)kind);
+  const size_t size = len * esize;
+  char* data = NULL;
+  if (kind == A_U8) {
+    data = bin_get_bytes(r, len);
+  } else {
+    size_t cap = 0;
+    for (uint64_t i = 0; i < len; i += 1) {
+      const int64_t val = bin_get_int(r);
+      if (r->error || !bin_grow(r, &data, &cap, (i + 1) * esize, size)) {
+        break;
+      }
+      if (kind == A_I64) {
+        ((int64_t*)data)[i] = val;
+      } else {
+        ((int32_t*)data)[i] = (int32_t)val;
+      }
+    }
+  }
+  if (r->error) {
+    free(data);
+    return NULL;
+  }
+  /*
+   * Build the array.
+   */
+  atom_t R = lisp_make_array(lisp, (array_kind_t)kind, len);
+  if (!IS_ARRY(R)) {
+    X(lisp, R);
+    free(data);
+    r->error = true;
+    return NULL;
+  }
+  if (size > 0) {
+    memcpy(ARRAY_DATA(R), data, size);
+  }
+  free(data);
+  return R;
+}
+
+static atom_t
+bin_read_buffer(const lisp_t lisp, bin_reader_t* const r)
+{
+  const uint64_t len = bin_get_uint(r);
+  if (r->error || len > BUFFER_MAX_SIZE) {
+    r->error = true;
+    return NULL;
+  }
+  atom_t R = lisp_make_buffer(lisp, 0);
+  if (!IS_BUFF(R)) {
+    X(lisp, R);
+    r->error = true;
+    return NULL;
+  }
+  /*
+   * Read the content in bounded steps, the buffer growing as data arrives.
+   */
+  for (size_t off = 0; off < len;) {
+    const size_t n =
+      len - off < BIN_DEFAULT_SIZE ? len - off : BIN_DEFAULT_SIZE;
+    char* p = lisp_buffer_reserve(R, n);
+    if (p == NULL || !bin_get_data(r, p, n)) {
+      X(lisp, R);
+      r->error = true;
+      return NULL;
+    }
+    lisp_buffer_commit(R, n);
+    off += n;
+  }
+  return R;
+}
+
+static atom_t
+bin_read_rope(const lisp_t lisp, bin_reader_t* const r)
+{
+  atom_t buf = bin_read_buffer(lisp, r);
+  if (buf == NULL) {
+    return NULL;
+  }
+  atom_t R = lisp_make_rope(lisp);
+  if (!IS_ROPE(R) || !lisp_rope_push(lisp, R, buf)) {
+    X(lisp, buf, R);
+    r->error = true;
+    return NULL;
+  }
+  X(lisp, buf);
+  return R;
+}
+
+/*
+ * Records use the descriptor of the local definition of their type when it
+ * matches, so that its constructor, predicate and accessors apply.
+ */
+
+static atom_t
+bin_record_desc(const lisp_t lisp, const atom_t desc)
+{
+  if (!IS_PAIR(desc) || !IS_SYMB(CAR(desc))) {
+    return desc;
+  }
+  atom_t res = desc;
+  atom_t elt = lisp_tree_get(lisp, lisp->globals, &CAR(desc)->symbol);
+  /*
+   * The constructor is (ARGS ((TYPE . DESC)) . ADDRESS).
+   */
+  if (IS_PAIR(elt) && IS_PAIR(CDR(elt)) && IS_PAIR(CDR(CDR(elt)))) {
+    atom_t dscl = CAR(CDR(CDR(elt)));
+    if (IS_PAIR(dscl) && IS_PAIR(CAR(dscl)) && IS_SYMB(CAR(CAR(dscl))) &&
+        lisp_symbol_equal(CAR(CAR(dscl)), "TYPE") &&
+        lisp_equ(CDR(CAR(dscl)), desc)) {
+      res = UP(CDR(CAR(dscl)));
+      X(lisp, desc);
+    }
+  }
+  X(lisp, elt);
+  return res;
+}
+
+static atom_t
+bin_read_record(const lisp_t lisp, bin_reader_t* const r)
+{
+  atom_t desc = bin_read_value(lisp, r);
+  if (desc == NULL) {
+    return NULL;
+  }
+  const uint64_t count = bin_get_uint(r);
+  if (r->error || count > RECORD_MAX_LEN) {
+    X(lisp, desc);
+    r->error = true;
+    return NULL;
+  }
+  atom_t R = lisp_make_record(lisp, bin_record_desc(lisp, desc), count);
+  if (!IS_RECD(R)) {
+    X(lisp, R);
+    r->error = true;
+    return NULL;
+  }
+  /*
+   * Read the fields. On error, release the fields read so far.
+   */
+  for (uint64_t i = 0; i < count; i += 1) {
+    atom_t fld = bin_read_value(lisp, r);
+    if (fld == NULL) {
+      RECORD_LEN(R) = i;
+      X(lisp, R);
+      r->error = true;
+      return NULL;
+    }
+    RECORD_FIELD(R, i) = fld;
+  }
+  return R;
+}
+
+static atom_t
+bin_read_value(const lisp_t lisp, bin_reader_t* const r)
+{
+  const uint8_t tag = bin_get_byte(r);
+  atom_t R = NULL;
+  if (r->error) {
+    return NULL;
+  }
+  /*
+   * Read the value.
+   */
+  switch (tag & ~(B_SHARED | B_TAIL_CALL)) {
+    case B_NIL:
+      R = lisp_make_nil(lisp);
+      break;
+    case B_TRUE:
+      R = lisp_make_true(lisp);
+      break;
+    case B_WILDCARD:
+      R = lisp_make_wildcard(lisp);
+      break;
+    case B_CHAR: {
+      const uint8_t c = bin_get_byte(r);
+      R = r->error ? NULL : lisp_make_char(lisp, (char)c);
+      break;
+    }
+    case B_NUMBER: {
+      const int64_t n = bin_get_int(r);
+      R = r->error ? NULL : lisp_make_number(lisp, n);
+      break;
+    }
+    case B_SYMBOL:
+      R = bin_read_symbol(lisp, r);
+      break;
+    case B_SYMREF: {
+      const uint64_t idx = bin_get_uint(r);
+      if (!r->error && idx < r->nsyms) {
+        R = UP(r->syms[idx]);
+      }
+      break;
+    }
+    case B_LIST:
+      R = bin_read_list(lisp, r);
+      break;
+    case B_STRING:
+      R = bin_read_string(lisp, r);
+      break;
+    case B_BUFFER:
+      R = bin_read_buffer(lisp, r);
+      break;
+    case B_ARRAY:
+      R = bin_read_array(lisp, r);
+      break;
+    case B_BIGNUM: {
+      size_t len;
+      char* data = bin_get_chunk(r, &len);
+      if (data != NULL) {
+        R = lisp_make_bignum(lisp, data, len);
+        free(data);
+      }
+      break;
+    }
+    case B_ROPE:
+      R = bin_read_rope(lisp, r);
+      break;
+    case B_RECORD:
+      R = bin_read_record(lisp, r);
+      break;
+    case B_REF: {
+      const uint64_t idx = bin_get_uint(r);
+      if (!r->error && idx < r->nobjs) {
+        R = UP(r->objs[idx]);
+      }
+      break;
+    }
+    case B_NATIVE: {
+      const uint64_t idx = bin_get_uint(r);
+      const uint64_t off = bin_get_uint(r);
+      if (!r->error && r->mods != NULL && idx < r->mods->count) {
+        R = lisp_make_number(lisp, (int64_t)(r->mods->bases[idx] + off));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  /*
+   * Symbols in tail position are not shared with the other occurences.
+   */
+  if (R != NULL && (tag & B_TAIL_CALL) != 0) {
+    if (!IS_SYMB(R)) {
+      X(lisp, R);
+      r->error = true;
+      return NULL;
+    }
+    atom_t sym = lisp_make_symbol(lisp, &R->symbol);
+    SET_TAIL_CALL(sym);
+    X(lisp, R);
+    R = sym;
+  }
+  /*
+   * Register shared values. The table does not hold references.
+   */
+  if (R != NULL && (tag & B_SHARED) != 0 &&
+      !bin_push(&r->objs, &r->nobjs, &r->cobjs, R)) {
+    X(lisp, R);
+    R = NULL;
+  }
+  if (R == NULL) {
+    r->error = true;
+  }
+  return R;
+}
+
+atom_t
+lisp_bin_read(const lisp_t lisp, FILE* const handle)
+{
+  return lisp_bin_read_with(lisp, handle, NULL);
+}
+
+atom_t
+lisp_bin_read_with(const lisp_t lisp, FILE* const handle,
+                   const bin_modules_t* const mods)
+{
+  bin_reader_t r = { .handle = handle, .error = false, .mods = mods };
+  /*
+   * Check the magic byte.
+   */
+  const int c = getc_unlocked(handle);
+  if (c == EOF) {
+    return NULL;
+  }
+  if (c != BIN_MAGIC) {
+    ERROR("Invalid binary message");
+    return NULL;
+  }
+  /*
+   * Read the value.
+   */
+  atom_t res = bin_read_value(lisp, &r);
+  if (res == NULL) {
+    ERROR("Truncated or invalid binary message");
+  }
+  /*
+   * Clean-up.
+   */
+  for (size_t i = 0; i < r.nsyms; i += 1) {
+    X(lisp, r.syms[i]);
+  }
+  free(r.syms);
+  free(r.objs);
+  return res;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
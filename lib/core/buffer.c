@@ -0,0 +1,203 @@
+#include <mnml/buffer.h>
+#include <mnml/debug.h>
+#include <mnml/lisp.h>
+#include <mnml/slab.h>
+#include <mnml/store.h>
+#include <string.h>
+
+/*
+ * Buffer allocation.
+ */
+
+static atom_t
+lisp_make_buffer_with(const lisp_t lisp, const store_t store,
+                      const size_t off, const size_t len)
+{
+  atom_t R = lisp_allocate(lisp);
+  R->type = T_BUFFER;
+  R->flags = 0;
+  R->refs = 1;
+  R->buffer.store = store;
+  R->buffer.offset = off;
+  R->buffer.length = len;
+  TRACE_MAKE_SEXP(R);
+  return R;
+}
+
+atom_t
+lisp_make_buffer(const lisp_t lisp, const size_t size)
+{
+  /*
+   * Check the size of the buffer.
+   */
+  if (size > BUFFER_MAX_SIZE) {
+    ERROR("Buffer size too large: %lu", size);
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Allocate the store.
+   */
+  store_t store = lisp_store_new(size == 0 ? BUFFER_DEFAULT_SIZE : size, A_U8);
+  if (store == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Build the buffer.
+   */
+  return lisp_make_buffer_with(lisp, store, 0, 0);
+}
+
+atom_t
+lisp_make_buffer_from(const lisp_t lisp, const char* const data,
+                      const size_t len)
+{
+  atom_t R = lisp_make_buffer(lisp, len);
+  if (IS_BUFF(R)) {
+    memcpy(R->buffer.store->data, data, len);
+    R->buffer.length = len;
+  }
+  return R;
+}
+
+atom_t
+lisp_buffer_slice(const lisp_t lisp, const atom_t cell, const size_t off,
+                  const size_t len)
+{
+  /*
+   * Check the boundaries.
+   */
+  if (off > BUFFER_LEN(cell) || len > BUFFER_LEN(cell) - off) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Share the store.
+   */
+  store_t store = cell->buffer.store;
+  store->refs += 1;
+  return lisp_make_buffer_with(lisp, store, cell->buffer.offset + off, len);
+}
+
+void
+lisp_buffer_release(const atom_t cell)
+{
+  lisp_store_release(cell->buffer.store);
+}
+
+/*
+ * Buffer operations.
+ */
+
+char*
+lisp_buffer_reserve(const atom_t cell, const size_t len)
+{
+  store_t store = cell->buffer.store;
+  const size_t off = cell->buffer.offset;
+  const size_t cur = cell->buffer.length;
+  /*
+   * Check the final size of the buffer.
+   */
+  if (len > BUFFER_MAX_SIZE - cur) {
+    ERROR("Buffer size too large: %lu", cur + len);
+    return NULL;
+  }
+  /*
+   * Use the store in place if it is not shared and has room.
+   */
+  if (store->refs == 1 && off + cur + len <= store->size) {
+    return store->data + off + cur;
+  }
+  /*
+   * Compact the store in place if that's enough.
+   */
+  if (store->refs == 1 && cur + len <= store->size) {
+    memmove(store->data, store->data + off, cur);
+    cell->buffer.offset = 0;
+    return store->data + cur;
+  }
+  /*
+   * Otherwise, allocate a new store that's at least twice the size.
+   */
+  size_t size = store->size << 1;
+  if (size < cur + len) {
+    size = cur + len;
+  }
+  if (size > BUFFER_MAX_SIZE) {
+    size = BUFFER_MAX_SIZE;
+  }
+  store_t next = lisp_store_dup(store, off, cur, size);
+  if (next == NULL) {
+    return NULL;
+  }
+  lisp_store_release(store);
+  /*
+   * Update the buffer.
+   */
+  cell->buffer.store = next;
+  cell->buffer.offset = 0;
+  return next->data + cur;
+}
+
+void
+lisp_buffer_commit(const atom_t cell, const size_t len)
+{
+  cell->buffer.length += len;
+}
+
+bool
+lisp_buffer_append(const atom_t cell, const char* const data,
+                   const size_t len)
+{
+  char* p = lisp_buffer_reserve(cell, len);
+  if (p == NULL) {
+    return false;
+  }
+  memcpy(p, data, len);
+  lisp_buffer_commit(cell, len);
+  return true;
+}
+
+void
+lisp_buffer_consume(const atom_t cell, const size_t len)
+{
+  const size_t n = len < BUFFER_LEN(cell) ? len : BUFFER_LEN(cell);
+  cell->buffer.offset += n;
+  cell->buffer.length -= n;
+}
+
+ssize_t
+lisp_buffer_find(const atom_t cell, const char* const needle, const size_t len)
+{
+  const char* data = BUFFER_DATA(cell);
+  const char* res = NULL;
+  /*
+   * Look for a single character.
+   */
+  if (len == 1) {
+    res = memchr(data, *needle, BUFFER_LEN(cell));
+  }
+  /*
+   * Look for a sequence of characters.
+   */
+  else {
+    res = memmem(data, BUFFER_LEN(cell), needle, len);
+  }
+  /*
+   * Return the offset.
+   */
+  return res == NULL ? -1 : res - data;
+}
+
+atom_t
+lisp_buffer_to_string(const lisp_t lisp, const atom_t cell)
+{
+  const char* data = BUFFER_DATA(cell);
+  const size_t len = BUFFER_LEN(cell);
+  atom_t res = lisp_make_nil(lisp);
+  for (size_t i = 0; i < len; i += 1) {
+    atom_t c = lisp_make_char(lisp, data[len - i - 1]);
+    res = lisp_cons(lisp, c, res);
+  }
+  return res;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -1,3 +1,4 @@
+#include <mnml/bignum.h>
 #include <mnml/debug.h>
 #include <mnml/lisp.h>
 #include <mnml/utils.h>
@@ -151,6 +152,27 @@ lisp_debug_atom(FILE* const fp, const atom_t atom, const bool alter,
     case T_WILDCARD:
       fprintf(fp, "_");
       break;
+    case T_BUFFER:
+      fprintf(fp, "#<buffer:%u>", atom->buffer.length);
+      break;
+    case T_ARRAY:
+      fprintf(fp, "#<array:%u>", atom->array.length);
+      break;
+    case T_ROPE:
+      fprintf(fp, "#<rope:%lu>", (size_t)atom->rope.count);
+      break;
+    case T_RECORD: {
+      char bsym[17] = { 0 };
+      strncpy(bsym, CAR(atom->record->desc)->symbol.val, LISP_SYMBOL_LENGTH);
+      fprintf(fp, "#<%s:%lu>", bsym, atom->record->count);
+      break;
+    }
+    case T_BIGNUM: {
+      char* str = lisp_bignum_to_cstring(atom);
+      fprintf(fp, "%s", str != NULL ? str : "#<bignum>");
+      free(str);
+      break;
+    }
     default:
       TRACE("Unknown-type error");
       abort();
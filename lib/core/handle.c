@@ -0,0 +1,169 @@
+#include <mnml/debug.h>
+#include <mnml/handle.h>
+#include <stdlib.h>
+
+/*
+ * The state of a slot holds the number of references in its lower 32 bits,
+ * whether it is open in bit 32, and its generation in the upper bits. A handle
+ * holds the generation in its upper 32 bits and the index in its lower 32 bits.
+ * Generations start at 1, so handles are never 0.
+ */
+
+#define STATE_OPEN ((uint64_t)1 << 32)
+#define STATE_REFS(__s) ((__s) & UINT32_MAX)
+#define STATE_GEN(__s) ((__s) >> 33)
+#define STATE_MAKE(__g) ((uint64_t)(__g) << 33)
+
+#define GEN_MAX (((uint64_t)1 << 31) - 1)
+#define INDEX_MAX ((size_t)HANDLE_PAGE_LEN * HANDLE_PAGE_COUNT)
+
+static handle_slot_t*
+lisp_handle_slot(handle_table_t* const table, const atom_t H,
+                 uint64_t* const gen, size_t* const idx)
+{
+  if (!IS_NUMB(H) || H->number <= 0) {
+    return NULL;
+  }
+  *gen = (uint64_t)H->number >> 32;
+  *idx = (size_t)(H->number & UINT32_MAX);
+  if (*idx >= INDEX_MAX) {
+    return NULL;
+  }
+  handle_slot_t* const page =
+    __atomic_load_n(&table->pages[*idx / HANDLE_PAGE_LEN], __ATOMIC_ACQUIRE);
+  return page == NULL ? NULL : &page[*idx % HANDLE_PAGE_LEN];
+}
+
+static void
+lisp_handle_release(handle_table_t* const table, handle_slot_t* const slot,
+                    const size_t idx)
+{
+  const uint64_t s = __atomic_sub_fetch(&slot->state, 1, __ATOMIC_ACQ_REL);
+  if (STATE_REFS(s) > 0) {
+    return;
+  }
+  /*
+   * The handle is closed and no longer referenced: nobody can acquire it
+   * anymore, so delete the object and recycle the slot with a new generation.
+   */
+  table->del(slot->ptr);
+  const uint64_t gen = STATE_GEN(s) == GEN_MAX ? 1 : STATE_GEN(s) + 1;
+  pthread_mutex_lock(&table->lock);
+  slot->ptr = NULL;
+  slot->next = table->free;
+  table->free = idx;
+  __atomic_store_n(&slot->state, STATE_MAKE(gen), __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&table->lock);
+}
+
+int64_t
+lisp_handle_new(handle_table_t* const table, void* const ptr)
+{
+  pthread_mutex_lock(&table->lock);
+  /*
+   * Grab a free slot or the next unused one.
+   */
+  size_t idx = table->free;
+  handle_slot_t* slot;
+  if (idx != SIZE_MAX) {
+    slot = &table->pages[idx / HANDLE_PAGE_LEN][idx % HANDLE_PAGE_LEN];
+    table->free = slot->next;
+  } else {
+    if (table->count == INDEX_MAX) {
+      pthread_mutex_unlock(&table->lock);
+      ERROR("Handle table is full");
+      return -1;
+    }
+    idx = table->count;
+    handle_slot_t* page = table->pages[idx / HANDLE_PAGE_LEN];
+    if (page == NULL) {
+      page = (handle_slot_t*)calloc(HANDLE_PAGE_LEN, sizeof(handle_slot_t));
+      if (page == NULL) {
+        pthread_mutex_unlock(&table->lock);
+        ERROR("Cannot allocate handle page");
+        return -1;
+      }
+      __atomic_store_n(&table->pages[idx / HANDLE_PAGE_LEN], page,
+                       __ATOMIC_RELEASE);
+    }
+    slot = &page[idx % HANDLE_PAGE_LEN];
+    table->count += 1;
+  }
+  /*
+   * Publish the object. The table holds the first reference.
+   */
+  const uint64_t state = __atomic_load_n(&slot->state, __ATOMIC_RELAXED);
+  const uint64_t gen = STATE_GEN(state) == 0 ? 1 : STATE_GEN(state);
+  slot->ptr = ptr;
+  __atomic_store_n(&slot->state, STATE_MAKE(gen) | STATE_OPEN | 1,
+                   __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&table->lock);
+  return (int64_t)((gen << 32) | idx);
+}
+
+void*
+lisp_handle_get(handle_table_t* const table, const atom_t H)
+{
+  uint64_t gen;
+  size_t idx;
+  handle_slot_t* const slot = lisp_handle_slot(table, H, &gen, &idx);
+  if (slot == NULL) {
+    return NULL;
+  }
+  uint64_t s = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+  do {
+    if (STATE_GEN(s) != gen || !(s & STATE_OPEN)) {
+      return NULL;
+    }
+  } while (!__atomic_compare_exchange_n(&slot->state, &s, s + 1, true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE));
+  return slot->ptr;
+}
+
+void
+lisp_handle_put(handle_table_t* const table, const atom_t H)
+{
+  uint64_t gen;
+  size_t idx;
+  handle_slot_t* const slot = lisp_handle_slot(table, H, &gen, &idx);
+  if (slot != NULL) {
+    lisp_handle_release(table, slot, idx);
+  }
+}
+
+bool
+lisp_handle_close(handle_table_t* const table, const atom_t H)
+{
+  uint64_t gen;
+  size_t idx;
+  handle_slot_t* const slot = lisp_handle_slot(table, H, &gen, &idx);
+  if (slot == NULL) {
+    return false;
+  }
+  uint64_t s = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+  do {
+    if (STATE_GEN(s) != gen || !(s & STATE_OPEN)) {
+      return false;
+    }
+  } while (!__atomic_compare_exchange_n(&slot->state, &s, s & ~STATE_OPEN,
+                                        true, __ATOMIC_ACQ_REL,
+                                        __ATOMIC_ACQUIRE));
+  /*
+   * Drop the reference of the table.
+   */
+  lisp_handle_release(table, slot, idx);
+  return true;
+}
+
+void
+lisp_handle_fini(handle_table_t* const table)
+{
+  for (size_t i = 0; i < HANDLE_PAGE_COUNT; i += 1) {
+    free(table->pages[i]);
+    table->pages[i] = NULL;
+  }
+  table->count = 0;
+  table->free = SIZE_MAX;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,247 @@
+#include <mnml/binary.h>
+#include <mnml/debug.h>
+#include <mnml/image.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/tree.h>
+#include <mnml/utils.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+/*
+ * An image is made of two binary messages. The first one lists the modules as
+ * (NAME . STAMP) pairs, where STAMP is the modification time of the library.
+ * The second one lists the global bindings. The modules are opened before the
+ * bindings are read so that the addresses of their functions are relocated.
+ */
+
+typedef struct image_modules
+{
+  builder_t list;
+  size_t count;
+  size_t cap;
+  uintptr_t* bases;
+  bool error;
+} image_modules_t;
+
+static bool
+image_module_info(void* const handle, uintptr_t* const base,
+                  int64_t* const stamp)
+{
+  Dl_info info;
+  struct stat st;
+  void* sym = dlsym(handle, "lisp_module_entries");
+  if (sym == NULL || dladdr(sym, &info) == 0 || info.dli_fname == NULL ||
+      stat(info.dli_fname, &st) != 0) {
+    return false;
+  }
+  *base = (uintptr_t)info.dli_fbase;
+  *stamp = (int64_t)st.st_mtime;
+  return true;
+}
+
+static bool
+image_modules_push(image_modules_t* const mods, const uintptr_t base)
+{
+  if (mods->count == mods->cap) {
+    const size_t cap = mods->cap == 0 ? 16 : mods->cap << 1;
+    const size_t len = cap * sizeof(uintptr_t);
+    uintptr_t* bases = (uintptr_t*)realloc(mods->bases, len);
+    if (bases == NULL) {
+      return false;
+    }
+    mods->bases = bases;
+    mods->cap = cap;
+  }
+  mods->bases[mods->count] = base;
+  mods->count += 1;
+  return true;
+}
+
+/*
+ * Dump.
+ */
+
+static void
+image_collect_modules(const lisp_t lisp, image_modules_t* const mods,
+                      const atom_t node)
+{
+  if (IS_NULL(node) || mods->error) {
+    return;
+  }
+  image_collect_modules(lisp, mods, LEFT(node));
+  /*
+   * Register the module.
+   */
+  uintptr_t base;
+  int64_t stamp;
+  if (!image_module_info((void*)VALUE(node)->number, &base, &stamp) ||
+      !image_modules_push(mods, base)) {
+    ERROR("Cannot register module %.16s", KEY(node)->symbol.val);
+    mods->error = true;
+    return;
+  }
+  atom_t val = lisp_make_number(lisp, stamp);
+  atom_t elt = lisp_cons(lisp, UP(KEY(node)), val);
+  lisp_builder_push(lisp, &mods->list, elt);
+  /*
+   */
+  image_collect_modules(lisp, mods, RIGHT(node));
+}
+
+static void
+image_collect_globals(const lisp_t lisp, builder_t* const bld,
+                      const atom_t node, const bool full)
+{
+  if (IS_NULL(node)) {
+    return;
+  }
+  image_collect_globals(lisp, bld, LEFT(node), full);
+  /*
+   * Skip the variables that depend on the process.
+   */
+  atom_t key = KEY(node);
+  if (full ||
+      (!lisp_symbol_equal(key, "ARGV") && !lisp_symbol_equal(key, "CONFIG") &&
+       !lisp_symbol_equal(key, "ENV"))) {
+    lisp_builder_push(lisp, bld, UP(DATA(node)));
+  }
+  /*
+   */
+  image_collect_globals(lisp, bld, RIGHT(node), full);
+}
+
+bool
+lisp_image_write(const lisp_t lisp, FILE* const handle, const bool full)
+{
+  image_modules_t mods = { .count = 0, .cap = 0, .bases = NULL };
+  builder_t glbs;
+  /*
+   * Collect the modules and the global bindings.
+   */
+  lisp_builder_init(lisp, &mods.list);
+  lisp_builder_init(lisp, &glbs);
+  image_collect_modules(lisp, &mods, lisp->modules);
+  image_collect_globals(lisp, &glbs, lisp->globals, full);
+  /*
+   * Write the image.
+   */
+  bool res = false;
+  if (!mods.error) {
+    const bin_modules_t tab = { .count = mods.count, .bases = mods.bases };
+    res = lisp_bin_write(lisp, handle, mods.list.head) &&
+          lisp_bin_write_with(lisp, handle, glbs.head, &tab);
+  }
+  /*
+   * Clean-up.
+   */
+  X(lisp, mods.list.head, glbs.head);
+  free(mods.bases);
+  return res;
+}
+
+bool
+lisp_image_dump(const lisp_t lisp, const char* const path)
+{
+  FILE* handle = fopen(path, "wb");
+  if (handle == NULL) {
+    ERROR("Cannot open %s: %s", path, strerror(errno));
+    return false;
+  }
+  bool res = lisp_image_write(lisp, handle, false);
+  return fclose(handle) == 0 && res;
+}
+
+/*
+ * Load.
+ */
+
+static bool
+image_open_modules(const lisp_t lisp, image_modules_t* const mods,
+                   const atom_t list)
+{
+  FOREACH(list, p)
+  {
+    atom_t elt = p->car;
+    if (!IS_PAIR(elt) || !IS_SYMB(CAR(elt)) || !IS_NUMB(CDR(elt))) {
+      ERROR("Invalid module entry in image");
+      return false;
+    }
+    /*
+     * Open the module and check that it has not changed.
+     */
+    uintptr_t base;
+    int64_t stamp;
+    void* handle = module_open(lisp, CAR(elt));
+    if (handle == NULL || !image_module_info(handle, &base, &stamp)) {
+      ERROR("Cannot open module %.16s", CAR(elt)->symbol.val);
+      return false;
+    }
+    if (stamp != CDR(elt)->number) {
+      ERROR("Module %.16s is newer than the image", CAR(elt)->symbol.val);
+      return false;
+    }
+    if (!image_modules_push(mods, base)) {
+      return false;
+    }
+    NEXT(p);
+  }
+  return true;
+}
+
+bool
+lisp_image_read(const lisp_t lisp, FILE* const handle)
+{
+  /*
+   * Read the module list and open the modules.
+   */
+  image_modules_t mods = { .count = 0, .cap = 0, .bases = NULL };
+  atom_t list = lisp_bin_read(lisp, handle);
+  if (list == NULL || !IS_LIST(list) ||
+      !image_open_modules(lisp, &mods, list)) {
+    if (list != NULL) {
+      X(lisp, list);
+    }
+    free(mods.bases);
+    return false;
+  }
+  X(lisp, list);
+  /*
+   * Read the bindings and restore them.
+   */
+  const bin_modules_t tab = { .count = mods.count, .bases = mods.bases };
+  atom_t glbs = lisp_bin_read_with(lisp, handle, &tab);
+  free(mods.bases);
+  if (glbs == NULL) {
+    return false;
+  }
+  if (!IS_LIST(glbs)) {
+    X(lisp, glbs);
+    return false;
+  }
+  FOREACH(glbs, p)
+  {
+    lisp->globals = lisp_setq(lisp, lisp->globals, UP(p->car));
+    NEXT(p);
+  }
+  X(lisp, glbs);
+  return true;
+}
+
+bool
+lisp_image_load(const lisp_t lisp, const char* const path)
+{
+  FILE* handle = fopen(path, "rb");
+  if (handle == NULL) {
+    ERROR("Cannot open %s: %s", path, strerror(errno));
+    return false;
+  }
+  const bool res = lisp_image_read(lisp, handle);
+  fclose(handle);
+  return res;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
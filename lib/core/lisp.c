@@ -1,8 +1,15 @@
+#include <mnml/array.h>
+#include <mnml/bignum.h>
+#include <mnml/buffer.h>
 #include <mnml/debug.h>
 #include <mnml/lisp.h>
+#include <mnml/record.h>
+#include <mnml/rope.h>
 #include <mnml/slab.h>
 #include <mnml/tree.h>
 #include <mnml/utils.h>
+#include <errno.h>
+#include <poll.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -17,8 +24,12 @@ lisp_new(const slab_t slab)
   lisp_t lisp = (lisp_t)malloc(sizeof(struct lisp));
   lisp->slab = slab;
   lisp->globals = lisp_make_nil(lisp);
-  lisp->ichan = lisp_make_nil(lisp);
-  lisp->ochan = lisp_make_nil(lisp);
+  lisp->ichan = (io_stack_t){ .release = lisp_read_release };
+  lisp->ochan = (io_stack_t){ .release = lisp_write_release };
+  lisp->parse_error_handler = NULL;
+  lisp->syntax_error_handler = NULL;
+  lisp->wait_handler = NULL;
+  lisp->scheduler = NULL;
   lisp->lrefs = 0;
   lisp->crefs = 0;
   lisp->grefs = 0;
@@ -31,12 +42,117 @@ lisp_delete(lisp_t lisp)
 {
   TRACE("R %ld %ld %ld %ld", lisp->lrefs, lisp->crefs, lisp->grefs,
         lisp->total);
-  X(lisp, lisp->ochan);
-  X(lisp, lisp->ichan);
+  /*
+   * Pop the remaining contexts and free the states kept in the slots.
+   */
+  io_stack_t* chans[2] = { &lisp->ichan, &lisp->ochan };
+  for (size_t i = 0; i < 2; i += 1) {
+    while (!IO_CONTEXT_EMPTY(*chans[i])) {
+      lisp_chan_pop(lisp, chans[i]);
+    }
+    for (size_t j = 0; j < chans[i]->cap; j += 1) {
+      free(chans[i]->slots[j].state);
+    }
+    free(chans[i]->slots);
+  }
+  /*
+   */
   X(lisp, lisp->globals);
   free(lisp);
 }
 
+/*
+ * IO context functions.
+ */
+
+bool
+lisp_chan_push(const lisp_t lisp, io_stack_t* const chan, FILE* const handle,
+               const char* const pwd)
+{
+  /*
+   * Grow the stack if it is full. The new slots have no state.
+   */
+  if (chan->depth == chan->cap) {
+    const size_t cap = chan->cap == 0 ? 8 : chan->cap << 1;
+    const size_t len = cap * sizeof(struct io_context);
+    io_context_t slots = (io_context_t)realloc(chan->slots, len);
+    if (slots == NULL) {
+      ERROR("Cannot grow the IO context stack to %lu entries", cap);
+      return false;
+    }
+    for (size_t i = chan->cap; i < cap; i += 1) {
+      slots[i].state = NULL;
+    }
+    chan->slots = slots;
+    chan->cap = cap;
+  }
+  /*
+   * Fill the context. The state of the slot is reset by its owner.
+   */
+  io_context_t ctx = &chan->slots[chan->depth];
+  ctx->handle = handle;
+  ctx->fd = fileno(handle);
+  ctx->values = lisp_make_nil(lisp);
+  strncpy(ctx->pwd, pwd, PATH_MAX - 1);
+  ctx->pwd[PATH_MAX - 1] = '\0';
+  chan->depth += 1;
+  TRACE_CHAN("push fd=%d pwd=%s depth=%lu", ctx->fd, ctx->pwd, chan->depth);
+  return true;
+}
+
+void
+lisp_chan_pop(const lisp_t lisp, io_stack_t* const chan)
+{
+  io_context_t ctx = IO_CONTEXT(*chan);
+  TRACE_CHAN("pop fd=%d pwd=%s depth=%lu", ctx->fd, ctx->pwd, chan->depth);
+  chan->release(ctx);
+  X(lisp, ctx->values);
+  chan->depth -= 1;
+}
+
+/*
+ * Wait functions.
+ */
+
+bool
+lisp_wait(const lisp_t lisp, const int fd, const short events)
+{
+  if (lisp->wait_handler != NULL) {
+    return lisp->wait_handler(lisp, fd, events);
+  }
+  struct pollfd pfd = { .fd = fd, .events = events };
+  int res;
+  do {
+    res = poll(&pfd, 1, -1);
+  } while (res < 0 && errno == EINTR);
+  return res > 0;
+}
+
+/*
+ * Check if HANDLE has buffered input. Where the buffer of a FILE cannot be
+ * inspected, assume that it has some so that the read blocks instead.
+ */
+
+static bool
+lisp_wait_buffered(FILE* const handle)
+{
+#if defined(__GLIBC__)
+  return handle->_IO_read_ptr < handle->_IO_read_end;
+#elif defined(__APPLE__) || defined(__FreeBSD__)
+  return handle->_r > 0;
+#else
+  return true;
+#endif
+}
+
+void
+lisp_wait_input(const lisp_t lisp, FILE* const handle)
+{
+  if (lisp->wait_handler != NULL && !lisp_wait_buffered(handle)) {
+    lisp->wait_handler(lisp, fileno(handle), POLLIN);
+  }
+}
+
 /*
  * Allocation functions.
  */
@@ -55,10 +171,61 @@ lisp_deallocate(const lisp_t lisp, const atom_t atom)
    * Most likely this is a pair.
    */
   if (likely(IS_PAIR(atom))) {
-    if (likely(!IS_WEAKREF(atom))) {
-      X(lisp, CAR(atom));
+    atom_t p = atom;
+    /*
+     * Release the spine of the list in a loop so that long lists don't exhaust
+     * the stack.
+     */
+    for (;;) {
+      atom_t next = CDR(p);
+      if (likely(!IS_WEAKREF(p))) {
+        X(lisp, CAR(p));
+      }
+      slab_deallocate(lisp->slab, p);
+      DOWN(next);
+      if (next->refs != 0) {
+        break;
+      }
+      if (!IS_PAIR(next)) {
+        lisp_deallocate(lisp, next);
+        break;
+      }
+      p = next;
     }
-    X(lisp, CDR(atom));
+  }
+  /*
+   * Release the store of buffers.
+   */
+  else if (IS_BUFF(atom)) {
+    lisp_buffer_release(atom);
+    slab_deallocate(lisp->slab, atom);
+  }
+  /*
+   * Release the store of arrays.
+   */
+  else if (IS_ARRY(atom)) {
+    lisp_array_release(atom);
+    slab_deallocate(lisp->slab, atom);
+  }
+  /*
+   * Release the limbs of big integers.
+   */
+  else if (IS_BIGN(atom)) {
+    lisp_bignum_release(atom);
+    slab_deallocate(lisp->slab, atom);
+  }
+  /*
+   * Release the chunks of ropes.
+   */
+  else if (IS_ROPE(atom)) {
+    lisp_rope_release(lisp, atom);
+    slab_deallocate(lisp->slab, atom);
+  }
+  /*
+   * Release the fields of records.
+   */
+  else if (IS_RECD(atom)) {
+    lisp_record_release(lisp, atom);
     slab_deallocate(lisp->slab, atom);
   }
   /*
@@ -173,6 +340,13 @@ lisp_bind(const lisp_t lisp, const atom_t closure, const atom_t arg,
    */
   switch (arg->type) {
     case T_PAIR: {
+      /*
+       * Records are deconstructed as (NAME FIELD ...).
+       */
+      if (IS_RECD(val)) {
+        ret = lisp_record_bind(lisp, closure, arg, val);
+        break;
+      }
       /*
        * Grab CARs and CDR, and clean-up.
        */
@@ -23,66 +23,55 @@
     }                     \
   } while (0)
 
-static const char*
-lisp_library_prefix()
+static void
+lisp_library_prefix(char* const buffer)
 {
-  static bool is_set = false;
-  static char buffer[PATH_MAX];
-  if (!is_set) {
-    const char* prefix = lisp_prefix();
-    strcpy(buffer, prefix);
-    strcat(buffer, "/lib/mnml");
-    is_set = true;
-  }
-  return buffer;
+  strcpy(buffer, lisp_prefix());
+  strcat(buffer, "/lib/mnml");
 }
 
-static const char*
-lisp_usercache_prefix()
+static void
+lisp_usercache_prefix(char* const buffer)
 {
-  static bool is_set = false;
-  static char buffer[PATH_MAX];
-  if (!is_set) {
-    strcpy(buffer, getenv("HOME"));
-    strcat(buffer, "/.mnml");
-    is_set = true;
-  }
-  return buffer;
+  strcpy(buffer, getenv("HOME"));
+  strcat(buffer, "/.mnml");
 }
 
 static char*
 module_paths()
 {
-  static bool is_set = false;
-  static char buffer[8192];
+  char prefix[PATH_MAX];
+  const char* const user = getenv("MNML_MODULE_PATH");
   /*
-   * Prepare the path if not set.
+   * Allocate the path list.
    */
-  if (!is_set) {
-    /*
-     * Set the system prefix first.
-     */
-    strcpy(buffer, lisp_library_prefix());
-    /*
-     * Then, append the user cache path.
-     */
+  const size_t len = 2 * PATH_MAX + (user != NULL ? strlen(user) + 1 : 0);
+  char* const buffer = (char*)malloc(len);
+  if (buffer == NULL) {
+    return NULL;
+  }
+  /*
+   * Set the system prefix first.
+   */
+  lisp_library_prefix(prefix);
+  strcpy(buffer, prefix);
+  /*
+   * Then, append the user cache path.
+   */
+  lisp_usercache_prefix(prefix);
+  strcat(buffer, ":");
+  strcat(buffer, prefix);
+  /*
+   * Append the user-defined variable.
+   */
+  if (user != NULL) {
     strcat(buffer, ":");
-    strcat(buffer, lisp_usercache_prefix());
-    /*
-     * Append the user-defined variable.
-     */
-    if (getenv("MNML_MODULE_PATH") != NULL) {
-      strcat(buffer, ":");
-      strcat(buffer, getenv("MNML_MODULE_PATH"));
-    }
-    /*
-     */
-    is_set = true;
+    strcat(buffer, user);
   }
   /*
    * Return the paths.
    */
-  return strdup(buffer);
+  return buffer;
 }
 
 /*
@@ -109,8 +98,8 @@ module_find_at_path(const char* const dirpath, const char* const name,
   /* LIB NAME .DYLIB\0 = 3 + STRLEN(NAME) + 7 */
   const size_t lib_name_len = strlen(name) + 10;
 #else
-  /* LIB NAME .SO\0 = 3 + STRLEN(NAME) + 3 */
-  const size_t lib_name_len = strlen(name) + 6;
+  /* LIB NAME .SO\0 = 3 + STRLEN(NAME) + 4 */
+  const size_t lib_name_len = strlen(name) + 7;
 #endif
   char* const lib_name = alloca(lib_name_len);
   memset(lib_name, 0, lib_name_len);
@@ -420,29 +409,33 @@ module_init(const lisp_t lisp)
    * Try to create the user cache directory.
    */
   struct stat ss;
-  int rc = stat(lisp_usercache_prefix(), &ss);
+  char cache[PATH_MAX];
+  lisp_usercache_prefix(cache);
+  int rc = stat(cache, &ss);
   if (rc != 0) {
-    if (errno == ENOENT && mkdir(lisp_usercache_prefix(), S_IRWXU) == 0) {
+    if (errno == ENOENT && mkdir(cache, S_IRWXU) == 0) {
       return true;
     }
-    ERROR("%s: %s", lisp_usercache_prefix(), strerror(errno));
+    ERROR("%s: %s", cache, strerror(errno));
     return false;
   }
   /*
    * Check the stats.
    */
   if ((ss.st_mode & S_IFDIR) == 0) {
-    ERROR("%s exists and is not a directory", lisp_usercache_prefix());
+    ERROR("%s exists and is not a directory", cache);
     return false;
   }
   if ((ss.st_mode & S_IRWXU) == 0) {
-    ERROR("%s cannot be accessed", lisp_usercache_prefix());
+    ERROR("%s cannot be accessed", cache);
     return false;
   }
   /*
    * Report the known load path.
    */
-  TRACE_MODL("Module load path: %s", module_paths());
+  char* paths = module_paths();
+  TRACE_MODL("Module load path: %s", paths);
+  free(paths);
   /*
    * Good to go.
    */
@@ -493,7 +486,7 @@ module_load(const lisp_t lisp, const atom_t cell)
    * Find the module for the symbol. Returns where the module was found.
    */
   char path[PATH_MAX];
-  bool found = module_find(paths, module_name, path);
+  bool found = paths != NULL && module_find(paths, module_name, path);
   free(paths);
   if (!found) {
     X(lisp, module_name, symbol_list);
@@ -510,6 +503,45 @@ module_load(const lisp_t lisp, const atom_t cell)
   return syms;
 }
 
+/*
+ * Module open.
+ */
+
+void*
+module_open(const lisp_t lisp, const atom_t name)
+{
+  TRACE_MODL_SEXP(name);
+  /*
+   * Check if the module is in the cache.
+   */
+  void* handle = module_find_from_cache(lisp, name);
+  if (handle != NULL) {
+    return handle;
+  }
+  /*
+   * Find the module.
+   */
+  char* paths = module_paths();
+  char path[PATH_MAX];
+  bool found = paths != NULL && module_find(paths, name, path);
+  free(paths);
+  if (!found) {
+    return NULL;
+  }
+  /*
+   * Load the library and add it to the cache.
+   */
+  char bsym[17] = { 0 };
+  strncpy(bsym, name->symbol.val, LISP_SYMBOL_LENGTH);
+  handle = module_load_at_path(path, bsym);
+  if (handle != NULL) {
+    atom_t hnd = lisp_make_number(lisp, (int64_t)handle);
+    atom_t val = lisp_cons(lisp, UP(name), hnd);
+    lisp->modules = lisp_setq(lisp, lisp->modules, val);
+  }
+  return handle;
+}
+
 /*
  * Load defaults.
  */
@@ -1,139 +1,560 @@
+#include <mnml/array.h>
+#include <mnml/bignum.h>
+#include <mnml/buffer.h>
+#include <mnml/debug.h>
 #include <mnml/lisp.h>
+#include <mnml/record.h>
+#include <mnml/rope.h>
+#include <mnml/utils.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
-#define IO_BUFFER_LEN 1024
+#define WBUFLEN 65536
+#define PRINT_STACK_LEN 64
 
-static size_t lisp_prin_atom(FILE* const handle, char* const buf,
-                             const size_t idx, const atom_t cell, const bool s);
+/*
+ * Writer state. It lives in the slot of its output channel so that its buffer
+ * is reused across prints and across channels. The buffer is written to the
+ * channel when it is full, and the channel is flushed according to the writer's
+ * mode, when the channel is released, or on demand. Terminals are line-buffered
+ * by default, other files are block-buffered.
+ */
 
-static size_t
-lisp_write(FILE* const handle, char* const buf, const size_t idx, void* data,
-           const size_t len)
+typedef struct writer
 {
-  size_t pidx = idx;
+  FILE* handle;
+  out_mode_t mode;
+  bool newline;
+  size_t len;
+  char buffer[WBUFLEN];
+}* writer_t;
+
+static writer_t
+lisp_writer_get(const io_context_t ctx)
+{
+  writer_t writer = (writer_t)ctx->state;
   /*
-   * Flush the buffer if necessary.
+   * Return the active writer.
    */
-  if (pidx + len >= IO_BUFFER_LEN) {
-    fwrite(buf, 1, pidx, handle);
-    pidx = 0;
+  if (likely(writer != NULL && writer->handle != NULL)) {
+    return writer;
   }
   /*
-   * Append the new data.
+   * Create a new writer if the slot does not have one yet.
+   */
+  if (writer == NULL) {
+    writer = (writer_t)malloc(sizeof(struct writer));
+    if (writer == NULL) {
+      ERROR("Cannot allocate the output buffer");
+      return NULL;
+    }
+    ctx->state = writer;
+  }
+  /*
+   * Attach the writer to the channel.
    */
-  memcpy(&buf[pidx], data, len);
-  return pidx + len;
+  writer->handle = ctx->handle;
+  writer->mode = isatty(ctx->fd) ? OUT_LINE : OUT_BLOCK;
+  writer->newline = false;
+  writer->len = 0;
+  return writer;
+}
+
+static void
+lisp_writer_drain(const writer_t w)
+{
+  if (w->len > 0) {
+    fwrite(w->buffer, 1, w->len, w->handle);
+    w->len = 0;
+  }
+}
+
+static void
+lisp_writer_flush(const writer_t w)
+{
+  lisp_writer_drain(w);
+  fflush(w->handle);
+  w->newline = false;
 }
 
 static void
-lisp_flush(FILE* const handle, char* const buf, const size_t idx)
+lisp_writer_commit(const writer_t w)
 {
-  fwrite(buf, 1, idx, handle);
-  fflush(handle);
+  switch (w->mode) {
+    case OUT_NONE:
+      lisp_writer_flush(w);
+      break;
+    case OUT_LINE:
+      if (w->newline) {
+        lisp_writer_flush(w);
+      }
+      break;
+    default:
+      w->newline = false;
+      break;
+  }
 }
 
-static size_t
-lisp_prin_pair(FILE* const handle, char* const buf, const size_t idx,
-               const atom_t cell, const bool s)
+static void
+lisp_writer_put(const writer_t w, const void* const data, const size_t len)
 {
-  size_t nxt = 0;
+  w->newline |= memchr(data, '\n', len) != NULL;
   /*
-   * Print CAR.
+   * Drain the buffer if necessary.
    */
-  nxt = lisp_prin_atom(handle, buf, idx, CAR(cell), s);
+  if (unlikely(w->len + len > WBUFLEN)) {
+    lisp_writer_drain(w);
+    /*
+     * Write large data directly.
+     */
+    if (len >= WBUFLEN) {
+      fwrite(data, 1, len, w->handle);
+      return;
+    }
+  }
   /*
-   * Print CDR.
+   * Append the new data.
    */
-  if (!IS_NULL(CDR(cell))) {
-    if (IS_PAIR(CDR(cell))) {
-      if (s) {
-        nxt = lisp_write(handle, buf, nxt, " ", 1);
-      }
-      return lisp_prin_pair(handle, buf, nxt, CDR(cell), s);
-    } else {
-      if (s) {
-        nxt = lisp_write(handle, buf, nxt, " . ", 3);
-      }
-      return lisp_prin_atom(handle, buf, nxt, CDR(cell), s);
+  memcpy(&w->buffer[w->len], data, len);
+  w->len += len;
+}
+
+static void
+lisp_writer_putc(const writer_t w, const char c)
+{
+  if (unlikely(w->len == WBUFLEN)) {
+    lisp_writer_drain(w);
+  }
+  w->newline |= c == '\n';
+  w->buffer[w->len++] = c;
+}
+
+/*
+ * Number formatting. Digits are produced two at a time from the end.
+ */
+
+static const char DIGITS[] = "00010203040506070809"
+                             "10111213141516171819"
+                             "20212223242526272829"
+                             "30313233343536373839"
+                             "40414243444546474849"
+                             "50515253545556575859"
+                             "60616263646566676869"
+                             "70717273747576777879"
+                             "80818283848586878889"
+                             "90919293949596979899";
+
+static void
+lisp_prin_number(const writer_t w, const int64_t number)
+{
+  char buffer[24];
+  char* const end = buffer + sizeof(buffer);
+  char* p = end;
+  uint64_t val = number < 0 ? -(uint64_t)number : (uint64_t)number;
+  while (val >= 100) {
+    const size_t idx = (val % 100) << 1;
+    val /= 100;
+    *--p = DIGITS[idx + 1];
+    *--p = DIGITS[idx];
+  }
+  if (val >= 10) {
+    const size_t idx = val << 1;
+    *--p = DIGITS[idx + 1];
+    *--p = DIGITS[idx];
+  } else {
+    *--p = (char)('0' + val);
+  }
+  if (number < 0) {
+    *--p = '-';
+  }
+  lisp_writer_put(w, p, end - p);
+}
+
+static void
+lisp_prin_array(const writer_t w, const atom_t cell, const bool s)
+{
+  if (s) {
+    lisp_writer_putc(w, '(');
+  }
+  for (size_t i = 0; i < ARRAY_LEN(cell); i += 1) {
+    if (s && i > 0) {
+      lisp_writer_putc(w, ' ');
+    }
+    lisp_prin_number(w, lisp_array_get(cell, i));
+  }
+  if (s) {
+    lisp_writer_putc(w, ')');
+  }
+}
+
+static const char*
+lisp_escape(const char c)
+{
+  switch (c) {
+    case '\033':
+      return "\\e";
+    case '\n':
+      return "\\n";
+    case '\r':
+      return "\\r";
+    case '\t':
+      return "\\t";
+    case '"':
+      return "\\\"";
+    case '\\':
+      return "\\\\";
+    default:
+      return NULL;
+  }
+}
+
+static void
+lisp_prin_escaped(const writer_t w, const char* const data, const size_t len)
+{
+  size_t start = 0;
+  for (size_t i = 0; i < len; i += 1) {
+    const char* esc = lisp_escape(data[i]);
+    if (esc != NULL) {
+      lisp_writer_put(w, &data[start], i - start);
+      lisp_writer_put(w, esc, 2);
+      start = i + 1;
     }
   }
+  lisp_writer_put(w, &data[start], len - start);
+}
+
+static void
+lisp_prin_chunk(const writer_t w, const char* const data, const size_t len,
+                const bool s)
+{
+  if (s) {
+    lisp_prin_escaped(w, data, len);
+  } else {
+    lisp_writer_put(w, data, len);
+  }
+}
+
+static void
+lisp_prin_rope(const writer_t w, const atom_t cell, const bool s)
+{
+  if (s) {
+    lisp_writer_putc(w, '"');
+  }
   /*
+   * Print the chunks in place.
    */
-  return nxt;
+  for (size_t i = 0; i < cell->rope.count; i += 1) {
+    const atom_t atom = cell->rope.chunks->items[i].atom;
+    if (atom->type == T_CHAR) {
+      const char c = (char)atom->number;
+      lisp_prin_chunk(w, &c, 1, s);
+    } else {
+      lisp_prin_chunk(w, BUFFER_DATA(atom), BUFFER_LEN(atom), s);
+    }
+  }
+  if (s) {
+    lisp_writer_putc(w, '"');
+  }
 }
 
-static size_t
-lisp_prin_atom(FILE* const handle, char* const buf, const size_t idx,
-               const atom_t cell, const bool s)
+static void
+lisp_prin_char(const writer_t w, const char c, const bool s)
+{
+  if (s) {
+    lisp_writer_putc(w, '^');
+    /*
+     * Quotes and backslashes are not escaped in characters.
+     */
+    const char* esc = c == '"' || c == '\\' ? NULL : lisp_escape(c);
+    if (esc != NULL) {
+      lisp_writer_put(w, esc, 2);
+      return;
+    }
+  }
+  lisp_writer_putc(w, c);
+}
+
+static void
+lisp_prin_atom(const writer_t w, const atom_t cell, const bool s)
 {
   switch (cell->type) {
     case T_NIL:
-      return s ? lisp_write(handle, buf, idx, "NIL", 3) : 0;
+      if (s) {
+        lisp_writer_put(w, "NIL", 3);
+      }
+      break;
     case T_TRUE:
-      return lisp_write(handle, buf, idx, "T", 1);
-    case T_CHAR: {
-      char c = (char)cell->number;
+      lisp_writer_putc(w, 'T');
+      break;
+    case T_CHAR:
+      lisp_prin_char(w, (char)cell->number, s);
+      break;
+    case T_NUMBER:
+      lisp_prin_number(w, cell->number);
+      break;
+    case T_SYMBOL:
+      lisp_writer_put(w, cell->symbol.val,
+                      strnlen(cell->symbol.val, LISP_SYMBOL_LENGTH));
+      break;
+    case T_WILDCARD:
+      lisp_writer_putc(w, '_');
+      break;
+    case T_BUFFER:
       if (s) {
-        size_t nxt = lisp_write(handle, buf, idx, "^", 1);
-        switch (c) {
-          case '\033':
-            nxt = lisp_write(handle, buf, nxt, "\\e", 2);
-            break;
-          case '\n':
-            nxt = lisp_write(handle, buf, nxt, "\\n", 2);
-            break;
-          case '\r':
-            nxt = lisp_write(handle, buf, nxt, "\\r", 2);
-            break;
-          case '\t':
-            nxt = lisp_write(handle, buf, nxt, "\\t", 2);
-            break;
-          default:
-            nxt = lisp_write(handle, buf, nxt, &c, 1);
-            break;
+        lisp_writer_putc(w, '"');
+        lisp_prin_escaped(w, BUFFER_DATA(cell), BUFFER_LEN(cell));
+        lisp_writer_putc(w, '"');
+        break;
+      }
+      lisp_writer_put(w, BUFFER_DATA(cell), BUFFER_LEN(cell));
+      break;
+    case T_ARRAY:
+      lisp_prin_array(w, cell, s);
+      break;
+    case T_ROPE:
+      lisp_prin_rope(w, cell, s);
+      break;
+    case T_BIGNUM: {
+      char* str = lisp_bignum_to_cstring(cell);
+      if (str != NULL) {
+        lisp_writer_put(w, str, strlen(str));
+        free(str);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+/*
+ * Printer. Lists and records are traversed with an explicit stack so that the
+ * depth and the length of a value are not bounded by the C stack.
+ */
+
+typedef enum frame_kind
+{
+  F_LIST,
+  F_TAIL,
+  F_RECORD
+} frame_kind_t;
+
+typedef struct frame
+{
+  frame_kind_t kind;
+  size_t idx;
+  atom_t cell;
+} frame_t;
+
+typedef struct printer
+{
+  writer_t w;
+  bool s;
+  size_t len;
+  size_t cap;
+  frame_t* frames;
+  frame_t stack[PRINT_STACK_LEN];
+} printer_t;
+
+static bool
+lisp_printer_push(printer_t* const p, const frame_kind_t kind,
+                  const atom_t cell)
+{
+  /*
+   * Move the stack to the heap when it is full.
+   */
+  if (unlikely(p->len == p->cap)) {
+    const size_t cap = p->cap << 1;
+    frame_t* frames = p->frames == p->stack ? NULL : p->frames;
+    frames = (frame_t*)realloc(frames, cap * sizeof(frame_t));
+    if (frames == NULL) {
+      ERROR("Cannot grow the print stack to %lu frames", cap);
+      return false;
+    }
+    if (p->frames == p->stack) {
+      memcpy(frames, p->stack, sizeof(p->stack));
+    }
+    p->frames = frames;
+    p->cap = cap;
+  }
+  /*
+   */
+  frame_t* f = &p->frames[p->len];
+  f->kind = kind;
+  f->idx = 0;
+  f->cell = cell;
+  p->len += 1;
+  return true;
+}
+
+static atom_t
+lisp_printer_next(printer_t* const p)
+{
+  const writer_t w = p->w;
+  while (p->len > 0) {
+    frame_t* f = &p->frames[p->len - 1];
+    switch (f->kind) {
+      /*
+       * Move to the next element of a list or to its tail.
+       */
+      case F_LIST: {
+        atom_t cdr = CDR(f->cell);
+        if (IS_PAIR(cdr)) {
+          if (p->s) {
+            lisp_writer_putc(w, ' ');
+          }
+          f->cell = cdr;
+          return CAR(cdr);
         }
-        return nxt;
+        if (!IS_NULL(cdr)) {
+          if (p->s) {
+            lisp_writer_put(w, " . ", 3);
+          }
+          f->kind = F_TAIL;
+          return cdr;
+        }
+        break;
       }
-      return lisp_write(handle, buf, idx, &c, 1);
+      /*
+       * Move to the next field of a record.
+       */
+      case F_RECORD:
+        if (f->idx < RECORD_LEN(f->cell)) {
+          if (p->s) {
+            lisp_writer_putc(w, ' ');
+          }
+          f->idx += 1;
+          return RECORD_FIELD(f->cell, f->idx - 1);
+        }
+        break;
+      default:
+        break;
     }
-    case T_PAIR: {
-      size_t nxt = idx;
-      if (s) {
-        nxt = lisp_write(handle, buf, nxt, "(", 1);
+    /*
+     * The value is complete.
+     */
+    if (p->s) {
+      lisp_writer_putc(w, ')');
+    }
+    p->len -= 1;
+  }
+  return NULL;
+}
+
+static void
+lisp_printer_run(printer_t* const p, const atom_t cell)
+{
+  const writer_t w = p->w;
+  atom_t cur = cell;
+  while (cur != NULL) {
+    /*
+     * Open lists and records.
+     */
+    if (IS_PAIR(cur) || IS_RECD(cur)) {
+      const bool list = IS_PAIR(cur);
+      if (!lisp_printer_push(p, list ? F_LIST : F_RECORD, cur)) {
+        return;
       }
-      nxt = lisp_prin_pair(handle, buf, nxt, cell, s);
-      if (s) {
-        nxt = lisp_write(handle, buf, nxt, ")", 1);
+      if (p->s) {
+        lisp_writer_putc(w, '(');
+      }
+      if (list) {
+        cur = CAR(cur);
+        continue;
       }
-      return nxt;
+      lisp_prin_atom(w, RECORD_NAME(cur), p->s);
     }
-    case T_NUMBER: {
-      char buffer[24] = { 0 };
-#if defined(__MACH__) || defined(__OpenBSD__)
-      sprintf(buffer, "%lld", cell->number);
-#else
-      sprintf(buffer, "%ld", cell->number);
-#endif
-      return lisp_write(handle, buf, idx, buffer, strlen(buffer));
+    /*
+     * Print other values.
+     */
+    else {
+      lisp_prin_atom(w, cur, p->s);
     }
-    case T_SYMBOL:
-      return lisp_write(handle, buf, idx, cell->symbol.val,
-                        strnlen(cell->symbol.val, LISP_SYMBOL_LENGTH));
-    case T_WILDCARD:
-      return lisp_write(handle, buf, idx, "_", 1);
-    default:
-      return 0;
+    /*
+     * Grab the next value.
+     */
+    cur = lisp_printer_next(p);
   }
 }
 
+/*
+ * Public interface.
+ */
+
 void
 lisp_prin(const lisp_t lisp, const atom_t cell, const bool s)
 {
-  FILE* handle = (FILE*)CAR(CAR(lisp->ochan))->number;
-  char buffer[IO_BUFFER_LEN];
-  size_t idx = lisp_prin_atom(handle, buffer, 0, cell, s);
-  lisp_flush(handle, buffer, idx);
+  writer_t w = lisp_writer_get(IO_CONTEXT(lisp->ochan));
+  if (w == NULL) {
+    return;
+  }
+  /*
+   * Print the value.
+   */
+  printer_t p = { .w = w, .s = s, .len = 0, .cap = PRINT_STACK_LEN };
+  p.frames = p.stack;
+  lisp_printer_run(&p, cell);
+  if (p.frames != p.stack) {
+    free(p.frames);
+  }
+  /*
+   * Flush the channel if necessary.
+   */
+  lisp_writer_commit(w);
+}
+
+void
+lisp_write(const lisp_t lisp, const void* const data, const size_t len)
+{
+  writer_t w = lisp_writer_get(IO_CONTEXT(lisp->ochan));
+  if (w == NULL) {
+    return;
+  }
+  lisp_writer_put(w, data, len);
+  lisp_writer_commit(w);
+}
+
+void
+lisp_flush(const lisp_t lisp)
+{
+  for (size_t i = 0; i < lisp->ochan.depth; i += 1) {
+    writer_t writer = (writer_t)lisp->ochan.slots[i].state;
+    if (writer != NULL && writer->handle != NULL) {
+      lisp_writer_flush(writer);
+    }
+  }
+}
+
+out_mode_t
+lisp_set_out_mode(const lisp_t lisp, const out_mode_t mode)
+{
+  writer_t w = lisp_writer_get(IO_CONTEXT(lisp->ochan));
+  if (w == NULL) {
+    return mode;
+  }
+  out_mode_t prev = w->mode;
+  w->mode = mode;
+  lisp_writer_commit(w);
+  return prev;
+}
+
+out_mode_t
+lisp_get_out_mode(const lisp_t lisp)
+{
+  writer_t w = lisp_writer_get(IO_CONTEXT(lisp->ochan));
+  return w == NULL ? OUT_NONE : w->mode;
+}
+
+void
+lisp_write_release(const io_context_t ctx)
+{
+  writer_t writer = (writer_t)ctx->state;
+  if (writer != NULL && writer->handle != NULL) {
+    lisp_writer_flush(writer);
+    writer->handle = NULL;
+  }
 }
 
 // vim: tw=80:sw=2:ts=2:sts=2:et
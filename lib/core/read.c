@@ -6,72 +6,256 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-#define RBUFLEN 1024
+#define RBUFLEN 65536
+
+/*
+ * Reader state. It lives as long as its input channel so that partial tokens
+ * and forms are resumed across reads. Regular files read from their beginning
+ * are mapped in memory and handed to the lexer in one go. The last pair of the
+ * channel's value queue is kept to append parsed forms in constant time.
+ */
+
+typedef struct reader
+{
+  lexer_t lexer;
+  bool block;
+  bool mapped;
+  bool end;
+  size_t size;
+  char* buffer;
+  atom_t last;
+}* reader_t;
 
 static void
 lisp_consumer(const lisp_t lisp, const atom_t cell)
 {
-  atom_t chn = CAR(lisp->ichan);
-  CDR(chn) = lisp_append(lisp, CDR(chn), cell);
+  io_context_t ctx = IO_CONTEXT(lisp->ichan);
+  reader_t reader = (reader_t)ctx->state;
+  atom_t con = lisp_cons(lisp, cell, lisp_make_nil(lisp));
+  /*
+   * Start a new queue if the previous one was drained.
+   */
+  if (IS_NULL(ctx->values)) {
+    X(lisp, ctx->values);
+    ctx->values = con;
+  }
+  /*
+   * Otherwise, append the value after the last one.
+   */
+  else {
+    X(lisp, CDR(reader->last));
+    CDR(reader->last) = con;
+  }
+  reader->last = con;
+}
+
+static reader_t
+lisp_reader_get(const lisp_t lisp, const io_context_t ctx)
+{
+  /*
+   * Return the existing reader.
+   */
+  if (ctx->state != NULL) {
+    return (reader_t)ctx->state;
+  }
+  /*
+   * Create a new reader.
+   */
+  reader_t reader = (reader_t)malloc(sizeof(struct reader));
+  if (reader == NULL) {
+    return NULL;
+  }
+  reader->mapped = false;
+  reader->end = false;
+  reader->last = NULL;
+  /*
+   * Regular files are read in blocks. Other files are read line by line so
+   * that we don't block past the end of a form.
+   */
+  struct stat st;
+  FILE* handle = ctx->handle;
+  const int fd = ctx->fd;
+  reader->block = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+  /*
+   * Map the file if nothing has been read from it yet.
+   */
+  if (reader->block && st.st_size > 0 && ftello(handle) == 0) {
+    const size_t len = st.st_size;
+    void* map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (map != MAP_FAILED) {
+      madvise(map, len, MADV_SEQUENTIAL);
+      reader->mapped = true;
+      reader->buffer = (char*)map;
+      reader->size = len;
+    }
+  }
+  /*
+   * Otherwise allocate the read buffer.
+   */
+  if (!reader->mapped) {
+    reader->buffer = (char*)malloc(RBUFLEN);
+    if (reader->buffer == NULL) {
+      free(reader);
+      return NULL;
+    }
+    reader->size = RBUFLEN;
+  }
+  /*
+   */
+  reader->lexer = lexer_create(lisp, lisp_consumer);
+  ctx->state = reader;
+  return reader;
+}
+
+static bool
+lisp_reader_grow(const reader_t reader)
+{
+  const size_t size = reader->size << 1;
+  char* buffer = (char*)realloc(reader->buffer, size);
+  if (buffer == NULL) {
+    ERROR("Cannot grow the read buffer to %lu bytes", size);
+    return false;
+  }
+  /*
+   * The partial token is at the beginning of the buffer.
+   */
+  lexer_t lexer = reader->lexer;
+  if (lexer->ts != NULL) {
+    lexer->te = buffer + (lexer->te - lexer->ts);
+    lexer->ts = buffer;
+  }
+  reader->buffer = buffer;
+  reader->size = size;
+  return true;
+}
+
+static size_t
+lisp_reader_fill(const lisp_t lisp, const reader_t reader, FILE* const handle,
+                 bool* const end)
+{
+  char* const buffer = reader->buffer + reader->lexer->rem;
+  const size_t len = reader->size - reader->lexer->rem;
+  /*
+   * A mapped file is available at once.
+   */
+  if (reader->mapped) {
+    *end = true;
+    return reader->end ? 0 : reader->size;
+  }
+  /*
+   * Read a block. The end of the token stream is reached on a short read.
+   */
+  if (reader->block) {
+    const size_t res = fread(buffer, 1, len, handle);
+    *end = res < len;
+    return res;
+  }
+  /*
+   * Read a line. The end of the token stream is reached at the end of the line.
+   */
+  lisp_wait_input(lisp, handle);
+  if (fgets(buffer, (int)len, handle) == NULL) {
+    return 0;
+  }
+  const size_t res = strlen(buffer);
+  *end = res > 0 && buffer[res - 1] == '\n';
+  return res;
+}
+
+void
+lisp_read_release(const io_context_t ctx)
+{
+  reader_t reader = (reader_t)ctx->state;
+  if (reader != NULL) {
+    lexer_destroy(reader->lexer);
+    if (reader->mapped) {
+      munmap(reader->buffer, reader->size);
+    } else {
+      free(reader->buffer);
+    }
+    free(reader);
+    ctx->state = NULL;
+  }
 }
 
 static atom_t
 lisp_read_pop(const lisp_t lisp)
 {
-  TRACE_CHAN_SEXP(lisp->ichan);
+  TRACE_CHAN_SEXP(IO_CONTEXT_VALUES(lisp->ichan));
   /*
-   * ((CHN0 PWD V1 V2) (CHN1 PWD V1 V2) ...).
+   * Pop the first value of the current context.
    */
-  atom_t chn = CAR(lisp->ichan);
-  atom_t vls = CDR(CDR(chn));
+  atom_t vls = IO_CONTEXT_VALUES(lisp->ichan);
   atom_t res = UP(CAR(vls));
-  CDR(CDR(chn)) = UP(CDR(vls));
+  IO_CONTEXT_VALUES(lisp->ichan) = UP(CDR(vls));
   X(lisp, vls);
   /*
    */
-  TRACE_CHAN_SEXP(lisp->ichan);
+  TRACE_CHAN_SEXP(IO_CONTEXT_VALUES(lisp->ichan));
   return res;
 }
 
 atom_t
 lisp_read(const lisp_t lisp, const atom_t cell)
 {
-  TRACE_CHAN_SEXP(lisp->ichan);
+  TRACE_CHAN_SEXP(IO_CONTEXT_VALUES(lisp->ichan));
   X(lisp, cell);
-  /*
-   * Grab the channel, the path and the content.
-   */
-  atom_t chn = CAR(lisp->ichan);
-  atom_t hnd = CAR(chn);
-  atom_t val = CDR(CDR(chn));
   /*
    * Check if there is any value in the channel's buffer.
    */
-  if (!IS_NULL(val)) {
+  if (!IS_NULL(IO_CONTEXT_VALUES(lisp->ichan))) {
     return lisp_read_pop(lisp);
   }
   /*
-   * Read from the file descriptor.
+   * Grab the channel's reader.
    */
-  lexer_t lexer = lexer_create(lisp, lisp_consumer);
-  FILE* handle = (FILE*)hnd->number;
+  io_context_t ctx = IO_CONTEXT(lisp->ichan);
+  reader_t reader = lisp_reader_get(lisp, ctx);
+  if (reader == NULL) {
+    return NULL;
+  }
+  lexer_t lexer = reader->lexer;
+  FILE* handle = ctx->handle;
   /*
+   * Read until a top-level form is ready. The rest of the input, including any
+   * partial token, stays with the channel for the next read.
    */
-  char buffer[RBUFLEN] = { 0 };
   do {
-    char* p = fgets(buffer + lexer->rem, RBUFLEN - lexer->rem, handle);
-    if (p == NULL) {
+    bool end = false;
+    /*
+     * Resume the scan of the input left after the previous form.
+     */
+    if (lexer->off < lexer->rem) {
+      lexer_parse(lexer, reader->buffer, lexer->rem, reader->end);
+      continue;
+    }
+    /*
+     * Grow the buffer if the partial token fills it.
+     */
+    if (!reader->mapped && lexer->rem + 1 >= reader->size &&
+        !lisp_reader_grow(reader)) {
+      break;
+    }
+    /*
+     * Flush the lexer at the end of the file.
+     */
+    size_t len = lisp_reader_fill(lisp, reader, handle, &end);
+    if (len == 0) {
+      if (lexer_pending(lexer)) {
+        lexer_parse(lexer, reader->buffer, lexer->rem, true);
+      }
       break;
     }
-    size_t len = strlen(p);
-    lexer_parse(lexer, buffer, lexer->rem + len, lexer->rem + len < RBUFLEN);
-  } while (IS_NULL(CDR(CDR(CAR(lisp->ichan)))) || lexer_pending(lexer));
+    lexer_parse(lexer, reader->buffer, lexer->rem + len, end);
+    reader->end = end;
+  } while (IS_NULL(IO_CONTEXT_VALUES(lisp->ichan)));
   /*
    * Grab the result and return it.
    */
-  lexer_destroy(lexer);
-  return IS_NULL(CDR(CDR(chn))) ? NULL : lisp_read_pop(lisp);
+  return IS_NULL(IO_CONTEXT_VALUES(lisp->ichan)) ? NULL : lisp_read_pop(lisp);
 }
 
 // vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,129 @@
+#include <mnml/debug.h>
+#include <mnml/lisp.h>
+#include <mnml/record.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <stdlib.h>
+
+/*
+ * Record allocation.
+ */
+
+atom_t
+lisp_make_record(const lisp_t lisp, const atom_t desc, const size_t count)
+{
+  /*
+   * Check the number of fields.
+   */
+  if (count > RECORD_MAX_LEN) {
+    ERROR("Record length too large: %lu", count);
+    X(lisp, desc);
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Allocate the record.
+   */
+  const size_t len = sizeof(struct record) + count * sizeof(atom_t);
+  record_t record = (record_t)malloc(len);
+  if (record == NULL) {
+    ERROR("Cannot allocate a record of %lu fields", count);
+    X(lisp, desc);
+    return lisp_make_nil(lisp);
+  }
+  record->desc = desc;
+  record->count = count;
+  /*
+   * Build the atom.
+   */
+  atom_t R = lisp_allocate(lisp);
+  R->type = T_RECORD;
+  R->flags = 0;
+  R->refs = 1;
+  R->record = record;
+  TRACE_MAKE_SEXP(R);
+  return R;
+}
+
+void
+lisp_record_release(const lisp_t lisp, const atom_t cell)
+{
+  record_t record = cell->record;
+  for (size_t i = 0; i < record->count; i += 1) {
+    X(lisp, record->fields[i]);
+  }
+  X(lisp, record->desc);
+  free(record);
+}
+
+/*
+ * Record comparison. Records of different definitions are never equal.
+ */
+
+bool
+lisp_record_equ(const atom_t a, const atom_t b)
+{
+  if (RECORD_DESC(a) != RECORD_DESC(b)) {
+    return false;
+  }
+  for (size_t i = 0; i < RECORD_LEN(a); i += 1) {
+    if (!lisp_equ(RECORD_FIELD(a, i), RECORD_FIELD(b, i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * List view.
+ */
+
+static atom_t
+lisp_record_fields(const lisp_t lisp, const atom_t cell, const size_t idx)
+{
+  atom_t res = lisp_make_nil(lisp);
+  for (size_t i = RECORD_LEN(cell); i > idx; i -= 1) {
+    res = lisp_cons(lisp, UP(RECORD_FIELD(cell, i - 1)), res);
+  }
+  return res;
+}
+
+atom_t
+lisp_record_to_list(const lisp_t lisp, const atom_t cell)
+{
+  atom_t fld = lisp_record_fields(lisp, cell, 0);
+  return lisp_cons(lisp, UP(RECORD_NAME(cell)), fld);
+}
+
+atom_t
+lisp_record_bind(const lisp_t lisp, const atom_t closure, const atom_t arg,
+                 const atom_t val)
+{
+  atom_t cls = closure;
+  /*
+   * Bind the name.
+   */
+  atom_t sym = lisp_car(lisp, arg);
+  atom_t cur = lisp_cdr(lisp, arg);
+  X(lisp, arg);
+  cls = lisp_bind(lisp, cls, sym, UP(RECORD_NAME(val)));
+  /*
+   * Bind the fields in place as long as the pattern is a list.
+   */
+  size_t idx = 0;
+  while (IS_PAIR(cur) && idx < RECORD_LEN(val)) {
+    atom_t car = lisp_car(lisp, cur);
+    atom_t cdr = lisp_cdr(lisp, cur);
+    X(lisp, cur);
+    cls = lisp_bind(lisp, cls, car, UP(RECORD_FIELD(val, idx)));
+    cur = cdr;
+    idx += 1;
+  }
+  /*
+   * Bind the remaining fields to the rest of the pattern.
+   */
+  atom_t rem = lisp_record_fields(lisp, val, idx);
+  X(lisp, val);
+  return lisp_bind(lisp, cls, cur, rem);
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,299 @@
+#include <mnml/buffer.h>
+#include <mnml/debug.h>
+#include <mnml/lisp.h>
+#include <mnml/rope.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Chunk list functions.
+ */
+
+static chunks_t
+lisp_chunks_new(const size_t cap)
+{
+  chunks_t chunks = (chunks_t)malloc(sizeof(struct chunks));
+  if (chunks == NULL) {
+    return NULL;
+  }
+  chunks->items = (chunk_t)malloc(cap * sizeof(struct chunk));
+  if (chunks->items == NULL) {
+    free(chunks);
+    return NULL;
+  }
+  chunks->refs = 1;
+  chunks->count = 0;
+  chunks->cap = cap;
+  return chunks;
+}
+
+static bool
+lisp_chunks_add(const chunks_t chunks, const atom_t atom, const size_t len)
+{
+  /*
+   * Grow the chunk list if necessary.
+   */
+  if (chunks->count == chunks->cap) {
+    const size_t cap = chunks->cap << 1;
+    chunk_t items = (chunk_t)realloc(chunks->items, cap * sizeof(struct chunk));
+    if (items == NULL) {
+      ERROR("Cannot grow rope to %lu chunks", cap);
+      return false;
+    }
+    chunks->items = items;
+    chunks->cap = cap;
+  }
+  /*
+   * Append the chunk.
+   */
+  const size_t beg =
+    chunks->count == 0 ? 0 : chunks->items[chunks->count - 1].end;
+  chunks->items[chunks->count].atom = atom;
+  chunks->items[chunks->count].end = beg + len;
+  chunks->count += 1;
+  return true;
+}
+
+static chunks_t
+lisp_chunks_copy(const chunks_t chunks, const size_t count)
+{
+  chunks_t next = lisp_chunks_new(count < ROPE_DEFAULT_CHUNKS
+                                    ? ROPE_DEFAULT_CHUNKS
+                                    : count << 1);
+  if (next == NULL) {
+    return NULL;
+  }
+  for (size_t i = 0; i < count; i += 1) {
+    next->items[i].atom = UP(chunks->items[i].atom);
+    next->items[i].end = chunks->items[i].end;
+  }
+  next->count = count;
+  return next;
+}
+
+/*
+ * Rope allocation.
+ */
+
+static atom_t
+lisp_make_rope_with(const lisp_t lisp, const chunks_t chunks,
+                    const size_t count)
+{
+  atom_t R = lisp_allocate(lisp);
+  R->type = T_ROPE;
+  R->flags = 0;
+  R->refs = 1;
+  R->rope.chunks = chunks;
+  R->rope.count = count;
+  TRACE_MAKE_SEXP(R);
+  return R;
+}
+
+atom_t
+lisp_make_rope(const lisp_t lisp)
+{
+  chunks_t chunks = lisp_chunks_new(ROPE_DEFAULT_CHUNKS);
+  if (chunks == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  return lisp_make_rope_with(lisp, chunks, 0);
+}
+
+atom_t
+lisp_rope_dup(const lisp_t lisp, const atom_t cell)
+{
+  chunks_t chunks = cell->rope.chunks;
+  const size_t count = cell->rope.count;
+  /*
+   * Share the chunks if nothing has been appended past this view.
+   */
+  if (chunks->count == count) {
+    chunks->refs += 1;
+    return lisp_make_rope_with(lisp, chunks, count);
+  }
+  /*
+   * Otherwise, copy the chunks of the view.
+   */
+  chunks_t next = lisp_chunks_copy(chunks, count);
+  if (next == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  return lisp_make_rope_with(lisp, next, count);
+}
+
+void
+lisp_rope_release(const lisp_t lisp, const atom_t cell)
+{
+  chunks_t chunks = cell->rope.chunks;
+  /*
+   * Release the chunks if this is the last view.
+   */
+  chunks->refs -= 1;
+  if (chunks->refs > 0) {
+    return;
+  }
+  for (size_t i = 0; i < chunks->count; i += 1) {
+    X(lisp, chunks->items[i].atom);
+  }
+  free(chunks->items);
+  free(chunks);
+}
+
+/*
+ * Rope operations.
+ */
+
+bool
+lisp_rope_push(const lisp_t lisp, const atom_t cell, const atom_t item)
+{
+  /*
+   * Detach the view if another view sharing its chunks appended past it.
+   */
+  if (cell->rope.chunks->count != cell->rope.count) {
+    chunks_t next = lisp_chunks_copy(cell->rope.chunks, cell->rope.count);
+    if (next == NULL) {
+      return false;
+    }
+    lisp_rope_release(lisp, cell);
+    cell->rope.chunks = next;
+  }
+  chunks_t chunks = cell->rope.chunks;
+  atom_t atom = NULL;
+  size_t len = 0;
+  /*
+   * Process the item.
+   */
+  switch (item->type) {
+    case T_NIL:
+      return true;
+    case T_CHAR:
+      atom = UP(item);
+      len = 1;
+      break;
+    case T_PAIR:
+      if (!lisp_is_string(item)) {
+        return false;
+      }
+      /*
+       * Strings can be extended in place, so copy their characters.
+       */
+      len = lisp_len(item);
+      atom = lisp_make_buffer(lisp, len);
+      if (!IS_BUFF(atom)) {
+        X(lisp, atom);
+        return false;
+      }
+      FOREACH(item, p)
+      {
+        BUFFER_DATA(atom)[atom->buffer.length++] = (char)p->car->number;
+        NEXT(p);
+      }
+      break;
+    case T_BUFFER:
+      /*
+       * Buffers are mutable, so keep a snapshot of their content.
+       */
+      atom = lisp_buffer_slice(lisp, item, 0, BUFFER_LEN(item));
+      len = BUFFER_LEN(item);
+      break;
+    case T_ROPE:
+      for (size_t i = 0; i < item->rope.count; i += 1) {
+        const chunk_t c = &item->rope.chunks->items[i];
+        const size_t beg = i == 0 ? 0 : item->rope.chunks->items[i - 1].end;
+        if (!lisp_chunks_add(chunks, UP(c->atom), c->end - beg)) {
+          X(lisp, c->atom);
+          return false;
+        }
+        cell->rope.count += 1;
+      }
+      return true;
+    default:
+      return false;
+  }
+  /*
+   * Append the chunk.
+   */
+  if (!lisp_chunks_add(chunks, atom, len)) {
+    X(lisp, atom);
+    return false;
+  }
+  cell->rope.count += 1;
+  return true;
+}
+
+static size_t
+lisp_rope_flatten_atom(const atom_t atom, char* const data)
+{
+  switch (atom->type) {
+    case T_CHAR:
+      *data = (char)atom->number;
+      return 1;
+    default:
+      memcpy(data, BUFFER_DATA(atom), BUFFER_LEN(atom));
+      return BUFFER_LEN(atom);
+  }
+}
+
+void
+lisp_rope_flatten(const atom_t cell, char* const data)
+{
+  size_t idx = 0;
+  for (size_t i = 0; i < cell->rope.count; i += 1) {
+    idx += lisp_rope_flatten_atom(cell->rope.chunks->items[i].atom, data + idx);
+  }
+}
+
+bool
+lisp_rope_equ(const atom_t a, const atom_t b)
+{
+  const size_t len = ROPE_LEN(a);
+  /*
+   * Check the lengths.
+   */
+  if (len != ROPE_LEN(b)) {
+    return false;
+  }
+  if (len == 0) {
+    return true;
+  }
+  /*
+   * Flatten and compare the content.
+   */
+  char* data = (char*)malloc(len << 1);
+  if (data == NULL) {
+    return false;
+  }
+  lisp_rope_flatten(a, data);
+  lisp_rope_flatten(b, data + len);
+  const bool res = memcmp(data, data + len, len) == 0;
+  free(data);
+  return res;
+}
+
+atom_t
+lisp_rope_to_string(const lisp_t lisp, const atom_t cell)
+{
+  const size_t len = ROPE_LEN(cell);
+  /*
+   * Flatten the rope.
+   */
+  char* data = (char*)malloc(len);
+  if (data == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  lisp_rope_flatten(cell, data);
+  /*
+   * Build the string.
+   */
+  atom_t res = lisp_make_nil(lisp);
+  for (size_t i = 0; i < len; i += 1) {
+    atom_t c = lisp_make_char(lisp, data[len - i - 1]);
+    res = lisp_cons(lisp, c, res);
+  }
+  free(data);
+  return res;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
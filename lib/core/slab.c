@@ -46,7 +46,7 @@ slab_new()
   memset(slab, 0, sizeof(struct slab));
   slab->n_pages = 16;
   /*
-   * Allocate the slab (64MB).
+   * Reserve the slab (256MB). Pages are committed as needed.
    */
   slab->entries =
     (atom_t)mmap(NULL, SLAB_SIZE, PROT_NONE, MAP_ANON | MAP_PRIVATE, -1, 0);
@@ -0,0 +1,41 @@
+#include <mnml/debug.h>
+#include <mnml/store.h>
+#include <stdlib.h>
+#include <string.h>
+
+store_t
+lisp_store_new(const size_t size, const array_kind_t kind)
+{
+  store_t store = (store_t)malloc(sizeof(struct store) + size);
+  if (store == NULL) {
+    ERROR("Cannot allocate %luB of store", size);
+    return NULL;
+  }
+  store->refs = 1;
+  store->size = size;
+  store->kind = kind;
+  return store;
+}
+
+store_t
+lisp_store_dup(const store_t store, const size_t off, const size_t len,
+               const size_t size)
+{
+  store_t next = lisp_store_new(size, store->kind);
+  if (next == NULL) {
+    return NULL;
+  }
+  memcpy(next->data, store->data + off, len);
+  return next;
+}
+
+void
+lisp_store_release(const store_t store)
+{
+  store->refs -= 1;
+  if (store->refs == 0) {
+    free(store);
+  }
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -1,6 +1,11 @@
 #include <mnml/types.h>
+#include <mnml/array.h>
+#include <mnml/bignum.h>
+#include <mnml/buffer.h>
 #include <mnml/debug.h>
 #include <mnml/module.h>
+#include <mnml/record.h>
+#include <mnml/rope.h>
 #include <mnml/slab.h>
 #include <mnml/utils.h>
 #include <dirent.h>
@@ -8,6 +13,7 @@
 #include <libgen.h>
 #include <limits.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <time.h>
 #include <unistd.h>
@@ -16,22 +22,19 @@
  * Syntax error handler.
  */
 
-error_handler_t lisp_parse_error_handler = NULL;
-error_handler_t lisp_syntax_error_handler = NULL;
-
 void
 parse_error(const lisp_t lisp)
 {
-  if (lisp_parse_error_handler != NULL) {
-    lisp_parse_error_handler(lisp);
+  if (lisp->parse_error_handler != NULL) {
+    lisp->parse_error_handler(lisp);
   }
 }
 
 void
 syntax_error(const lisp_t lisp)
 {
-  if (lisp_syntax_error_handler != NULL) {
-    lisp_syntax_error_handler(lisp);
+  if (lisp->syntax_error_handler != NULL) {
+    lisp->syntax_error_handler(lisp);
   }
 }
 
@@ -40,40 +43,42 @@ syntax_error(const lisp_t lisp)
  */
 
 void
-lisp_set_parse_error_handler(const error_handler_t h)
+lisp_set_parse_error_handler(const lisp_t lisp, const error_handler_t h)
 {
-  lisp_parse_error_handler = h;
+  lisp->parse_error_handler = h;
 }
 
 void
-lisp_set_syntax_error_handler(const error_handler_t h)
+lisp_set_syntax_error_handler(const lisp_t lisp, const error_handler_t h)
+{
+  lisp->syntax_error_handler = h;
+}
+
+/*
+ * The prefix is computed once, by the first thread that asks for it.
+ */
+
+static pthread_once_t prefix_once = PTHREAD_ONCE_INIT;
+static char prefix[PATH_MAX] = { 0 };
+
+static void
+lisp_prefix_init()
 {
-  lisp_syntax_error_handler = h;
+  Dl_info dl_info;
+  char buffer[PATH_MAX] = { 0 };
+  if (dladdr(lisp_prefix, &dl_info)) {
+    strncpy(buffer, dl_info.dli_fname, PATH_MAX);
+  } else {
+    strncpy(buffer, "/usr/local/bin/mnml", PATH_MAX);
+  }
+  const char* dname = dirname(dirname(buffer));
+  strcpy(prefix, dname);
 }
 
 const char*
 lisp_prefix()
 {
-  static bool is_set = false;
-  static char prefix[PATH_MAX] = { 0 };
-  /*
-   * Compute this binary path.
-   */
-  if (!is_set) {
-    Dl_info dl_info;
-    char buffer[PATH_MAX] = { 0 };
-    if (dladdr(lisp_prefix, &dl_info)) {
-      strncpy(buffer, dl_info.dli_fname, PATH_MAX);
-    } else {
-      strncpy(buffer, "/usr/local/bin/mnml", PATH_MAX);
-    }
-    const char* dname = dirname(dirname(buffer));
-    strcpy(prefix, dname);
-    is_set = true;
-  }
-  /*
-   * Return the result.
-   */
+  pthread_once(&prefix_once, lisp_prefix_init);
   return prefix;
 }
 
@@ -138,6 +143,19 @@ lisp_equ(const atom_t a, const atom_t b)
       return lisp_equ(CAR(a), CAR(b)) && lisp_equ(CDR(a), CDR(b));
     case T_SYMBOL:
       return lisp_symbol_match(a, &b->symbol);
+    case T_BUFFER:
+      return BUFFER_LEN(a) == BUFFER_LEN(b) &&
+             memcmp(BUFFER_DATA(a), BUFFER_DATA(b), BUFFER_LEN(a)) == 0;
+    case T_ARRAY:
+      return ARRAY_KIND(a) == ARRAY_KIND(b) && ARRAY_LEN(a) == ARRAY_LEN(b) &&
+             memcmp(ARRAY_DATA(a), ARRAY_DATA(b),
+                    ARRAY_LEN(a) * ARRAY_ESIZE(a)) == 0;
+    case T_BIGNUM:
+      return lisp_bignum_cmp(a, b) == 0;
+    case T_ROPE:
+      return lisp_rope_equ(a, b);
+    case T_RECORD:
+      return lisp_record_equ(a, b);
     default:
       return false;
   }
@@ -165,6 +183,12 @@ lisp_neq(const atom_t a, const atom_t b)
       return mismatch || lisp_neq(CAR(a), CAR(b)) || lisp_neq(CDR(a), CDR(b));
     case T_SYMBOL:
       return mismatch || !lisp_symbol_match(a, &b->symbol);
+    case T_BUFFER:
+    case T_ARRAY:
+    case T_BIGNUM:
+    case T_ROPE:
+    case T_RECORD:
+      return mismatch || !lisp_equ(a, b);
     default:
       return mismatch;
   }
@@ -603,7 +627,7 @@ lisp_get_fullpath(const lisp_t lisp, const char* const cwd,
   /*
    * If the expanded path is not absolute, prepend the current CWD.
    */
-  if (expn_buf[0] != '/' && !IS_NULL(lisp->ichan)) {
+  if (expn_buf[0] != '/' && !IO_CONTEXT_EMPTY(lisp->ichan)) {
     strcpy(absl_buf, cwd);
     strcat(absl_buf, "/");
     strcat(absl_buf, expn_buf);
@@ -649,10 +673,10 @@ lisp_load_file(const lisp_t lisp, const char* const filepath)
   /*
    * Get CWD.
    */
-  if (IS_NULL(lisp->ichan)) {
+  if (IO_CONTEXT_EMPTY(lisp->ichan)) {
     strcpy(absl_buf, getenv("PWD"));
   } else {
-    lisp_make_cstring(CAR(CDR(CAR(lisp->ichan))), absl_buf, PATH_MAX, 0);
+    strcpy(absl_buf, IO_CONTEXT(lisp->ichan)->pwd);
   }
   /*
    * Get the fullpath for the file.
@@ -691,7 +715,10 @@ lisp_load_file(const lisp_t lisp, const char* const filepath)
    * Push the context.
    */
   TRACE("Loading %s", path);
-  PUSH_IO_CONTEXT(lisp, lisp->ichan, handle, dir);
+  if (!lisp_chan_push(lisp, &lisp->ichan, handle, dir)) {
+    fclose(handle);
+    return lisp_make_nil(lisp);
+  }
   /*
    * Load all the entries
    */
@@ -704,7 +731,7 @@ lisp_load_file(const lisp_t lisp, const char* const filepath)
   /*
    * Pop the context and return the value.
    */
-  POP_IO_CONTEXT(lisp, lisp->ichan);
+  lisp_chan_pop(lisp, &lisp->ichan);
   fclose(handle);
   return res;
 }
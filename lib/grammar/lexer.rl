@@ -2,11 +2,16 @@
 #include <mnml/lexer.h>
 #include <mnml/slab.h>
 #include <assert.h>
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
 
+#if defined(LISP_ENABLE_SSE) && defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 #include "parser.h"
 #include "parser.c"
 
@@ -19,12 +24,133 @@
 
 extern void parse_error(const lisp_t lisp);
 
-static void
+/*
+ * Return true when a top-level form has been consumed. The scanner then stops
+ * so that the form can be evaluated before the rest of the input is parsed.
+ */
+
+static bool
 lisp_consume_token(const lexer_t lexer)
 {
   if (lexer->depth == 0) {
     Parse(lexer->parser, 0, 0, lexer);
+    return true;
+  }
+  return false;
+}
+
+/*
+ * Vector scanning primitives. Runs of bytes that do not change the state of
+ * the machine are skipped 16 or 32 bytes at a time.
+ */
+
+#ifdef LISP_ENABLE_SSE
+
+#ifdef __AVX2__
+
+#define SCAN_WIDTH 32
+
+typedef __m256i scan_t;
+
+#define SCAN_LOAD(__p)     _mm256_loadu_si256((const __m256i*)(__p))
+#define SCAN_SET(__c)      _mm256_set1_epi8(__c)
+#define SCAN_EQ(__a, __b)  _mm256_cmpeq_epi8(__a, __b)
+#define SCAN_OR(__a, __b)  _mm256_or_si256(__a, __b)
+#define SCAN_SUB(__a, __b) _mm256_sub_epi8(__a, __b)
+#define SCAN_MIN(__a, __b) _mm256_min_epu8(__a, __b)
+#define SCAN_MASK(__a)     ((uint32_t)_mm256_movemask_epi8(__a))
+
+#else
+
+#define SCAN_WIDTH 16
+
+typedef __m128i scan_t;
+
+#define SCAN_LOAD(__p)     _mm_loadu_si128((const __m128i*)(__p))
+#define SCAN_SET(__c)      _mm_set1_epi8(__c)
+#define SCAN_EQ(__a, __b)  _mm_cmpeq_epi8(__a, __b)
+#define SCAN_OR(__a, __b)  _mm_or_si128(__a, __b)
+#define SCAN_SUB(__a, __b) _mm_sub_epi8(__a, __b)
+#define SCAN_MIN(__a, __b) _mm_min_epu8(__a, __b)
+#define SCAN_MASK(__a)     ((uint32_t)_mm_movemask_epi8(__a))
+
+#endif
+
+#endif
+
+/*
+ * Return the first quote or backslash in [P, PE), or PE.
+ */
+
+static const char*
+lexer_skip_string(const char* p, const char* const pe)
+{
+#ifdef SCAN_WIDTH
+  const scan_t quote = SCAN_SET('"');
+  const scan_t bslash = SCAN_SET('\\');
+  for (; pe - p >= SCAN_WIDTH; p += SCAN_WIDTH) {
+    const scan_t v = SCAN_LOAD(p);
+    const scan_t s = SCAN_OR(SCAN_EQ(v, quote), SCAN_EQ(v, bslash));
+    const uint32_t m = SCAN_MASK(s);
+    if (m != 0) {
+      return p + __builtin_ctz(m);
+    }
+  }
+#endif
+  while (p < pe && *p != '"' && *p != '\\') {
+    p += 1;
+  }
+  return p;
+}
+
+/*
+ * Return the first new line in [P, PE), or PE.
+ */
+
+static const char*
+lexer_skip_comment(const char* p, const char* const pe)
+{
+#ifdef SCAN_WIDTH
+  const scan_t eol = SCAN_SET('\n');
+  for (; pe - p >= SCAN_WIDTH; p += SCAN_WIDTH) {
+    const uint32_t m = SCAN_MASK(SCAN_EQ(SCAN_LOAD(p), eol));
+    if (m != 0) {
+      return p + __builtin_ctz(m);
+    }
+  }
+#endif
+  while (p < pe && *p != '\n') {
+    p += 1;
+  }
+  return p;
+}
+
+/*
+ * Return the first byte in [P, PE) that is not a space, or PE. Spaces are ' '
+ * and '\t' through '\r', which is tested as (C - '\t') <= 4, unsigned.
+ */
+
+static const char*
+lexer_skip_space(const char* p, const char* const pe)
+{
+#ifdef SCAN_WIDTH
+  const scan_t blank = SCAN_SET(' ');
+  const scan_t tab = SCAN_SET('\t');
+  const scan_t four = SCAN_SET(4);
+  for (; pe - p >= SCAN_WIDTH; p += SCAN_WIDTH) {
+    const scan_t v = SCAN_LOAD(p);
+    const scan_t c = SCAN_SUB(v, tab);
+    const scan_t s = SCAN_OR(SCAN_EQ(v, blank), SCAN_EQ(SCAN_MIN(c, four), c));
+    const uint32_t m = ~SCAN_MASK(s) & (uint32_t)((1ULL << SCAN_WIDTH) - 1);
+    if (m != 0) {
+      return p + __builtin_ctz(m);
+    }
   }
+#endif
+  while (p < pe && (*p == ' ' || (unsigned char)(*p - '\t') <= 4)) {
+    p += 1;
+  }
+  return p;
 }
 
 %%{
@@ -43,6 +169,29 @@ action parse_error
   fhold; fgoto purge;
 }
 
+#
+# Fast-forward actions. The machine stays in the same state over the bytes that
+# are skipped, so it only resumes at the next byte of interest. The body of a
+# string is not skipped right after a backslash since it may escape a quote.
+#
+
+action skip_string
+{
+  if (fc != '\\') {
+    fexec lexer_skip_string(fpc + 1, pe);
+  }
+}
+
+action skip_comment
+{
+  fexec lexer_skip_comment(fpc + 1, pe);
+}
+
+action skip_space
+{
+  fexec lexer_skip_space(fpc + 1, pe);
+}
+
 action tok_popen
 {
   Parse(lexer->parser, POPEN, 0, lexer);
@@ -57,7 +206,10 @@ action tok_pclose
   }
   Parse(lexer->parser, PCLOSE, 0, lexer);
   lexer->depth -= 1;
-  lisp_consume_token(lexer);
+  if (lisp_consume_token(lexer)) {
+    done = true;
+    fbreak;
+  }
 }
 
 action tok_dot
@@ -87,9 +239,20 @@ action tok_number
   char * val = (char *)alloca(len + 1);
   strncpy(val, start, len);
   val[len] = 0;
+  /*
+   * Numbers that do not fit in 64 bits are parsed as big integers.
+   */
+  errno = 0;
   int64_t value = strtoll(val, NULL, 10);
-  Parse(lexer->parser, NUMBER, (void *)value, lexer);
-  lisp_consume_token(lexer);
+  if (errno == ERANGE) {
+    Parse(lexer->parser, BIGNUM, strdup(val), lexer);
+  } else {
+    Parse(lexer->parser, NUMBER, (void *)value, lexer);
+  }
+  if (lisp_consume_token(lexer)) {
+    done = true;
+    fbreak;
+  }
 }
 
 action tok_char
@@ -121,7 +284,10 @@ action tok_char
   /*
    */
   Parse(lexer->parser, CHAR, (void *)val, lexer);
-  lisp_consume_token(lexer);
+  if (lisp_consume_token(lexer)) {
+    done = true;
+    fbreak;
+  }
 }
 
 action tok_string
@@ -133,25 +299,37 @@ action tok_string
   /*
    */
   Parse(lexer->parser, STRING, val, lexer);
-  lisp_consume_token(lexer);
+  if (lisp_consume_token(lexer)) {
+    done = true;
+    fbreak;
+  }
 }
 
 action tok_nil
 { 
   Parse(lexer->parser, C_NIL, 0, lexer);
-  lisp_consume_token(lexer);
+  if (lisp_consume_token(lexer)) {
+    done = true;
+    fbreak;
+  }
 }
 
 action tok_true
 { 
   Parse(lexer->parser, C_TRUE, 0, lexer);
-  lisp_consume_token(lexer);
+  if (lisp_consume_token(lexer)) {
+    done = true;
+    fbreak;
+  }
 }
 
 action tok_wildcard
 { 
   Parse(lexer->parser, C_WILDCARD, 0, lexer);
-  lisp_consume_token(lexer);
+  if (lisp_consume_token(lexer)) {
+    done = true;
+    fbreak;
+  }
 }
 
 action tok_symbol
@@ -160,7 +338,10 @@ action tok_symbol
   size_t len = te - start;
   MAKE_SYMBOL_DYNAMIC_N(sym, start, len);
   Parse(lexer->parser, SYMBOL, sym, lexer);
-  lisp_consume_token(lexer);
+  if (lisp_consume_token(lexer)) {
+    done = true;
+    fbreak;
+  }
 }
 
 popen   = '(';
@@ -171,10 +352,11 @@ backt   = '`';
 tilde   = '~';
 number  = '-'? digit+;
 char    = '^' . (print - '\\' | "\\\\" | "\\e" | "\\n" | "\\r" | "\\t") $!parse_error;
-string  = '"' . ([^"] | '\\' '"')* . '"';
+string  = '"' @skip_string . ([^"] @skip_string | '\\' '"')* . '"';
 marks   = [!@$%&*_+\-={}\[\]:;|\\<>?,./];
 symbol  = (alpha | marks) . (alnum | marks){,15} $!parse_error;
-comment = '#' . [^\n]*;
+comment = '#' @skip_comment . [^\n]*;
+blanks  = space+ $skip_space;
 
 purge := any* %{ fgoto main; };
 
@@ -214,7 +396,7 @@ main := |*
   # Garbage.
   #
   comment;
-  space;
+  blanks;
 *|;
 
 }%%
@@ -228,6 +410,7 @@ lexer_create(const lisp_t lisp, const lisp_consumer_t consumer)
   %% write init;
   lexer->depth = 0;
   lexer->rem = 0;
+  lexer->off = 0;
   lexer->lisp = lisp;
   lexer->consumer = consumer;
   lexer->parser = ParseAlloc(malloc);
@@ -245,20 +428,31 @@ void
 lexer_parse(const lexer_t lexer, char * const str, const size_t len,
                  const bool end)
 {
-  const char* p = str + lexer->rem;
+  bool done = false;
+  const char* p = str + lexer->off;
   const char* pe = str + len;
   const char* eof = end ? pe : 0;
   %% write exec;
+  /*
+   * Keep the input that has not been scanned yet if we stopped after a form.
+   */
+  if (done && p < pe) {
+    ts = 0;
+    lexer->rem = len;
+    lexer->off = p - str;
+    return;
+  }
   /*
    * Update the local state when there is a prefix to save.
    */
   lexer->rem = 0;
-  if (ts != 0) {
+  if (ts != 0 && !done) {
     lexer->rem = pe - ts;
     memmove(str, ts, lexer->rem);
     te = str + (te - ts);
     ts = str;
   }
+  lexer->off = lexer->rem;
 }
 
 bool
@@ -2,27 +2,28 @@
 
 %token_type { void * }
 %type list  { atom_t }
-%type items { atom_t }
+%type items { builder_t }
 %type prefix { atom_t }
 %type item  { atom_t }
 
 %include
 {
+#include <mnml/bignum.h>
 #include <mnml/lisp.h>
 #include <mnml/utils.h>
 #include <stdlib.h>
 
-extern void syntax_error();
+extern void syntax_error(const lisp_t lisp);
 }
 
 %syntax_error
 {
-  syntax_error();
+  syntax_error(lexer->lisp);
 }
 
 %parse_failure
 {
-  syntax_error();
+  syntax_error(lexer->lisp);
 }
 
 root ::= prefix(A).
@@ -37,29 +38,33 @@ list(A) ::= POPEN PCLOSE.
 
 list(A) ::= POPEN items(B) PCLOSE.
 {
-  A = B;
+  A = B.head;
 }
 
 list(A) ::= POPEN items(B) DOT prefix(C) PCLOSE.
 {
-  A = lisp_conc(lexer->lisp, B, C);
+  lisp_builder_conc(lexer->lisp, &B, C);
+  A = B.head;
 }
 
 items(A) ::= prefix(B).
 {
-  A = lisp_cons(lexer->lisp, B, lisp_make_nil(lexer->lisp));
+  lisp_builder_init(lexer->lisp, &A);
+  lisp_builder_push(lexer->lisp, &A, B);
 }
 
 items(A) ::= items(B) prefix(C).
 {
-  A = lisp_append(lexer->lisp, B, C);
+  A = B;
+  lisp_builder_push(lexer->lisp, &A, C);
 }
 
 items(A) ::= items(B) TILDE prefix(C).
 {
   atom_t nil = lisp_make_nil(lexer->lisp);
   C = lisp_eval(lexer->lisp, nil, C);
-  A = lisp_conc(lexer->lisp, B, C);
+  A = B;
+  lisp_builder_conc(lexer->lisp, &A, C);
   X(lexer->lisp, nil);
 }
 
@@ -85,6 +90,12 @@ item(A) ::= NUMBER(B).
   A = lisp_make_number(lexer->lisp, (int64_t)B);
 }
 
+item(A) ::= BIGNUM(B).
+{
+  A = lisp_make_bignum(lexer->lisp, B, strlen(B));
+  free(B);
+}
+
 item(A) ::= CHAR(B).
 {
   A = lisp_make_char(lexer->lisp, (char)B);
@@ -0,0 +1,59 @@
+#include <mnml/array.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t
+lisp_arr_convert(const lisp_t lisp, const array_kind_t kind, const atom_t cell)
+{
+  const size_t len = ARRAY_LEN(cell);
+  atom_t res = lisp_make_array(lisp, kind, len);
+  if (IS_NULL(res)) {
+    return res;
+  }
+  /*
+   * Copy the content if the kinds match, convert each element otherwise.
+   */
+  if (ARRAY_KIND(cell) == kind) {
+    memcpy(ARRAY_DATA(res), ARRAY_DATA(cell), len * ARRAY_ESIZE(cell));
+  } else {
+    for (size_t i = 0; i < len; i += 1) {
+      lisp_array_set(res, i, lisp_array_get(cell, i));
+    }
+  }
+  return res;
+}
+
+static atom_t USED
+lisp_function_arr(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, KIND, X);
+  array_kind_t kind;
+  /*
+   * Get the kind of the array.
+   */
+  if (!lisp_array_kind(KIND, &kind)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Build the array.
+   */
+  switch (X->type) {
+    case T_NUMBER:
+      if (X->number < 0) {
+        return lisp_make_nil(lisp);
+      }
+      return lisp_make_array(lisp, kind, X->number);
+    case T_NIL:
+    case T_PAIR:
+      return lisp_array_from_list(lisp, kind, X);
+    case T_ARRAY:
+      return lisp_arr_convert(lisp, kind, X);
+    default:
+      return lisp_make_nil(lisp);
+  }
+}
+
+LISP_MODULE_SETUP(arr, arr, KIND, X, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,25 @@
+#include <mnml/array.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_get(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, A, I);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_ARRY(A) || !IS_NUMB(I) || I->number < 0 ||
+      (size_t)I->number >= ARRAY_LEN(A)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Return the element.
+   */
+  return lisp_make_number(lisp, lisp_array_get(A, I->number));
+}
+
+LISP_MODULE_SETUP(get, arr/get, A, I, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
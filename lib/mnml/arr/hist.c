@@ -0,0 +1,74 @@
+#include <mnml/array.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+/*
+ * Count the values in [LO, HI) into N bins of equal width. The offsets are
+ * computed unsigned, as HI - LO may not fit in an int64_t.
+ */
+
+#define HIST_GEN(__t)                                                       \
+  static void lisp_hist_##__t(const __t##_t* const restrict d,              \
+                              const size_t n, int64_t* const restrict bins, \
+                              const int64_t lo, const int64_t hi,           \
+                              const size_t nbins)                           \
+  {                                                                         \
+    const uint64_t range = (uint64_t)hi - (uint64_t)lo;                     \
+    for (size_t i = 0; i < n; i += 1) {                                     \
+      const int64_t v = d[i];                                               \
+      if (v >= lo && v < hi) {                                              \
+        const uint64_t o = (uint64_t)v - (uint64_t)lo;                      \
+        const uint64_t k = ((__uint128_t)o * nbins) / range;                \
+        bins[k < nbins ? k : nbins - 1] += 1;                               \
+      }                                                                     \
+    }                                                                       \
+  }
+
+HIST_GEN(int64);
+HIST_GEN(int32);
+HIST_GEN(uint8);
+
+static atom_t USED
+lisp_function_hist(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, A, LO, HI, N);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_ARRY(A) || !IS_NUMB(LO) || !IS_NUMB(HI) || !IS_NUMB(N) ||
+      LO->number >= HI->number || N->number <= 0) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Allocate the bins.
+   */
+  atom_t res = lisp_make_array(lisp, A_I64, N->number);
+  if (IS_NULL(res)) {
+    return res;
+  }
+  /*
+   * Fill the bins.
+   */
+  const void* data = ARRAY_DATA(A);
+  int64_t* bins = (int64_t*)ARRAY_DATA(res);
+  switch (ARRAY_KIND(A)) {
+    case A_I64:
+      lisp_hist_int64(data, ARRAY_LEN(A), bins, LO->number, HI->number,
+                      N->number);
+      break;
+    case A_I32:
+      lisp_hist_int32(data, ARRAY_LEN(A), bins, LO->number, HI->number,
+                      N->number);
+      break;
+    default:
+      lisp_hist_uint8(data, ARRAY_LEN(A), bins, LO->number, HI->number,
+                      N->number);
+      break;
+  }
+  return res;
+}
+
+LISP_MODULE_SETUP(hist, arr/hist, A, LO, HI, N, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
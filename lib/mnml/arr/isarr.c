@@ -0,0 +1,8 @@
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+PREDICATE_GEN(arr, IS_ARRY, X);
+LISP_MODULE_SETUP(isarr, arr?, X, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
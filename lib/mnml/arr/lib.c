@@ -0,0 +1,36 @@
+#include <mnml/module.h>
+
+LISP_MODULE_DECL(arr);
+LISP_MODULE_DECL(get);
+LISP_MODULE_DECL(hist);
+LISP_MODULE_DECL(isarr);
+LISP_MODULE_DECL(lst);
+LISP_MODULE_DECL(max);
+LISP_MODULE_DECL(min);
+LISP_MODULE_DECL(set);
+LISP_MODULE_DECL(slice);
+LISP_MODULE_DECL(sort);
+LISP_MODULE_DECL(sum);
+
+module_entry_t ENTRIES[] = {
+  LISP_MODULE_REGISTER(arr),   LISP_MODULE_REGISTER(get),
+  LISP_MODULE_REGISTER(hist),  LISP_MODULE_REGISTER(isarr),
+  LISP_MODULE_REGISTER(lst),   LISP_MODULE_REGISTER(max),
+  LISP_MODULE_REGISTER(min),   LISP_MODULE_REGISTER(set),
+  LISP_MODULE_REGISTER(slice), LISP_MODULE_REGISTER(sort),
+  LISP_MODULE_REGISTER(sum),   { NULL, NULL }
+};
+
+const char* USED
+lisp_module_name()
+{
+  return "arr";
+}
+
+const module_entry_t* USED
+lisp_module_entries()
+{
+  return ENTRIES;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
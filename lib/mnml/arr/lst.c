@@ -0,0 +1,18 @@
+#include <mnml/array.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_lst(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, A);
+  if (!IS_ARRY(A)) {
+    return lisp_make_nil(lisp);
+  }
+  return lisp_array_to_list(lisp, A);
+}
+
+LISP_MODULE_SETUP(lst, arr/lst, A, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
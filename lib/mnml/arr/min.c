@@ -0,0 +1,48 @@
+#include <mnml/array.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+/*
+ * Branch-free loops so that the compiler can vectorize them.
+ */
+
+#define MIN_GEN(__t)                                             \
+  static int64_t lisp_min_##__t(const __t##_t* const restrict d, \
+                                const size_t n)                  \
+  {                                                              \
+    __t##_t r = d[0];                                            \
+    for (size_t i = 1; i < n; i += 1) {                          \
+      r = d[i] < r ? d[i] : r;                                   \
+    }                                                            \
+    return r;                                                    \
+  }
+
+MIN_GEN(int64);
+MIN_GEN(int32);
+MIN_GEN(uint8);
+
+static atom_t USED
+lisp_function_min(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, A);
+  if (!IS_ARRY(A) || ARRAY_LEN(A) == 0) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Find the minimum element.
+   */
+  const void* data = ARRAY_DATA(A);
+  switch (ARRAY_KIND(A)) {
+    case A_I64:
+      return lisp_make_number(lisp, lisp_min_int64(data, ARRAY_LEN(A)));
+    case A_I32:
+      return lisp_make_number(lisp, lisp_min_int32(data, ARRAY_LEN(A)));
+    default:
+      return lisp_make_number(lisp, lisp_min_uint8(data, ARRAY_LEN(A)));
+  }
+}
+
+LISP_MODULE_SETUP(min, arr/min, A, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
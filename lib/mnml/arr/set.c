@@ -0,0 +1,29 @@
+#include <mnml/array.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_set(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, A, I, V);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_ARRY(A) || !IS_NUMB(I) || !IS_NUMB(V) || I->number < 0 ||
+      (size_t)I->number >= ARRAY_LEN(A)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Detach the array from its slices and update the element.
+   */
+  if (!lisp_array_own(A)) {
+    return lisp_make_nil(lisp);
+  }
+  lisp_array_set(A, I->number, V->number);
+  return UP(A);
+}
+
+LISP_MODULE_SETUP(set, arr/set, A, I, V, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
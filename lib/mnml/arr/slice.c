@@ -0,0 +1,34 @@
+#include <mnml/array.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_slice(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, A, OFF, LEN);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_ARRY(A) || !IS_NUMB(OFF) || OFF->number < 0) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Compute the length of the slice. It defaults to the rest of the array.
+   */
+  size_t len = ARRAY_LEN(A) - OFF->number;
+  if (IS_NUMB(LEN)) {
+    if (LEN->number < 0) {
+      return lisp_make_nil(lisp);
+    }
+    len = LEN->number;
+  }
+  /*
+   * Share the store.
+   */
+  return lisp_array_slice(lisp, A, OFF->number, len);
+}
+
+LISP_MODULE_SETUP(slice, arr/slice, A, OFF, LEN, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
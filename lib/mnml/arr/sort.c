@@ -0,0 +1,70 @@
+#include <mnml/array.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <stdlib.h>
+
+/*
+ * Comparison functions.
+ */
+
+#define COMPARE_GEN(__t)                                                  \
+  static int lisp_compare_##__t(const void* const a, const void* const b) \
+  {                                                                       \
+    const __t##_t x = *(const __t##_t*)a;                                 \
+    const __t##_t y = *(const __t##_t*)b;                                 \
+    return (x > y) - (x < y);                                             \
+  }
+
+COMPARE_GEN(int64);
+COMPARE_GEN(int32);
+
+/*
+ * Bytes are sorted by counting.
+ */
+
+static void
+lisp_sort_uint8(uint8_t* const data, const size_t len)
+{
+  size_t counts[256] = { 0 };
+  for (size_t i = 0; i < len; i += 1) {
+    counts[data[i]] += 1;
+  }
+  size_t idx = 0;
+  for (size_t v = 0; v < 256; v += 1) {
+    memset(&data[idx], (int)v, counts[v]);
+    idx += counts[v];
+  }
+}
+
+static atom_t USED
+lisp_function_sort(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, A);
+  /*
+   * Detach the array from its slices.
+   */
+  if (!IS_ARRY(A) || !lisp_array_own(A)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Sort the array in place.
+   */
+  void* data = ARRAY_DATA(A);
+  switch (ARRAY_KIND(A)) {
+    case A_I64:
+      qsort(data, ARRAY_LEN(A), sizeof(int64_t), lisp_compare_int64);
+      break;
+    case A_I32:
+      qsort(data, ARRAY_LEN(A), sizeof(int32_t), lisp_compare_int32);
+      break;
+    default:
+      lisp_sort_uint8(data, ARRAY_LEN(A));
+      break;
+  }
+  return UP(A);
+}
+
+LISP_MODULE_SETUP(sort, arr/sort, A, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
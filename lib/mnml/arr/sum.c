@@ -0,0 +1,48 @@
+#include <mnml/array.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+/*
+ * Straight loops without early exits so that the compiler can vectorize them.
+ */
+
+#define SUM_GEN(__t)                                             \
+  static int64_t lisp_sum_##__t(const __t##_t* const restrict d, \
+                                const size_t n)                  \
+  {                                                              \
+    int64_t r = 0;                                               \
+    for (size_t i = 0; i < n; i += 1) {                          \
+      r += d[i];                                                 \
+    }                                                            \
+    return r;                                                    \
+  }
+
+SUM_GEN(int64);
+SUM_GEN(int32);
+SUM_GEN(uint8);
+
+static atom_t USED
+lisp_function_sum(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, A);
+  if (!IS_ARRY(A)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Sum the elements.
+   */
+  const void* data = ARRAY_DATA(A);
+  switch (ARRAY_KIND(A)) {
+    case A_I64:
+      return lisp_make_number(lisp, lisp_sum_int64(data, ARRAY_LEN(A)));
+    case A_I32:
+      return lisp_make_number(lisp, lisp_sum_int32(data, ARRAY_LEN(A)));
+    default:
+      return lisp_make_number(lisp, lisp_sum_uint8(data, ARRAY_LEN(A)));
+  }
+}
+
+LISP_MODULE_SETUP(sum, arr/sum, A, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,56 @@
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+
+static atom_t
+lisp_buf_from_string(const lisp_t lisp, const atom_t cell)
+{
+  /*
+   * Allocate a buffer large enough to hold the string.
+   */
+  const size_t len = lisp_len(cell);
+  atom_t res = lisp_make_buffer(lisp, len);
+  if (IS_NULL(res)) {
+    return res;
+  }
+  /*
+   * Copy the characters.
+   */
+  char* p = lisp_buffer_reserve(res, len);
+  FOREACH(cell, c) {
+    *p++ = (char)c->car->number;
+    NEXT(c);
+  }
+  lisp_buffer_commit(res, len);
+  return res;
+}
+
+static atom_t USED
+lisp_function_buf(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, X);
+  switch (X->type) {
+    case T_NIL:
+      return lisp_make_buffer(lisp, 0);
+    case T_NUMBER:
+      if (X->number < 0) {
+        return lisp_make_nil(lisp);
+      }
+      return lisp_make_buffer(lisp, X->number);
+    case T_PAIR:
+      if (!lisp_is_string(X)) {
+        return lisp_make_nil(lisp);
+      }
+      return lisp_buf_from_string(lisp, X);
+    case T_BUFFER:
+      return lisp_make_buffer_from(lisp, BUFFER_DATA(X), BUFFER_LEN(X));
+    default:
+      return lisp_make_nil(lisp);
+  }
+}
+
+LISP_MODULE_SETUP(buf, buf, X, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
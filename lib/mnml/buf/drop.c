@@ -0,0 +1,25 @@
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_drop(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, B, N);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_BUFF(B) || !IS_NUMB(N) || N->number < 0) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Drop the bytes and return the buffer.
+   */
+  lisp_buffer_consume(B, N->number);
+  return UP(B);
+}
+
+LISP_MODULE_SETUP(drop, buf/drop, B, N, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
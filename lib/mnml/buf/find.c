@@ -0,0 +1,52 @@
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+
+#define FIND_NEEDLE_LEN 256
+
+static atom_t USED
+lisp_function_find(const lisp_t lisp, const atom_t closure)
+{
+  char buffer[FIND_NEEDLE_LEN];
+  const char* needle = buffer;
+  size_t len = 0;
+  /*
+   * Check the arguments.
+   */
+  LISP_ARGS(closure, C, B, X);
+  if (!IS_BUFF(B)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Grab the needle.
+   */
+  switch (X->type) {
+    case T_CHAR:
+      buffer[0] = (char)X->number;
+      len = 1;
+      break;
+    case T_PAIR:
+      if (!lisp_is_string(X) || lisp_len(X) >= FIND_NEEDLE_LEN) {
+        return lisp_make_nil(lisp);
+      }
+      len = lisp_make_cstring(X, buffer, FIND_NEEDLE_LEN - 1, 0);
+      break;
+    case T_BUFFER:
+      needle = BUFFER_DATA(X);
+      len = BUFFER_LEN(X);
+      break;
+    default:
+      return lisp_make_nil(lisp);
+  }
+  /*
+   * Look for the needle.
+   */
+  ssize_t res = len == 0 ? -1 : lisp_buffer_find(B, needle, len);
+  return res < 0 ? lisp_make_nil(lisp) : lisp_make_number(lisp, res);
+}
+
+LISP_MODULE_SETUP(find, buf/find, B, X, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
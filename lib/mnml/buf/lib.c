@@ -0,0 +1,32 @@
+#include <mnml/module.h>
+
+LISP_MODULE_DECL(buf);
+LISP_MODULE_DECL(drop);
+LISP_MODULE_DECL(find);
+LISP_MODULE_DECL(isbuf);
+LISP_MODULE_DECL(read);
+LISP_MODULE_DECL(slice);
+LISP_MODULE_DECL(str);
+LISP_MODULE_DECL(write);
+
+module_entry_t ENTRIES[] = {
+  LISP_MODULE_REGISTER(buf),   LISP_MODULE_REGISTER(drop),
+  LISP_MODULE_REGISTER(find),  LISP_MODULE_REGISTER(isbuf),
+  LISP_MODULE_REGISTER(read),  LISP_MODULE_REGISTER(slice),
+  LISP_MODULE_REGISTER(str),   LISP_MODULE_REGISTER(write),
+  { NULL, NULL }
+};
+
+const char* USED
+lisp_module_name()
+{
+  return "buf";
+}
+
+const module_entry_t* USED
+lisp_module_entries()
+{
+  return ENTRIES;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
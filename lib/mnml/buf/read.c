@@ -0,0 +1,46 @@
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <errno.h>
+#include <unistd.h>
+
+static atom_t USED
+lisp_function_read(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, B, FD);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_BUFF(B) || !IS_NUMB(FD) || FD->number < 0) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Reserve some room at the end of the buffer.
+   */
+  char* p = lisp_buffer_reserve(B, BUFFER_DEFAULT_SIZE);
+  if (p == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Read as much as the store can hold.
+   */
+  const store_t store = B->buffer.store;
+  const size_t room = store->size - (p - store->data);
+  ssize_t ret = 0;
+  do {
+    ret = read((int)FD->number, p, room);
+  } while (ret < 0 && errno == EINTR);
+  /*
+   * Check the result.
+   */
+  if (ret < 0) {
+    return lisp_make_nil(lisp);
+  }
+  lisp_buffer_commit(B, ret);
+  return lisp_make_number(lisp, ret);
+}
+
+LISP_MODULE_SETUP(read, buf/read, B, FD, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,34 @@
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_slice(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, B, OFF, LEN);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_BUFF(B) || !IS_NUMB(OFF) || OFF->number < 0) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Compute the length of the slice. It defaults to the rest of the buffer.
+   */
+  size_t len = BUFFER_LEN(B) - OFF->number;
+  if (IS_NUMB(LEN)) {
+    if (LEN->number < 0) {
+      return lisp_make_nil(lisp);
+    }
+    len = LEN->number;
+  }
+  /*
+   * Share the store.
+   */
+  return lisp_buffer_slice(lisp, B, OFF->number, len);
+}
+
+LISP_MODULE_SETUP(slice, buf/slice, B, OFF, LEN, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
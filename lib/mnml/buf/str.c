@@ -0,0 +1,18 @@
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_str(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, B);
+  if (!IS_BUFF(B)) {
+    return lisp_make_nil(lisp);
+  }
+  return lisp_buffer_to_string(lisp, B);
+}
+
+LISP_MODULE_SETUP(str, buf/str, B, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,38 @@
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <errno.h>
+#include <unistd.h>
+
+static atom_t USED
+lisp_function_write(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, B, FD);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_BUFF(B) || !IS_NUMB(FD) || FD->number < 0) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Flush the printed output and write the content of the buffer.
+   */
+  lisp_flush(lisp);
+  ssize_t ret = 0;
+  do {
+    ret = write((int)FD->number, BUFFER_DATA(B), BUFFER_LEN(B));
+  } while (ret < 0 && errno == EINTR);
+  /*
+   * Check the result and drain what has been written.
+   */
+  if (ret < 0) {
+    return lisp_make_nil(lisp);
+  }
+  lisp_buffer_consume(B, ret);
+  return lisp_make_number(lisp, ret);
+}
+
+LISP_MODULE_SETUP(write, buf/write, B, FD, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
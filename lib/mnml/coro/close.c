@@ -0,0 +1,24 @@
+#include "coro.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_close(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, CH);
+  coro_chan_t* chan = lisp_coro_chan_get(lisp, CH);
+  if (chan == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * A channel is not closed under the coroutines that wait for it.
+   */
+  const bool ok = chan->waiters == NULL && lisp_handle_close(&CORO_CHANS, CH);
+  lisp_handle_put(&CORO_CHANS, CH);
+  return ok ? lisp_make_true(lisp) : lisp_make_nil(lisp);
+}
+
+LISP_MODULE_SETUP(close, coro/close, CH, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
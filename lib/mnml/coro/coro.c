@@ -0,0 +1,551 @@
+#include "coro.h"
+#include <mnml/lisp.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+ * Stacks.
+ */
+
+static void*
+lisp_coro_stack_new(sched_t* const sched)
+{
+  if (sched->nstacks > 0) {
+    sched->nstacks -= 1;
+    return sched->stacks[sched->nstacks];
+  }
+  /*
+   * Map a new stack. Its lowest page is a guard page.
+   */
+  const int prot = PROT_READ | PROT_WRITE;
+  const int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK;
+  void* stack = mmap(NULL, CORO_STACK_SIZE, prot, flags, -1, 0);
+  if (stack == MAP_FAILED) {
+    TRACE("mmap() failed: %s", strerror(errno));
+    return NULL;
+  }
+  mprotect(stack, sysconf(_SC_PAGESIZE), PROT_NONE);
+  return stack;
+}
+
+static void
+lisp_coro_stack_delete(sched_t* const sched, void* const stack)
+{
+  if (sched->nstacks < CORO_STACK_POOL_LEN) {
+    sched->stacks[sched->nstacks] = stack;
+    sched->nstacks += 1;
+    return;
+  }
+  munmap(stack, CORO_STACK_SIZE);
+}
+
+/*
+ * Scheduler.
+ */
+
+sched_t*
+lisp_coro_sched(const lisp_t lisp)
+{
+  if (lisp->scheduler != NULL) {
+    return (sched_t*)lisp->scheduler;
+  }
+  sched_t* sched = (sched_t*)calloc(1, sizeof(sched_t));
+  if (sched == NULL) {
+    return NULL;
+  }
+  sched->epfd = epoll_create1(EPOLL_CLOEXEC);
+  if (sched->epfd < 0) {
+    TRACE("epoll_create1() failed: %s", strerror(errno));
+    free(sched);
+    return NULL;
+  }
+  sched->lisp = lisp;
+  lisp->scheduler = sched;
+  return sched;
+}
+
+static void
+lisp_coro_sched_delete(const lisp_t lisp, sched_t* const sched)
+{
+  for (size_t i = 0; i < sched->nstacks; i += 1) {
+    munmap(sched->stacks[i], CORO_STACK_SIZE);
+  }
+  close(sched->epfd);
+  free(sched->waiters);
+  free(sched);
+  lisp->scheduler = NULL;
+}
+
+static void
+lisp_coro_enqueue(sched_t* const sched, coro_t* const coro)
+{
+  coro->next = NULL;
+  if (sched->tail == NULL) {
+    sched->head = coro;
+  } else {
+    sched->tail->next = coro;
+  }
+  sched->tail = coro;
+}
+
+static coro_t*
+lisp_coro_dequeue(sched_t* const sched)
+{
+  coro_t* coro = sched->head;
+  sched->head = coro->next;
+  if (sched->head == NULL) {
+    sched->tail = NULL;
+  }
+  return coro;
+}
+
+/*
+ * Coroutines.
+ */
+
+static void
+lisp_coro_main(const unsigned int hi, const unsigned int lo)
+{
+  sched_t* const sched = (sched_t*)(((uintptr_t)hi << 32) | (uintptr_t)lo);
+  const lisp_t lisp = sched->lisp;
+  coro_t* const coro = sched->current;
+  /*
+   * Evaluate the call and drop its result. The scheduler is resumed when this
+   * function returns.
+   */
+  atom_t res = lisp_eval(lisp, coro->env, coro->exp);
+  coro->exp = NULL;
+  X(lisp, res);
+  coro->done = true;
+}
+
+static void
+lisp_coro_chan_init(const lisp_t lisp, io_stack_t* const dst,
+                    const io_stack_t* const src, FILE* const handle)
+{
+  *dst = (io_stack_t){ .release = src->release };
+  if (!IO_CONTEXT_EMPTY(*src)) {
+    const io_context_t ctx = IO_CONTEXT(*src);
+    lisp_chan_push(lisp, dst, ctx->handle, ctx->pwd);
+  } else {
+    char pwd[PATH_MAX];
+    if (getcwd(pwd, PATH_MAX) == NULL) {
+      strcpy(pwd, ".");
+    }
+    lisp_chan_push(lisp, dst, handle, pwd);
+  }
+}
+
+static void
+lisp_coro_chan_fini(const lisp_t lisp, io_stack_t* const chan)
+{
+  while (!IO_CONTEXT_EMPTY(*chan)) {
+    lisp_chan_pop(lisp, chan);
+  }
+  for (size_t i = 0; i < chan->cap; i += 1) {
+    free(chan->slots[i].state);
+  }
+  free(chan->slots);
+}
+
+coro_t*
+lisp_coro_spawn(const lisp_t lisp, const atom_t FN, const atom_t ARG)
+{
+  MAKE_SYMBOL_STATIC(fn_s, "FN");
+  sched_t* sched = lisp_coro_sched(lisp);
+  if (sched == NULL) {
+    return NULL;
+  }
+  coro_t* coro = (coro_t*)calloc(1, sizeof(coro_t));
+  if (coro == NULL) {
+    return NULL;
+  }
+  /*
+   * Prepare the context of the coroutine.
+   */
+  coro->stack = lisp_coro_stack_new(sched);
+  if (coro->stack == NULL) {
+    free(coro);
+    return NULL;
+  }
+  const uintptr_t ptr = (uintptr_t)sched;
+  getcontext(&coro->ctx);
+  coro->ctx.uc_stack.ss_sp = coro->stack;
+  coro->ctx.uc_stack.ss_size = CORO_STACK_SIZE;
+  coro->ctx.uc_link = &sched->main;
+  makecontext(&coro->ctx, (void (*)())lisp_coro_main, 2,
+              (unsigned int)(ptr >> 32), (unsigned int)ptr);
+  /*
+   * Bind FN and build (FN 'ARG).
+   */
+  atom_t fun = lisp_make_symbol(lisp, fn_s);
+  atom_t val = lisp_cons(lisp, UP(fun), UP(FN));
+  coro->env = lisp_cons(lisp, val, lisp_make_nil(lisp));
+  atom_t arg = lisp_cons(lisp, lisp_make_quote(lisp), UP(ARG));
+  atom_t cn0 = lisp_cons(lisp, arg, lisp_make_nil(lisp));
+  coro->exp = lisp_cons(lisp, fun, cn0);
+  /*
+   * Start with the current channels of the caller.
+   */
+  lisp_coro_chan_init(lisp, &coro->ichan, &lisp->ichan, stdin);
+  lisp_coro_chan_init(lisp, &coro->ochan, &lisp->ochan, stdout);
+  /*
+   * Queue the coroutine.
+   */
+  lisp_coro_enqueue(sched, coro);
+  sched->count += 1;
+  return coro;
+}
+
+static void
+lisp_coro_delete(const lisp_t lisp, sched_t* const sched, coro_t* const coro)
+{
+  lisp_coro_chan_fini(lisp, &coro->ichan);
+  lisp_coro_chan_fini(lisp, &coro->ochan);
+  X(lisp, coro->env);
+  lisp_coro_stack_delete(sched, coro->stack);
+  free(coro);
+  sched->count -= 1;
+}
+
+/*
+ * Switch the channels of the context with those of CORO.
+ */
+
+static void
+lisp_coro_swap(const lisp_t lisp, coro_t* const coro)
+{
+  const io_stack_t ichan = lisp->ichan;
+  const io_stack_t ochan = lisp->ochan;
+  lisp->ichan = coro->ichan;
+  lisp->ochan = coro->ochan;
+  coro->ichan = ichan;
+  coro->ochan = ochan;
+}
+
+static void
+lisp_coro_resume(const lisp_t lisp, sched_t* const sched, coro_t* const coro)
+{
+  sched->current = coro;
+  lisp_coro_swap(lisp, coro);
+  swapcontext(&sched->main, &coro->ctx);
+  lisp_coro_swap(lisp, coro);
+  sched->current = NULL;
+}
+
+/*
+ * Return to the scheduler. The output of the coroutine is flushed so that it
+ * is not interleaved with the output of the others.
+ */
+
+static void
+lisp_coro_suspend(const lisp_t lisp, sched_t* const sched)
+{
+  coro_t* const coro = sched->current;
+  lisp_flush(lisp);
+  swapcontext(&coro->ctx, &sched->main);
+}
+
+void
+lisp_coro_yield(const lisp_t lisp)
+{
+  sched_t* const sched = (sched_t*)lisp->scheduler;
+  lisp_coro_enqueue(sched, sched->current);
+  lisp_coro_suspend(lisp, sched);
+}
+
+void
+lisp_coro_park(const lisp_t lisp, coro_t** const waiters)
+{
+  sched_t* const sched = (sched_t*)lisp->scheduler;
+  coro_t* const coro = sched->current;
+  coro->next = *waiters;
+  *waiters = coro;
+  lisp_coro_suspend(lisp, sched);
+}
+
+void
+lisp_coro_wake(const lisp_t lisp, coro_t** const waiters)
+{
+  sched_t* const sched = (sched_t*)lisp->scheduler;
+  coro_t* coro = *waiters;
+  while (coro != NULL) {
+    coro_t* next = coro->next;
+    lisp_coro_enqueue(sched, coro);
+    coro = next;
+  }
+  *waiters = NULL;
+}
+
+/*
+ * Descriptors. The descriptors are registered as one-shot events, so that they
+ * are disabled once they fire without being removed from the epoll set.
+ */
+
+static bool
+lisp_coro_watch(sched_t* const sched, const int fd)
+{
+  uint32_t mask = EPOLLONESHOT;
+  for (coro_t* c = sched->waiters[fd]; c != NULL; c = c->next) {
+    mask |= c->events;
+  }
+  struct epoll_event evt = { .events = mask, .data.fd = fd };
+  if (epoll_ctl(sched->epfd, EPOLL_CTL_MOD, fd, &evt) == 0) {
+    return true;
+  }
+  if (errno == ENOENT && epoll_ctl(sched->epfd, EPOLL_CTL_ADD, fd, &evt) == 0) {
+    return true;
+  }
+  TRACE("epoll_ctl() failed: %s", strerror(errno));
+  return false;
+}
+
+static bool
+lisp_coro_grow(sched_t* const sched, const int fd)
+{
+  if ((size_t)fd < sched->nwaiters) {
+    return true;
+  }
+  size_t len = sched->nwaiters == 0 ? 64 : sched->nwaiters;
+  while (len <= (size_t)fd) {
+    len <<= 1;
+  }
+  coro_t** waiters = (coro_t**)realloc(sched->waiters, len * sizeof(coro_t*));
+  if (waiters == NULL) {
+    return false;
+  }
+  memset(&waiters[sched->nwaiters], 0,
+         (len - sched->nwaiters) * sizeof(coro_t*));
+  sched->waiters = waiters;
+  sched->nwaiters = len;
+  return true;
+}
+
+static bool
+lisp_coro_wait(const lisp_t lisp, const int fd, const short events)
+{
+  sched_t* const sched = (sched_t*)lisp->scheduler;
+  coro_t* const coro = sched->current;
+  if (fd < 0 || !lisp_coro_grow(sched, fd)) {
+    return false;
+  }
+  /*
+   * Add the coroutine to the waiters of the descriptor.
+   */
+  coro->events = (events & POLLIN ? EPOLLIN : 0) |
+                 (events & POLLOUT ? EPOLLOUT : 0);
+  coro->revents = 0;
+  coro->next = sched->waiters[fd];
+  sched->waiters[fd] = coro;
+  if (!lisp_coro_watch(sched, fd)) {
+    sched->waiters[fd] = coro->next;
+    return false;
+  }
+  /*
+   * Wait for the scheduler to resume it.
+   */
+  sched->parked += 1;
+  lisp_coro_suspend(lisp, sched);
+  return true;
+}
+
+/*
+ * Queue the coroutines whose descriptors are ready. Wait for them for at most
+ * TMOUT milliseconds.
+ */
+
+static bool
+lisp_coro_poll(sched_t* const sched, const int tmout)
+{
+  struct epoll_event evts[CORO_BATCH_LEN];
+  int res;
+  do {
+    res = epoll_wait(sched->epfd, evts, CORO_BATCH_LEN, tmout);
+  } while (res < 0 && errno == EINTR);
+  if (res < 0) {
+    TRACE("epoll_wait() failed: %s", strerror(errno));
+    return false;
+  }
+  for (int i = 0; i < res; i += 1) {
+    const int fd = evts[i].data.fd;
+    uint32_t mask = evts[i].events;
+    if (mask & (EPOLLERR | EPOLLHUP)) {
+      mask |= EPOLLIN | EPOLLOUT;
+    }
+    /*
+     * Queue the waiters of the descriptor that can proceed.
+     */
+    coro_t** link = &sched->waiters[fd];
+    while (*link != NULL) {
+      coro_t* const coro = *link;
+      if ((coro->events & mask) == 0) {
+        link = &coro->next;
+        continue;
+      }
+      *link = coro->next;
+      coro->revents = evts[i].events;
+      lisp_coro_enqueue(sched, coro);
+      sched->parked -= 1;
+    }
+    /*
+     * Re-arm the descriptor for the others.
+     */
+    if (sched->waiters[fd] != NULL) {
+      lisp_coro_watch(sched, fd);
+    }
+  }
+  return true;
+}
+
+int64_t
+lisp_coro_run(const lisp_t lisp)
+{
+  sched_t* sched = lisp_coro_sched(lisp);
+  if (sched == NULL || lisp->wait_handler != NULL) {
+    return -1;
+  }
+  /*
+   * Flush the output of the caller and let blocking calls park coroutines.
+   */
+  lisp_flush(lisp);
+  lisp->wait_handler = lisp_coro_wait;
+  /*
+   * Run the coroutines. The descriptors are checked when no coroutine is
+   * ready, and after every batch of resumptions so that busy coroutines do not
+   * starve the others.
+   */
+  size_t ticks = 0;
+  while (sched->count > 0) {
+    const bool idle = sched->head == NULL;
+    if (idle || (sched->parked > 0 && ++ticks == CORO_BATCH_LEN)) {
+      ticks = 0;
+      if (idle && sched->parked == 0) {
+        break;
+      }
+      if (!lisp_coro_poll(sched, idle ? -1 : 0)) {
+        break;
+      }
+      continue;
+    }
+    coro_t* const coro = lisp_coro_dequeue(sched);
+    lisp_coro_resume(lisp, sched, coro);
+    if (coro->done) {
+      lisp_coro_delete(lisp, sched, coro);
+    }
+  }
+  lisp->wait_handler = NULL;
+  /*
+   * Return the number of blocked coroutines. They are resumed by the next run.
+   */
+  const int64_t left = sched->count;
+  if (left == 0) {
+    lisp_coro_sched_delete(lisp, sched);
+  }
+  return left;
+}
+
+/*
+ * Channels.
+ */
+
+static void
+lisp_coro_chan_release(void* const ptr)
+{
+  lisp_coro_chan_delete((coro_chan_t*)ptr);
+}
+
+handle_table_t CORO_CHANS = HANDLE_TABLE_INIT(lisp_coro_chan_release);
+
+static void DESTRUCTOR
+lisp_coro_fini()
+{
+  lisp_handle_fini(&CORO_CHANS);
+}
+
+coro_chan_t*
+lisp_coro_chan_new(const lisp_t lisp)
+{
+  coro_chan_t* chan = (coro_chan_t*)malloc(sizeof(coro_chan_t));
+  if (chan == NULL) {
+    return NULL;
+  }
+  chan->lisp = lisp;
+  chan->head = lisp_make_nil(lisp);
+  chan->last = NULL;
+  chan->waiters = NULL;
+  return chan;
+}
+
+void
+lisp_coro_chan_delete(coro_chan_t* const chan)
+{
+  X(chan->lisp, chan->head);
+  free(chan);
+}
+
+coro_chan_t*
+lisp_coro_chan_get(const lisp_t lisp, const atom_t CH)
+{
+  coro_chan_t* chan = lisp_handle_get(&CORO_CHANS, CH);
+  if (chan != NULL && chan->lisp != lisp) {
+    lisp_handle_put(&CORO_CHANS, CH);
+    return NULL;
+  }
+  return chan;
+}
+
+void
+lisp_coro_chan_push(const lisp_t lisp, coro_chan_t* const chan,
+                    const atom_t value)
+{
+  atom_t con = lisp_cons(lisp, value, lisp_make_nil(lisp));
+  /*
+   * Append the value to the queue.
+   */
+  if (IS_NULL(chan->head)) {
+    X(lisp, chan->head);
+    chan->head = con;
+  } else {
+    X(lisp, CDR(chan->last));
+    CDR(chan->last) = con;
+  }
+  chan->last = con;
+  /*
+   * Wake up the receivers.
+   */
+  if (chan->waiters != NULL) {
+    lisp_coro_wake(lisp, &chan->waiters);
+  }
+}
+
+atom_t
+lisp_coro_chan_pop(const lisp_t lisp, coro_chan_t* const chan)
+{
+  sched_t* const sched = (sched_t*)lisp->scheduler;
+  /*
+   * Wait for a value. Outside of a coroutine, nothing could send one.
+   */
+  while (IS_NULL(chan->head)) {
+    if (sched == NULL || sched->current == NULL) {
+      return NULL;
+    }
+    lisp_coro_park(lisp, &chan->waiters);
+  }
+  /*
+   * Pop the first value.
+   */
+  atom_t head = chan->head;
+  atom_t res = UP(CAR(head));
+  chan->head = UP(CDR(head));
+  X(lisp, head);
+  return res;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
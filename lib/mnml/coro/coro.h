@@ -0,0 +1,145 @@
+#pragma once
+
+#include <mnml/handle.h>
+#include <mnml/lisp.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <ucontext.h>
+
+/*
+ * Stack size of the coroutines. The evaluator is recursive, so they get as much
+ * stack as a thread. The stacks are not reserved, so only the pages that are
+ * used cost memory.
+ */
+
+#define CORO_STACK_SIZE (8 * 1024 * 1024)
+
+/*
+ * Number of stacks kept for reuse by the scheduler.
+ */
+
+#define CORO_STACK_POOL_LEN 64
+
+/*
+ * Size of the batch of events delivered by a single wait.
+ */
+
+#define CORO_BATCH_LEN 256
+
+/*
+ * Coroutine. A coroutine evaluates (FN 'ARG) in ENV on its own stack, with its
+ * own input and output channels. NEXT links it in the run queue of the
+ * scheduler or in the list of the coroutines that wait for a descriptor or a
+ * channel. EVENTS holds the events it waits for and REVENTS the events that
+ * woke it up.
+ */
+
+typedef struct coro
+{
+  struct coro* next;
+  ucontext_t ctx;
+  void* stack;
+  atom_t env;
+  atom_t exp;
+  io_stack_t ichan;
+  io_stack_t ochan;
+  uint32_t events;
+  uint32_t revents;
+  bool done;
+} coro_t;
+
+/*
+ * Scheduler of context LISP. The ready coroutines are queued from HEAD to TAIL.
+ * Coroutines that wait for a descriptor are kept in WAITERS, indexed by the
+ * descriptor, and the descriptor is watched by the epoll set EPFD. COUNT is
+ * the number of live coroutines and PARKED the number of those that wait for a
+ * descriptor.
+ */
+
+typedef struct sched
+{
+  lisp_t lisp;
+  ucontext_t main;
+  coro_t* current;
+  coro_t* head;
+  coro_t* tail;
+  size_t count;
+  size_t parked;
+  int epfd;
+  coro_t** waiters;
+  size_t nwaiters;
+  void* stacks[CORO_STACK_POOL_LEN];
+  size_t nstacks;
+} sched_t;
+
+/*
+ * Get the scheduler of a context, creating it if necessary.
+ */
+
+sched_t* lisp_coro_sched(const lisp_t lisp);
+
+/*
+ * Create a coroutine that calls FN with ARG and queue it.
+ */
+
+coro_t* lisp_coro_spawn(const lisp_t lisp, const atom_t FN, const atom_t ARG);
+
+/*
+ * Run the coroutines until none of them can make progress. Return the number
+ * of coroutines left waiting, or -1 if the scheduler is already running.
+ */
+
+int64_t lisp_coro_run(const lisp_t lisp);
+
+/*
+ * Park the current coroutine at the end of the run queue.
+ */
+
+void lisp_coro_yield(const lisp_t lisp);
+
+/*
+ * Park the current coroutine in the list at WAITERS. It is resumed once it has
+ * been moved back to the run queue by lisp_coro_wake.
+ */
+
+void lisp_coro_park(const lisp_t lisp, coro_t** const waiters);
+
+/*
+ * Move the coroutines of the list at WAITERS to the run queue.
+ */
+
+void lisp_coro_wake(const lisp_t lisp, coro_t** const waiters);
+
+/*
+ * Channel. Values are queued from HEAD to LAST and shared with the receiver,
+ * as all coroutines run in the same context LISP. WAITERS are the coroutines
+ * that wait for a value.
+ */
+
+typedef struct coro_chan
+{
+  lisp_t lisp;
+  atom_t head;
+  atom_t last;
+  coro_t* waiters;
+} coro_chan_t;
+
+coro_chan_t* lisp_coro_chan_new(const lisp_t lisp);
+void lisp_coro_chan_delete(coro_chan_t* const chan);
+
+/*
+ * Channels are handed out as handles of CORO_CHANS. Get the channel of handle
+ * CH in context LISP, or NULL if CH is not an open channel of LISP. The channel
+ * must be released with lisp_handle_put.
+ */
+
+extern handle_table_t CORO_CHANS;
+
+coro_chan_t* lisp_coro_chan_get(const lisp_t lisp, const atom_t CH);
+
+void lisp_coro_chan_push(const lisp_t lisp, coro_chan_t* const chan,
+                         const atom_t value);
+atom_t lisp_coro_chan_pop(const lisp_t lisp, coro_chan_t* const chan);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,32 @@
+#include <mnml/module.h>
+
+LISP_MODULE_DECL(chan);
+LISP_MODULE_DECL(close);
+LISP_MODULE_DECL(recv);
+LISP_MODULE_DECL(run);
+LISP_MODULE_DECL(send);
+LISP_MODULE_DECL(spawn);
+LISP_MODULE_DECL(wait);
+LISP_MODULE_DECL(yield);
+
+module_entry_t ENTRIES[] = {
+  LISP_MODULE_REGISTER(chan),  LISP_MODULE_REGISTER(close),
+  LISP_MODULE_REGISTER(recv),  LISP_MODULE_REGISTER(run),
+  LISP_MODULE_REGISTER(send),  LISP_MODULE_REGISTER(spawn),
+  LISP_MODULE_REGISTER(wait),  LISP_MODULE_REGISTER(yield),
+  { NULL, NULL }
+};
+
+const char* USED
+lisp_module_name()
+{
+  return "coro";
+}
+
+const module_entry_t* USED
+lisp_module_entries()
+{
+  return ENTRIES;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
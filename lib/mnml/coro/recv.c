@@ -0,0 +1,21 @@
+#include "coro.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_recv(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, CH);
+  coro_chan_t* chan = lisp_coro_chan_get(lisp, CH);
+  if (chan == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  atom_t res = lisp_coro_chan_pop(lisp, chan);
+  lisp_handle_put(&CORO_CHANS, CH);
+  return res == NULL ? lisp_make_nil(lisp) : res;
+}
+
+LISP_MODULE_SETUP(recv, coro/recv, CH, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
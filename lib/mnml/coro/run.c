@@ -0,0 +1,15 @@
+#include "coro.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_run(const lisp_t lisp, UNUSED const atom_t closure)
+{
+  const int64_t res = lisp_coro_run(lisp);
+  return res < 0 ? lisp_make_nil(lisp) : lisp_make_number(lisp, res);
+}
+
+LISP_MODULE_SETUP(run, coro/run)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
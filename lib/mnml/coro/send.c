@@ -0,0 +1,21 @@
+#include "coro.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_send(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, CH, VAL);
+  coro_chan_t* chan = lisp_coro_chan_get(lisp, CH);
+  if (chan == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  lisp_coro_chan_push(lisp, chan, UP(VAL));
+  lisp_handle_put(&CORO_CHANS, CH);
+  return lisp_make_true(lisp);
+}
+
+LISP_MODULE_SETUP(send, coro/send, CH, VAL, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,19 @@
+#include "coro.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_spawn(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, FN, ARG);
+  if (IS_NULL(FN)) {
+    return lisp_make_nil(lisp);
+  }
+  coro_t* coro = lisp_coro_spawn(lisp, FN, ARG);
+  return coro == NULL ? lisp_make_nil(lisp) : lisp_make_true(lisp);
+}
+
+LISP_MODULE_SETUP(spawn, coro/spawn, FN, ARG, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
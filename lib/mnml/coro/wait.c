@@ -0,0 +1,60 @@
+#include "coro.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <poll.h>
+
+/*
+ * Convert a list of IN and OUT symbols into a poll mask. Return false if one
+ * of the symbols is unknown.
+ */
+
+static bool
+lisp_coro_events(const atom_t cell, short* const events)
+{
+  *events = 0;
+  if (!IS_LIST(cell)) {
+    return false;
+  }
+  FOREACH(cell, p)
+  {
+    if (IS_SYMB(p->car) && lisp_symbol_equal(p->car, "in")) {
+      *events |= POLLIN;
+    } else if (IS_SYMB(p->car) && lisp_symbol_equal(p->car, "out")) {
+      *events |= POLLOUT;
+    } else {
+      return false;
+    }
+    NEXT(p);
+  }
+  return true;
+}
+
+static atom_t USED
+lisp_function_wait(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, FD, EVENTS);
+  /*
+   * Check the arguments. Wait for input by default.
+   */
+  short events;
+  if (!IS_NUMB(FD) || FD->number < 0 || FD->number >= UINT32_MAX ||
+      !lisp_coro_events(EVENTS, &events)) {
+    return lisp_make_nil(lisp);
+  }
+  if (events == 0) {
+    events = POLLIN;
+  }
+  /*
+   * Wait for the descriptor.
+   */
+  if (!lisp_wait(lisp, (int)FD->number, events)) {
+    return lisp_make_nil(lisp);
+  }
+  return lisp_make_true(lisp);
+}
+
+LISP_MODULE_SETUP(wait, coro/wait, FD, EVENTS, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,19 @@
+#include "coro.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_yield(const lisp_t lisp, UNUSED const atom_t closure)
+{
+  sched_t* sched = (sched_t*)lisp->scheduler;
+  if (sched == NULL || sched->current == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  lisp_coro_yield(lisp);
+  return lisp_make_true(lisp);
+}
+
+LISP_MODULE_SETUP(yield, coro/yield)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,16 @@
+#include "event.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <sys/epoll.h>
+
+static atom_t USED
+lisp_function_add(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, EP, FD, EVENTS);
+  return lisp_event_ctl(lisp, EPOLL_CTL_ADD, EP, FD, EVENTS);
+}
+
+LISP_MODULE_SETUP(add, event/add, EP, FD, EVENTS, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
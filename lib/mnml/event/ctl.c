@@ -0,0 +1,94 @@
+#include "event.h"
+#include <mnml/lisp.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+
+/*
+ * Event symbols. The first ones can be registered, the last ones are only
+ * reported.
+ */
+
+static const struct
+{
+  const char* name;
+  uint32_t mask;
+  bool input;
+} EVENT_NAMES[] = {
+  { "in", EPOLLIN, true },           { "out", EPOLLOUT, true },
+  { "rdhup", EPOLLRDHUP, true },     { "et", EPOLLET, true },
+  { "oneshot", EPOLLONESHOT, true }, { "err", EPOLLERR, false },
+  { "hup", EPOLLHUP, false },
+};
+
+#define EVENT_NAMES_LEN (sizeof(EVENT_NAMES) / sizeof(EVENT_NAMES[0]))
+
+bool
+lisp_event_mask(const atom_t cell, uint32_t* const mask)
+{
+  *mask = 0;
+  if (!IS_LIST(cell)) {
+    return false;
+  }
+  FOREACH(cell, p)
+  {
+    size_t i = 0;
+    if (!IS_SYMB(p->car)) {
+      return false;
+    }
+    for (; i < EVENT_NAMES_LEN; i += 1) {
+      const char* const name = EVENT_NAMES[i].name;
+      if (EVENT_NAMES[i].input && lisp_symbol_equal(p->car, name)) {
+        *mask |= EVENT_NAMES[i].mask;
+        break;
+      }
+    }
+    if (i == EVENT_NAMES_LEN) {
+      return false;
+    }
+    NEXT(p);
+  }
+  return true;
+}
+
+atom_t
+lisp_event_list(const lisp_t lisp, const uint32_t mask)
+{
+  builder_t bld;
+  lisp_builder_init(lisp, &bld);
+  for (size_t i = 0; i < EVENT_NAMES_LEN; i += 1) {
+    if (mask & EVENT_NAMES[i].mask) {
+      const char* const name = EVENT_NAMES[i].name;
+      atom_t sym = lisp_make_symbol_from_string(lisp, name, strlen(name));
+      lisp_builder_push(lisp, &bld, sym);
+    }
+  }
+  return bld.head;
+}
+
+atom_t
+lisp_event_ctl(const lisp_t lisp, const int op, const atom_t EP,
+               const atom_t FD, const atom_t EVENTS)
+{
+  /*
+   * Check the arguments.
+   */
+  uint32_t mask = 0;
+  if (!IS_NUMB(EP) || !IS_NUMB(FD) || EP->number < 0 || FD->number < 0 ||
+      (op != EPOLL_CTL_DEL && !lisp_event_mask(EVENTS, &mask))) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Update the interest set.
+   */
+  struct epoll_event evt = { .events = mask, .data.fd = (int)FD->number };
+  if (epoll_ctl((int)EP->number, op, (int)FD->number, &evt) < 0) {
+    TRACE("epoll_ctl() failed: %s", strerror(errno));
+    return lisp_make_nil(lisp);
+  }
+  return lisp_make_true(lisp);
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <mnml/lisp.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Size of the batch of events delivered by a single wait.
+ */
+
+#define EVENT_BATCH_LEN 256
+
+/*
+ * Convert a list of event symbols into an epoll mask. Return false if one of
+ * the symbols is unknown.
+ */
+
+bool lisp_event_mask(const atom_t cell, uint32_t* const mask);
+
+/*
+ * Convert an epoll mask into a list of event symbols.
+ */
+
+atom_t lisp_event_list(const lisp_t lisp, const uint32_t mask);
+
+/*
+ * Apply the control operation OP for descriptor FD to the event set EP.
+ */
+
+atom_t lisp_event_ctl(const lisp_t lisp, const int op, const atom_t EP,
+                      const atom_t FD, const atom_t EVENTS);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,28 @@
+#include <mnml/module.h>
+
+LISP_MODULE_DECL(add);
+LISP_MODULE_DECL(del);
+LISP_MODULE_DECL(mod);
+LISP_MODULE_DECL(new);
+LISP_MODULE_DECL(wait);
+
+module_entry_t ENTRIES[] = { LISP_MODULE_REGISTER(add),
+                             LISP_MODULE_REGISTER(del),
+                             LISP_MODULE_REGISTER(mod),
+                             LISP_MODULE_REGISTER(new),
+                             LISP_MODULE_REGISTER(wait),
+                             { NULL, NULL } };
+
+const char* USED
+lisp_module_name()
+{
+  return "event";
+}
+
+const module_entry_t* USED
+lisp_module_entries()
+{
+  return ENTRIES;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,21 @@
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+
+static atom_t USED
+lisp_function_new(const lisp_t lisp, UNUSED const atom_t closure)
+{
+  const int fd = epoll_create1(EPOLL_CLOEXEC);
+  if (fd < 0) {
+    TRACE("epoll_create1() failed: %s", strerror(errno));
+    return lisp_make_nil(lisp);
+  }
+  return lisp_make_number(lisp, fd);
+}
+
+LISP_MODULE_SETUP(new, event/new)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,86 @@
+#include "event.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/epoll.h>
+
+static atom_t
+lisp_event_collect(const lisp_t lisp, const struct epoll_event* const evts,
+                   const int count)
+{
+  builder_t bld;
+  lisp_builder_init(lisp, &bld);
+  for (int i = 0; i < count; i += 1) {
+    atom_t fdn = lisp_make_number(lisp, evts[i].data.fd);
+    atom_t lst = lisp_event_list(lisp, evts[i].events);
+    lisp_builder_push(lisp, &bld, lisp_cons(lisp, fdn, lst));
+  }
+  return bld.head;
+}
+
+static void
+lisp_event_dispatch(const lisp_t lisp, const atom_t closure,
+                    const struct epoll_event* const evts, const int count)
+{
+  MAKE_SYMBOL_STATIC(fn_s, "FN");
+  for (int i = 0; i < count; i += 1) {
+    /*
+     * Build (FN FD 'EVENTS).
+     */
+    atom_t lst = lisp_event_list(lisp, evts[i].events);
+    atom_t qte = lisp_cons(lisp, lisp_make_quote(lisp), lst);
+    atom_t cn0 = lisp_cons(lisp, qte, lisp_make_nil(lisp));
+    atom_t fdn = lisp_make_number(lisp, evts[i].data.fd);
+    atom_t cn1 = lisp_cons(lisp, fdn, cn0);
+    atom_t cn2 = lisp_cons(lisp, lisp_make_symbol(lisp, fn_s), cn1);
+    /*
+     * Call the callback and drop its result.
+     */
+    atom_t res = lisp_eval(lisp, closure, cn2);
+    X(lisp, res);
+  }
+}
+
+static atom_t USED
+lisp_function_wait(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, EP, TIMEOUT, FN);
+  /*
+   * Check the arguments. A NIL timeout waits forever.
+   */
+  if (!IS_NUMB(EP) || EP->number < 0 ||
+      !(IS_NULL(TIMEOUT) || IS_NUMB(TIMEOUT))) {
+    return lisp_make_nil(lisp);
+  }
+  const int tmout = IS_NULL(TIMEOUT) ? -1 : (int)TIMEOUT->number;
+  /*
+   * Wait for a batch of events.
+   */
+  int res;
+  struct epoll_event evts[EVENT_BATCH_LEN];
+  do {
+    res = epoll_wait((int)EP->number, evts, EVENT_BATCH_LEN, tmout);
+  } while (res < 0 && errno == EINTR);
+  if (res < 0) {
+    TRACE("epoll_wait() failed: %s", strerror(errno));
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Return the events if there is no callback.
+   */
+  if (IS_NULL(FN)) {
+    return lisp_event_collect(lisp, evts, res);
+  }
+  /*
+   * Otherwise call the callback for each event and return their count.
+   */
+  lisp_event_dispatch(lisp, closure, evts, res);
+  return lisp_make_number(lisp, res);
+}
+
+LISP_MODULE_SETUP(wait, event/wait, EP, TIMEOUT, FN, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
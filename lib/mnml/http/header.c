@@ -0,0 +1,47 @@
+#include "http.h"
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <string.h>
+#include <strings.h>
+
+static atom_t USED
+lisp_function_header(const lisp_t lisp, const atom_t closure)
+{
+  char name[LISP_SYMBOL_LENGTH * 8];
+  size_t len = 0;
+  LISP_ARGS(closure, C, HDRS, NAME);
+  /*
+   * Get the NAME.
+   */
+  if (IS_SYMB(NAME)) {
+    len = strnlen(NAME->symbol.val, LISP_SYMBOL_LENGTH);
+    memcpy(name, NAME->symbol.val, len);
+  } else if (lisp_is_string(NAME) && lisp_len(NAME) < sizeof(name)) {
+    len = lisp_make_cstring(NAME, name, sizeof(name), 0);
+  } else {
+    return lisp_make_nil(lisp);
+  }
+  if (!IS_LIST(HDRS)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Look for the header, ignoring the case.
+   */
+  FOREACH(HDRS, p)
+  {
+    const atom_t hdr = p->car;
+    if (IS_PAIR(hdr) && IS_BUFF(CAR(hdr)) && BUFFER_LEN(CAR(hdr)) == len &&
+        strncasecmp(BUFFER_DATA(CAR(hdr)), name, len) == 0) {
+      return UP(CDR(hdr));
+    }
+    NEXT(p);
+  }
+  return lisp_make_nil(lisp);
+}
+
+LISP_MODULE_SETUP(header, http/header, HDRS, NAME, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <mnml/lisp.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/*
+ * Parser limits and results.
+ */
+
+#define HTTP_MAX_HEADERS 64
+#define HTTP_INCOMPLETE -2
+#define HTTP_INVALID -1
+
+/*
+ * Parsed messages point into the parsed data.
+ */
+
+typedef struct http_span
+{
+  const char* data;
+  size_t len;
+} http_span_t;
+
+typedef struct http_header
+{
+  http_span_t name;
+  http_span_t value;
+} http_header_t;
+
+typedef struct http_head
+{
+  http_span_t method;
+  http_span_t path;
+  http_span_t reason;
+  int status;
+  int minor;
+  size_t count;
+  http_header_t headers[HTTP_MAX_HEADERS];
+} http_head_t;
+
+/*
+ * Parse the head of a request or of a response. Return the length of the head,
+ * HTTP_INCOMPLETE if more data is needed, or HTTP_INVALID.
+ */
+
+ssize_t lisp_http_parse_request(const char* const data, const size_t len,
+                                http_head_t* const head);
+ssize_t lisp_http_parse_response(const char* const data, const size_t len,
+                                 http_head_t* const head);
+
+/*
+ * Find the header NAME of length LEN, ignoring the case. Return NULL if the
+ * header is not present.
+ */
+
+const http_header_t* lisp_http_find(const http_head_t* const head,
+                                    const char* const name, const size_t len);
+
+/*
+ * Parse the value of a Content-Length header. Return false if it is invalid.
+ */
+
+bool lisp_http_length(const http_span_t* const span, size_t* const len);
+
+/*
+ * Build the list of (NAME . VALUE) slices of the headers parsed from buffer B.
+ */
+
+atom_t lisp_http_headers(const lisp_t lisp, const atom_t B,
+                         const http_head_t* const head);
+
+/*
+ * Make a slice of buffer B out of a span.
+ */
+
+atom_t lisp_http_slice(const lisp_t lisp, const atom_t B,
+                       const http_span_t* const span);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,65 @@
+#include "http.h"
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <strings.h>
+
+/*
+ * Look for the option OPT in the comma-separated list of a Connection header.
+ */
+
+static bool
+lisp_http_option(const atom_t V, const char* const opt, const size_t len)
+{
+  const char* p = BUFFER_DATA(V);
+  const char* const end = p + BUFFER_LEN(V);
+  while (p < end) {
+    /*
+     * Skip the separators.
+     */
+    for (; p < end && (*p == ',' || *p == ' ' || *p == '\t'); p += 1)
+      ;
+    const char* q = p;
+    for (; q < end && *q != ',' && *q != ' ' && *q != '\t'; q += 1)
+      ;
+    if ((size_t)(q - p) == len && strncasecmp(p, opt, len) == 0) {
+      return true;
+    }
+    p = q;
+  }
+  return false;
+}
+
+static atom_t USED
+lisp_function_keep(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, MINOR, HDRS);
+  if (!IS_NUMB(MINOR) || !IS_LIST(HDRS)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * HTTP/1.1 connections are persistent by default, HTTP/1.0 are not.
+   */
+  bool keep = MINOR->number >= 1;
+  FOREACH(HDRS, p)
+  {
+    const atom_t hdr = p->car;
+    if (IS_PAIR(hdr) && IS_BUFF(CAR(hdr)) && IS_BUFF(CDR(hdr)) &&
+        BUFFER_LEN(CAR(hdr)) == 10 &&
+        strncasecmp(BUFFER_DATA(CAR(hdr)), "connection", 10) == 0) {
+      if (lisp_http_option(CDR(hdr), "close", 5)) {
+        return lisp_make_nil(lisp);
+      }
+      if (lisp_http_option(CDR(hdr), "keep-alive", 10)) {
+        keep = true;
+      }
+    }
+    NEXT(p);
+  }
+  return keep ? lisp_make_true(lisp) : lisp_make_nil(lisp);
+}
+
+LISP_MODULE_SETUP(keep, http/keep, MINOR, HDRS, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,28 @@
+#include <mnml/module.h>
+
+LISP_MODULE_DECL(header);
+LISP_MODULE_DECL(keep);
+LISP_MODULE_DECL(req);
+LISP_MODULE_DECL(resp);
+LISP_MODULE_DECL(write);
+
+module_entry_t ENTRIES[] = { LISP_MODULE_REGISTER(header),
+                             LISP_MODULE_REGISTER(keep),
+                             LISP_MODULE_REGISTER(req),
+                             LISP_MODULE_REGISTER(resp),
+                             LISP_MODULE_REGISTER(write),
+                             { NULL, NULL } };
+
+const char* USED
+lisp_module_name()
+{
+  return "http";
+}
+
+const module_entry_t* USED
+lisp_module_entries()
+{
+  return ENTRIES;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,333 @@
+#include "http.h"
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <string.h>
+#include <strings.h>
+
+#if defined(LISP_ENABLE_SSE) && defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+/*
+ * Character ranges that end the elements of a message. They are padded to 16
+ * bytes so that they can be loaded in a SSE register.
+ */
+
+static const char TOKEN_END[16] = "\x00\x20\x7f\xff";
+static const char PATH_END[16] = "\x00\x20\x7f\x7f";
+static const char VALUE_END[16] = "\x00\x08\x0a\x1f\x7f\x7f";
+static const char NAME_END[16] = "\x00\x20\"\"()"
+                                 ",,//:@[]{\xff";
+
+/*
+ * Find the first character in RANGES. Return END if there is none.
+ */
+
+static const char*
+lisp_http_scan(const char* p, const char* const end, const char* const ranges,
+               const size_t size)
+{
+#if defined(LISP_ENABLE_SSE) && defined(__SSE4_2__)
+  const __m128i rng = _mm_loadu_si128((const __m128i*)ranges);
+  while (end - p >= 16) {
+    const __m128i val = _mm_loadu_si128((const __m128i*)p);
+    const int idx = _mm_cmpestri(rng, (int)size, val, 16,
+                                 _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES);
+    if (idx != 16) {
+      return p + idx;
+    }
+    p += 16;
+  }
+#endif
+  for (; p < end; p += 1) {
+    const unsigned char c = (unsigned char)*p;
+    for (size_t i = 0; i < size; i += 2) {
+      if (c >= (unsigned char)ranges[i] && c <= (unsigned char)ranges[i + 1]) {
+        return p;
+      }
+    }
+  }
+  return end;
+}
+
+/*
+ * Element parsers. They return the position past the element, or NULL with the
+ * reason of the failure in RET.
+ */
+
+static const char*
+lisp_http_eol(const char* p, const char* const end, ssize_t* const ret)
+{
+  if (p < end && *p == '\r') {
+    p += 1;
+  }
+  if (p == end) {
+    *ret = HTTP_INCOMPLETE;
+    return NULL;
+  }
+  if (*p != '\n') {
+    *ret = HTTP_INVALID;
+    return NULL;
+  }
+  return p + 1;
+}
+
+static const char*
+lisp_http_token(const char* p, const char* const end, const char* const ranges,
+                const size_t size, http_span_t* const span,
+                ssize_t* const ret)
+{
+  const char* q = lisp_http_scan(p, end, ranges, size);
+  if (q == end) {
+    *ret = HTTP_INCOMPLETE;
+    return NULL;
+  }
+  if (q == p || *q != ' ') {
+    *ret = HTTP_INVALID;
+    return NULL;
+  }
+  span->data = p;
+  span->len = q - p;
+  return q + 1;
+}
+
+static const char*
+lisp_http_version(const char* p, const char* const end, int* const minor,
+                  ssize_t* const ret)
+{
+  static const char PREFIX[] = "HTTP/1.";
+  const size_t avail = end - p;
+  /*
+   * Reject invalid prefixes early.
+   */
+  if (memcmp(p, PREFIX, avail < 7 ? avail : 7) != 0) {
+    *ret = HTTP_INVALID;
+    return NULL;
+  }
+  if (avail < 8) {
+    *ret = HTTP_INCOMPLETE;
+    return NULL;
+  }
+  if (p[7] < '0' || p[7] > '9') {
+    *ret = HTTP_INVALID;
+    return NULL;
+  }
+  *minor = p[7] - '0';
+  return p + 8;
+}
+
+static const char*
+lisp_http_fields(const char* p, const char* const end, http_head_t* const head,
+                 ssize_t* const ret)
+{
+  head->count = 0;
+  for (;;) {
+    if (p == end) {
+      *ret = HTTP_INCOMPLETE;
+      return NULL;
+    }
+    /*
+     * An empty line ends the head.
+     */
+    if (*p == '\r' || *p == '\n') {
+      return lisp_http_eol(p, end, ret);
+    }
+    if (head->count == HTTP_MAX_HEADERS) {
+      *ret = HTTP_INVALID;
+      return NULL;
+    }
+    http_header_t* const hdr = &head->headers[head->count];
+    /*
+     * Parse the name.
+     */
+    const char* q = lisp_http_scan(p, end, NAME_END, 16);
+    if (q == end) {
+      *ret = HTTP_INCOMPLETE;
+      return NULL;
+    }
+    if (q == p || *q != ':') {
+      *ret = HTTP_INVALID;
+      return NULL;
+    }
+    hdr->name.data = p;
+    hdr->name.len = q - p;
+    /*
+     * Parse the value, without the surrounding white spaces.
+     */
+    for (p = q + 1; p < end && (*p == ' ' || *p == '\t'); p += 1)
+      ;
+    q = lisp_http_scan(p, end, VALUE_END, 6);
+    if (q == end) {
+      *ret = HTTP_INCOMPLETE;
+      return NULL;
+    }
+    if (*q != '\r' && *q != '\n') {
+      *ret = HTTP_INVALID;
+      return NULL;
+    }
+    const char* e = q;
+    for (; e > p && (e[-1] == ' ' || e[-1] == '\t'); e -= 1)
+      ;
+    hdr->value.data = p;
+    hdr->value.len = e - p;
+    /*
+     * Move to the next line.
+     */
+    p = lisp_http_eol(q, end, ret);
+    if (p == NULL) {
+      return NULL;
+    }
+    head->count += 1;
+  }
+}
+
+/*
+ * Message parsers.
+ */
+
+ssize_t
+lisp_http_parse_request(const char* const data, const size_t len,
+                        http_head_t* const head)
+{
+  ssize_t ret = 0;
+  const char* const end = data + len;
+  const char* p = data;
+  /*
+   * Skip the empty lines that may precede the request line.
+   */
+  for (; p < end && (*p == '\r' || *p == '\n'); p += 1)
+    ;
+  /*
+   * Parse the request line.
+   */
+  p = lisp_http_token(p, end, TOKEN_END, 4, &head->method, &ret);
+  if (p == NULL) {
+    return ret;
+  }
+  p = lisp_http_token(p, end, PATH_END, 4, &head->path, &ret);
+  if (p == NULL) {
+    return ret;
+  }
+  p = lisp_http_version(p, end, &head->minor, &ret);
+  if (p == NULL) {
+    return ret;
+  }
+  p = lisp_http_eol(p, end, &ret);
+  if (p == NULL) {
+    return ret;
+  }
+  /*
+   * Parse the headers.
+   */
+  p = lisp_http_fields(p, end, head, &ret);
+  return p == NULL ? ret : p - data;
+}
+
+ssize_t
+lisp_http_parse_response(const char* const data, const size_t len,
+                         http_head_t* const head)
+{
+  ssize_t ret = 0;
+  const char* const end = data + len;
+  const char* p = data;
+  /*
+   * Parse the version and the status.
+   */
+  p = lisp_http_version(p, end, &head->minor, &ret);
+  if (p == NULL) {
+    return ret;
+  }
+  if (end - p < 5) {
+    return HTTP_INCOMPLETE;
+  }
+  if (p[0] != ' ' || p[1] < '1' || p[1] > '5' || p[2] < '0' || p[2] > '9' ||
+      p[3] < '0' || p[3] > '9') {
+    return HTTP_INVALID;
+  }
+  head->status = (p[1] - '0') * 100 + (p[2] - '0') * 10 + (p[3] - '0');
+  p += 4;
+  /*
+   * Parse the optional reason.
+   */
+  if (*p == ' ') {
+    p += 1;
+  } else if (*p != '\r' && *p != '\n') {
+    return HTTP_INVALID;
+  }
+  const char* q = lisp_http_scan(p, end, VALUE_END, 6);
+  if (q == end) {
+    return HTTP_INCOMPLETE;
+  }
+  head->reason.data = p;
+  head->reason.len = q - p;
+  p = lisp_http_eol(q, end, &ret);
+  if (p == NULL) {
+    return ret;
+  }
+  /*
+   * Parse the headers.
+   */
+  p = lisp_http_fields(p, end, head, &ret);
+  return p == NULL ? ret : p - data;
+}
+
+/*
+ * Helpers.
+ */
+
+const http_header_t*
+lisp_http_find(const http_head_t* const head, const char* const name,
+               const size_t len)
+{
+  for (size_t i = 0; i < head->count; i += 1) {
+    const http_header_t* const hdr = &head->headers[i];
+    if (hdr->name.len == len && strncasecmp(hdr->name.data, name, len) == 0) {
+      return hdr;
+    }
+  }
+  return NULL;
+}
+
+bool
+lisp_http_length(const http_span_t* const span, size_t* const len)
+{
+  *len = 0;
+  if (span->len == 0) {
+    return false;
+  }
+  for (size_t i = 0; i < span->len; i += 1) {
+    const char c = span->data[i];
+    if (c < '0' || c > '9' || *len > (BUFFER_MAX_SIZE - (c - '0')) / 10) {
+      return false;
+    }
+    *len = *len * 10 + (c - '0');
+  }
+  return true;
+}
+
+atom_t
+lisp_http_slice(const lisp_t lisp, const atom_t B,
+                const http_span_t* const span)
+{
+  const size_t off = span->data - BUFFER_DATA(B);
+  return lisp_buffer_slice(lisp, B, off, span->len);
+}
+
+atom_t
+lisp_http_headers(const lisp_t lisp, const atom_t B,
+                  const http_head_t* const head)
+{
+  builder_t bld;
+  lisp_builder_init(lisp, &bld);
+  for (size_t i = 0; i < head->count; i += 1) {
+    const http_header_t* const hdr = &head->headers[i];
+    atom_t nam = lisp_http_slice(lisp, B, &hdr->name);
+    atom_t val = lisp_http_slice(lisp, B, &hdr->value);
+    lisp_builder_push(lisp, &bld, lisp_cons(lisp, nam, val));
+  }
+  return bld.head;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,72 @@
+#include "http.h"
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <string.h>
+
+static atom_t
+lisp_http_invalid(const lisp_t lisp)
+{
+  return lisp_make_symbol_from_string(lisp, "invalid", 7);
+}
+
+static atom_t USED
+lisp_function_req(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, B);
+  if (!IS_BUFF(B)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Parse the head of the request.
+   */
+  http_head_t head;
+  const size_t len = BUFFER_LEN(B);
+  const ssize_t ret = lisp_http_parse_request(BUFFER_DATA(B), len, &head);
+  if (ret == HTTP_INCOMPLETE) {
+    return lisp_make_nil(lisp);
+  }
+  if (ret == HTTP_INVALID || head.method.len > LISP_SYMBOL_LENGTH) {
+    return lisp_http_invalid(lisp);
+  }
+  /*
+   * Get the length of the body. Chunked bodies are not supported.
+   */
+  size_t blen = 0;
+  const http_header_t* hdr = lisp_http_find(&head, "content-length", 14);
+  if (lisp_http_find(&head, "transfer-encoding", 17) != NULL ||
+      (hdr != NULL && !lisp_http_length(&hdr->value, &blen))) {
+    return lisp_http_invalid(lisp);
+  }
+  if (blen > len - ret) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Build (METHOD PATH VERSION HEADERS BODY).
+   */
+  atom_t bdy = lisp_make_nil(lisp);
+  if (blen > 0) {
+    X(lisp, bdy);
+    bdy = lisp_buffer_slice(lisp, B, ret, blen);
+  }
+  atom_t hdrs = lisp_http_headers(lisp, B, &head);
+  atom_t vers = lisp_make_number(lisp, head.minor);
+  atom_t path = lisp_http_slice(lisp, B, &head.path);
+  atom_t mthd =
+    lisp_make_symbol_from_string(lisp, head.method.data, head.method.len);
+  atom_t res = lisp_cons(lisp, bdy, lisp_make_nil(lisp));
+  res = lisp_cons(lisp, hdrs, res);
+  res = lisp_cons(lisp, vers, res);
+  res = lisp_cons(lisp, path, res);
+  res = lisp_cons(lisp, mthd, res);
+  /*
+   * Drop the request from the buffer.
+   */
+  lisp_buffer_consume(B, ret + blen);
+  return res;
+}
+
+LISP_MODULE_SETUP(req, http/req, B, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
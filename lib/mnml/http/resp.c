@@ -0,0 +1,46 @@
+#include "http.h"
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_resp(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, B);
+  if (!IS_BUFF(B)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Parse the head of the response.
+   */
+  http_head_t head;
+  const size_t len = BUFFER_LEN(B);
+  const ssize_t ret = lisp_http_parse_response(BUFFER_DATA(B), len, &head);
+  if (ret == HTTP_INCOMPLETE) {
+    return lisp_make_nil(lisp);
+  }
+  if (ret == HTTP_INVALID) {
+    return lisp_make_symbol_from_string(lisp, "invalid", 7);
+  }
+  /*
+   * Build (STATUS REASON VERSION HEADERS).
+   */
+  atom_t hdrs = lisp_http_headers(lisp, B, &head);
+  atom_t vers = lisp_make_number(lisp, head.minor);
+  atom_t rson = lisp_http_slice(lisp, B, &head.reason);
+  atom_t stat = lisp_make_number(lisp, head.status);
+  atom_t res = lisp_cons(lisp, hdrs, lisp_make_nil(lisp));
+  res = lisp_cons(lisp, vers, res);
+  res = lisp_cons(lisp, rson, res);
+  res = lisp_cons(lisp, stat, res);
+  /*
+   * Drop the head from the buffer, the body is left to the caller.
+   */
+  lisp_buffer_consume(B, ret);
+  return res;
+}
+
+LISP_MODULE_SETUP(resp, http/resp, B, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
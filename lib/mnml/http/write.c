@@ -0,0 +1,349 @@
+#include "http.h"
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/*
+ * Buffers smaller than this are copied rather than referenced.
+ */
+
+#define HTTP_INLINE_LEN 64
+
+/*
+ * Messages that fit in these limits are gathered on the stack.
+ */
+
+#define HTTP_STACK_IOV 32
+#define HTTP_STACK_LEN 1024
+
+/*
+ * Reasons of the common status codes.
+ */
+
+static const struct
+{
+  int status;
+  const char* reason;
+} REASONS[] = {
+  { 100, "Continue" },
+  { 200, "OK" },
+  { 201, "Created" },
+  { 202, "Accepted" },
+  { 204, "No Content" },
+  { 206, "Partial Content" },
+  { 301, "Moved Permanently" },
+  { 302, "Found" },
+  { 303, "See Other" },
+  { 304, "Not Modified" },
+  { 307, "Temporary Redirect" },
+  { 308, "Permanent Redirect" },
+  { 400, "Bad Request" },
+  { 401, "Unauthorized" },
+  { 403, "Forbidden" },
+  { 404, "Not Found" },
+  { 405, "Method Not Allowed" },
+  { 408, "Request Timeout" },
+  { 411, "Length Required" },
+  { 413, "Content Too Large" },
+  { 500, "Internal Server Error" },
+  { 501, "Not Implemented" },
+  { 503, "Service Unavailable" },
+};
+
+#define REASONS_LEN (sizeof(REASONS) / sizeof(REASONS[0]))
+
+static const char*
+lisp_http_reason(const int status)
+{
+  for (size_t i = 0; i < REASONS_LEN; i += 1) {
+    if (REASONS[i].status == status) {
+      return REASONS[i].reason;
+    }
+  }
+  return "Unknown";
+}
+
+/*
+ * The message is gathered in two passes. The first pass measures the message,
+ * the second pass fills the IO vector. Small chunks are packed in a scratch
+ * area, and consecutive packed chunks share the same IO vector entry.
+ */
+
+typedef struct http_out
+{
+  size_t count;
+  size_t chars;
+  struct iovec* iov;
+  char* next;
+  bool packed;
+} http_out_t;
+
+static void
+lisp_http_copy(http_out_t* const out, const char* const data, const size_t len)
+{
+  if (out->iov == NULL) {
+    out->count += 1;
+    out->chars += len;
+    return;
+  }
+  if (!out->packed) {
+    out->iov[out->count].iov_base = out->next;
+    out->iov[out->count].iov_len = 0;
+    out->count += 1;
+    out->packed = true;
+  }
+  memcpy(out->next, data, len);
+  out->next += len;
+  out->iov[out->count - 1].iov_len += len;
+}
+
+static void
+lisp_http_ref(http_out_t* const out, const char* const data, const size_t len)
+{
+  if (len < HTTP_INLINE_LEN) {
+    lisp_http_copy(out, data, len);
+    return;
+  }
+  if (out->iov != NULL) {
+    out->iov[out->count].iov_base = (void*)data;
+    out->iov[out->count].iov_len = len;
+    out->packed = false;
+  }
+  out->count += 1;
+}
+
+static void
+lisp_http_string(http_out_t* const out, const atom_t cell)
+{
+  if (out->iov == NULL) {
+    out->count += 1;
+    out->chars += lisp_len(cell);
+    return;
+  }
+  FOREACH(cell, p)
+  {
+    const char c = (char)p->car->number;
+    lisp_http_copy(out, &c, 1);
+    NEXT(p);
+  }
+}
+
+static void
+lisp_http_number(http_out_t* const out, const int64_t num)
+{
+  char buf[24];
+#if defined(__MACH__) || defined(__OpenBSD__)
+  const int len = snprintf(buf, sizeof(buf), "%lld", num);
+#else
+  const int len = snprintf(buf, sizeof(buf), "%ld", num);
+#endif
+  lisp_http_copy(out, buf, len);
+}
+
+static bool
+lisp_http_atom(http_out_t* const out, const atom_t cell)
+{
+  switch (cell->type) {
+    case T_BUFFER:
+      lisp_http_ref(out, BUFFER_DATA(cell), BUFFER_LEN(cell));
+      return true;
+    case T_NUMBER:
+      lisp_http_number(out, cell->number);
+      return true;
+    case T_SYMBOL: {
+      const size_t len = strnlen(cell->symbol.val, LISP_SYMBOL_LENGTH);
+      lisp_http_copy(out, cell->symbol.val, len);
+      return true;
+    }
+    case T_PAIR:
+      if (lisp_is_string(cell)) {
+        lisp_http_string(out, cell);
+        return true;
+      }
+      return false;
+    default:
+      return false;
+  }
+}
+
+static size_t
+lisp_http_body_len(const atom_t cell)
+{
+  if (IS_BUFF(cell)) {
+    return BUFFER_LEN(cell);
+  }
+  return IS_NULL(cell) ? 0 : lisp_len(cell);
+}
+
+/*
+ * Informational, 204 and 304 responses never have a body.
+ */
+
+static bool
+lisp_http_has_body(const int status)
+{
+  return status >= 200 && status != 204 && status != 304;
+}
+
+static bool
+lisp_http_gather(http_out_t* const out, const atom_t HEAD, const atom_t HDRS,
+                 const atom_t BODY)
+{
+  static const char* const CRLF = "\r\n";
+  /*
+   * Write the status line or the request line.
+   */
+  if (IS_NUMB(HEAD)) {
+    const char* const reason = lisp_http_reason((int)HEAD->number);
+    lisp_http_copy(out, "HTTP/1.1 ", 9);
+    lisp_http_number(out, HEAD->number);
+    lisp_http_copy(out, " ", 1);
+    lisp_http_copy(out, reason, strlen(reason));
+  } else {
+    if (!IS_PAIR(HEAD) || !IS_PAIR(CDR(HEAD)) ||
+        !lisp_http_atom(out, CAR(HEAD))) {
+      return false;
+    }
+    lisp_http_copy(out, " ", 1);
+    if (!lisp_http_atom(out, CAR(CDR(HEAD)))) {
+      return false;
+    }
+    lisp_http_copy(out, " HTTP/1.1", 9);
+  }
+  lisp_http_copy(out, CRLF, 2);
+  /*
+   * Write the headers.
+   */
+  FOREACH(HDRS, p)
+  {
+    const atom_t hdr = p->car;
+    if (!IS_PAIR(hdr) || !lisp_http_atom(out, CAR(hdr))) {
+      return false;
+    }
+    lisp_http_copy(out, ": ", 2);
+    if (!lisp_http_atom(out, CDR(hdr))) {
+      return false;
+    }
+    lisp_http_copy(out, CRLF, 2);
+    NEXT(p);
+  }
+  /*
+   * Responses that may have a body and requests with a body get a
+   * Content-Length.
+   */
+  if (IS_NUMB(HEAD) ? lisp_http_has_body((int)HEAD->number)
+                    : !IS_NULL(BODY)) {
+    lisp_http_copy(out, "Content-Length: ", 16);
+    lisp_http_number(out, (int64_t)lisp_http_body_len(BODY));
+    lisp_http_copy(out, CRLF, 2);
+  }
+  lisp_http_copy(out, CRLF, 2);
+  /*
+   * Write the body.
+   */
+  return IS_NULL(BODY) || lisp_http_atom(out, BODY);
+}
+
+static ssize_t
+lisp_http_writev(const lisp_t lisp, const int fd, struct iovec* iov, size_t cnt)
+{
+  ssize_t total = 0;
+  while (cnt > 0) {
+    const int len = cnt > IOV_MAX ? IOV_MAX : (int)cnt;
+    ssize_t ret = writev(fd, iov, len);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      /*
+       * Wait for non-blocking descriptors to be writable again.
+       */
+      if ((errno == EAGAIN || errno == EWOULDBLOCK) &&
+          lisp_wait(lisp, fd, POLLOUT)) {
+        continue;
+      }
+      return -1;
+    }
+    total += ret;
+    /*
+     * Skip what has been written, resuming partial writes.
+     */
+    while (cnt > 0 && (size_t)ret >= iov->iov_len) {
+      ret -= iov->iov_len;
+      iov += 1;
+      cnt -= 1;
+    }
+    if (ret > 0) {
+      iov->iov_base = (char*)iov->iov_base + ret;
+      iov->iov_len -= ret;
+    }
+  }
+  return total;
+}
+
+static atom_t USED
+lisp_function_write(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, FD, HEAD, HDRS, BODY);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_NUMB(FD) || FD->number < 0 || !IS_LIST(HDRS) ||
+      !(IS_NULL(BODY) || IS_BUFF(BODY) || lisp_is_string(BODY))) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Measure the message.
+   */
+  http_out_t out = { .count = 0, .chars = 0, .iov = NULL };
+  if (!lisp_http_gather(&out, HEAD, HDRS, BODY)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Build the IO vector.
+   */
+  struct iovec stack_iov[HTTP_STACK_IOV];
+  char stack_buf[HTTP_STACK_LEN];
+  const bool small = out.count <= HTTP_STACK_IOV && out.chars < HTTP_STACK_LEN;
+  struct iovec* iov = stack_iov;
+  char* scratch = stack_buf;
+  if (!small) {
+    iov = (struct iovec*)malloc(out.count * sizeof(struct iovec));
+    scratch = (char*)malloc(out.chars + 1);
+    if (iov == NULL || scratch == NULL) {
+      free(iov);
+      free(scratch);
+      return lisp_make_nil(lisp);
+    }
+  }
+  out = (http_out_t){ .count = 0, .iov = iov, .next = scratch };
+  lisp_http_gather(&out, HEAD, HDRS, BODY);
+  /*
+   * Flush the printed output and write the message.
+   */
+  lisp_flush(lisp);
+  const ssize_t ret = lisp_http_writev(lisp, (int)FD->number, iov, out.count);
+  if (!small) {
+    free(iov);
+    free(scratch);
+  }
+  return ret < 0 ? lisp_make_nil(lisp) : lisp_make_number(lisp, ret);
+}
+
+LISP_MODULE_SETUP(write, http/write, FD, HEAD, HDRS, BODY, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,17 @@
+#include <mnml/binary.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <stdio.h>
+
+static atom_t USED
+lisp_function_binread(const lisp_t lisp, UNUSED const atom_t closure)
+{
+  FILE* handle = IO_CONTEXT(lisp->ichan)->handle;
+  atom_t result = lisp_bin_read(lisp, handle);
+  return result == NULL ? lisp_make_nil(lisp) : result;
+}
+
+LISP_MODULE_SETUP(binread, bin-read)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,24 @@
+#include <mnml/binary.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <stdio.h>
+
+static atom_t USED
+lisp_function_binwrite(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, X);
+  FILE* handle = IO_CONTEXT(lisp->ochan)->handle;
+  /*
+   * Flush the printed output and write the value.
+   */
+  lisp_flush(lisp);
+  if (!lisp_bin_write(lisp, handle, X)) {
+    return lisp_make_nil(lisp);
+  }
+  return UP(X);
+}
+
+LISP_MODULE_SETUP(binwrite, bin-write, X, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
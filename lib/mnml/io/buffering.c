@@ -0,0 +1,38 @@
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+
+static const char* MODES[] = { "none", "line", "block" };
+
+static atom_t USED
+lisp_function_buffering(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, MODE);
+  out_mode_t mode = lisp_get_out_mode(lisp);
+  /*
+   * Change the mode if one is given.
+   */
+  if (!IS_NULL(MODE)) {
+    if (!IS_SYMB(MODE)) {
+      return lisp_make_nil(lisp);
+    }
+    size_t i = 0;
+    while (i < 3 && !lisp_symbol_equal(MODE, MODES[i])) {
+      i += 1;
+    }
+    if (i == 3) {
+      return lisp_make_nil(lisp);
+    }
+    mode = lisp_set_out_mode(lisp, (out_mode_t)i);
+  }
+  /*
+   * Return the previous mode.
+   */
+  const char* name = MODES[mode];
+  return lisp_make_symbol_from_string(lisp, name, strlen(name));
+}
+
+LISP_MODULE_SETUP(buffering, buffering, MODE, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
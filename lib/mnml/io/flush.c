@@ -0,0 +1,14 @@
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_flush(const lisp_t lisp, UNUSED const atom_t closure)
+{
+  lisp_flush(lisp);
+  return lisp_make_true(lisp);
+}
+
+LISP_MODULE_SETUP(flush, flush)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
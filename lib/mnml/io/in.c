@@ -25,7 +25,7 @@ lisp_function_in(const lisp_t lisp, const atom_t closure)
   /*
    * Get the working directory for the current lisp->ichan.
    */
-  lisp_make_cstring(CAR(CDR(CAR(lisp->ichan))), dirn_buf, PATH_MAX, 0);
+  strcpy(dirn_buf, IO_CONTEXT(lisp->ichan)->pwd);
   /*
    * Process the CHAN.
    */
@@ -80,9 +80,12 @@ lisp_function_in(const lisp_t lisp, const atom_t closure)
   /*
    * Push the context, eval the prog, pop the context.
    */
-  PUSH_IO_CONTEXT(lisp, lisp->ichan, handle, dirn_buf);
+  if (!lisp_chan_push(lisp, &lisp->ichan, handle, dirn_buf)) {
+    fclose(handle);
+    return lisp_make_nil(lisp);
+  }
   atom_t res = lisp_prog(lisp, C, UP(REM), lisp_make_nil(lisp));
-  POP_IO_CONTEXT(lisp, lisp->ichan);
+  lisp_chan_pop(lisp, &lisp->ichan);
   /*
    * Close the FD if necessary and return the value.
    */
@@ -1,5 +1,9 @@
 #include <mnml/module.h>
 
+LISP_MODULE_DECL(binread);
+LISP_MODULE_DECL(binwrite);
+LISP_MODULE_DECL(buffering);
+LISP_MODULE_DECL(flush);
 LISP_MODULE_DECL(in);
 LISP_MODULE_DECL(out);
 LISP_MODULE_DECL(prin);
@@ -8,8 +12,14 @@ LISP_MODULE_DECL(print);
 LISP_MODULE_DECL(printl);
 LISP_MODULE_DECL(read);
 LISP_MODULE_DECL(readline);
+LISP_MODULE_DECL(slurp);
+LISP_MODULE_DECL(spit);
 
-module_entry_t ENTRIES[] = { LISP_MODULE_REGISTER(in),
+module_entry_t ENTRIES[] = { LISP_MODULE_REGISTER(binread),
+                             LISP_MODULE_REGISTER(binwrite),
+                             LISP_MODULE_REGISTER(buffering),
+                             LISP_MODULE_REGISTER(flush),
+                             LISP_MODULE_REGISTER(in),
                              LISP_MODULE_REGISTER(out),
                              LISP_MODULE_REGISTER(prin),
                              LISP_MODULE_REGISTER(prinl),
@@ -17,6 +27,8 @@ module_entry_t ENTRIES[] = { LISP_MODULE_REGISTER(in),
                              LISP_MODULE_REGISTER(printl),
                              LISP_MODULE_REGISTER(read),
                              LISP_MODULE_REGISTER(readline),
+                             LISP_MODULE_REGISTER(slurp),
+                             LISP_MODULE_REGISTER(spit),
                              { NULL, NULL } };
 
 const char* USED
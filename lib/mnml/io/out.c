@@ -75,9 +75,12 @@ lisp_function_out(const lisp_t lisp, const atom_t closure)
   /*
    * Push the context, eval the REM, pop the context.
    */
-  PUSH_IO_CONTEXT(lisp, lisp->ochan, handle, dirn_buf);
+  if (!lisp_chan_push(lisp, &lisp->ochan, handle, dirn_buf)) {
+    fclose(handle);
+    return lisp_make_nil(lisp);
+  }
   atom_t res = lisp_prog(lisp, C, UP(REM), lisp_make_nil(lisp));
-  POP_IO_CONTEXT(lisp, lisp->ochan);
+  lisp_chan_pop(lisp, &lisp->ochan);
   /*
    * Close the FD if necessary and return the value.
    */
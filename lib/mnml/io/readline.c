@@ -7,10 +7,11 @@
 static atom_t USED
 lisp_function_readline(const lisp_t lisp, UNUSED const atom_t closure)
 {
-  FILE* handle = (FILE*)CAR(CAR(lisp->ichan))->number;
+  FILE* handle = IO_CONTEXT(lisp->ichan)->handle;
   /*
    * Read a line.
    */
+  lisp_wait_input(lisp, handle);
   char* line = NULL;
   size_t cap = 0;
   ssize_t len = getline(&line, &cap, handle);
@@ -0,0 +1,117 @@
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SLURP_CHUNK_LEN 65536
+
+static bool
+lisp_slurp_fd(const atom_t B, const int fd)
+{
+  /*
+   * Read until the end of the file. The buffer only grows when it is full, so
+   * regular files are read in place.
+   */
+  for (;;) {
+    store_t store = B->buffer.store;
+    char* p = BUFFER_DATA(B) + BUFFER_LEN(B);
+    if (p == store->data + store->size) {
+      p = lisp_buffer_reserve(B, SLURP_CHUNK_LEN);
+      if (p == NULL) {
+        return false;
+      }
+      store = B->buffer.store;
+    }
+    const size_t room = store->size - (p - store->data);
+    ssize_t ret = 0;
+    do {
+      ret = read(fd, p, room);
+    } while (ret < 0 && errno == EINTR);
+    if (ret <= 0) {
+      return ret == 0;
+    }
+    lisp_buffer_commit(B, ret);
+  }
+}
+
+static atom_t USED
+lisp_function_slurp(const lisp_t lisp, const atom_t closure)
+{
+  int fd;
+  bool owned = false;
+  char file_buf[PATH_MAX];
+  char path_buf[PATH_MAX];
+  /*
+   * Get CHAN.
+   */
+  LISP_ARGS(closure, C, CHAN);
+  /*
+   * Process the CHAN.
+   */
+  switch (CHAN->type) {
+    case T_NIL:
+      fd = 0;
+      break;
+    case T_NUMBER:
+      fd = (int)CHAN->number;
+      break;
+    case T_PAIR:
+      if (!lisp_is_string(CHAN) || lisp_len(CHAN) >= PATH_MAX) {
+        return lisp_make_nil(lisp);
+      }
+      /*
+       * Files are relative to the directory of the current input channel.
+       */
+      lisp_make_cstring(CHAN, file_buf, PATH_MAX, 0);
+      const char* const dir =
+        IO_CONTEXT_EMPTY(lisp->ichan) ? "." : IO_CONTEXT(lisp->ichan)->pwd;
+      const char* path = lisp_get_fullpath(lisp, dir, file_buf, path_buf);
+      if (path == NULL) {
+        ERROR("Cannot get the full path for %s", file_buf);
+        return lisp_make_nil(lisp);
+      }
+      fd = open(path, O_RDONLY);
+      if (fd < 0) {
+        ERROR("Cannot open file %s", path);
+        return lisp_make_nil(lisp);
+      }
+      owned = true;
+      break;
+    default:
+      return lisp_make_nil(lisp);
+  }
+  /*
+   * Size the buffer after what's left to read in regular files. The extra byte
+   * lets the last read detect the end of the file without growing the buffer.
+   */
+  size_t hint = 0;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    const off_t cur = lseek(fd, 0, SEEK_CUR);
+    if (cur >= 0 && cur < st.st_size) {
+      hint = st.st_size - cur;
+    }
+  }
+  /*
+   * Read the content.
+   */
+  atom_t res = lisp_make_buffer(lisp, hint == 0 ? 0 : hint + 1);
+  if (IS_BUFF(res) && !lisp_slurp_fd(res, fd)) {
+    X(lisp, res);
+    res = lisp_make_nil(lisp);
+  }
+  if (owned) {
+    close(fd);
+  }
+  return res;
+}
+
+LISP_MODULE_SETUP(slurp, slurp, CHAN, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,209 @@
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/*
+ * Chunks are buffers, characters or strings. The characters of strings are
+ * packed in a single scratch area so that all the chunks are written at once.
+ */
+
+typedef struct spit_chunks
+{
+  size_t count;
+  size_t chars;
+  struct iovec* iov;
+  char* scratch;
+} spit_chunks_t;
+
+static bool
+lisp_spit_measure(spit_chunks_t* const chk, const atom_t cell)
+{
+  if (IS_BUFF(cell) || IS_CHAR(cell)) {
+    chk->count += 1;
+    chk->chars += IS_CHAR(cell) ? 1 : 0;
+    return true;
+  }
+  if (lisp_is_string(cell)) {
+    chk->count += 1;
+    chk->chars += lisp_len(cell);
+    return true;
+  }
+  return false;
+}
+
+static void
+lisp_spit_add(spit_chunks_t* const chk, char** const next, const atom_t cell)
+{
+  struct iovec* iov = &chk->iov[chk->count];
+  chk->count += 1;
+  /*
+   * Buffers are written in place.
+   */
+  if (IS_BUFF(cell)) {
+    iov->iov_base = BUFFER_DATA(cell);
+    iov->iov_len = BUFFER_LEN(cell);
+    return;
+  }
+  /*
+   * Characters are copied in the scratch area.
+   */
+  iov->iov_base = *next;
+  if (IS_CHAR(cell)) {
+    *(*next)++ = (char)cell->number;
+  } else {
+    FOREACH(cell, p)
+    {
+      *(*next)++ = (char)p->car->number;
+      NEXT(p);
+    }
+  }
+  iov->iov_len = *next - (char*)iov->iov_base;
+}
+
+static ssize_t
+lisp_spit_writev(const int fd, struct iovec* iov, size_t cnt)
+{
+  ssize_t total = 0;
+  while (cnt > 0) {
+    const int len = cnt > IOV_MAX ? IOV_MAX : (int)cnt;
+    ssize_t ret = writev(fd, iov, len);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    total += ret;
+    /*
+     * Skip what has been written, resuming partial writes.
+     */
+    while (cnt > 0 && (size_t)ret >= iov->iov_len) {
+      ret -= iov->iov_len;
+      iov += 1;
+      cnt -= 1;
+    }
+    if (ret > 0) {
+      iov->iov_base = (char*)iov->iov_base + ret;
+      iov->iov_len -= ret;
+    }
+  }
+  return total;
+}
+
+static atom_t USED
+lisp_function_spit(const lisp_t lisp, const atom_t closure)
+{
+  int fd;
+  bool owned = false;
+  char file_buf[PATH_MAX];
+  char path_buf[PATH_MAX];
+  /*
+   * Get CHAN and DATA.
+   */
+  LISP_ARGS(closure, C, CHAN, DATA);
+  /*
+   * Collect the chunks. DATA is a single chunk or a list of chunks.
+   */
+  spit_chunks_t chk = { .count = 0, .chars = 0 };
+  const bool single = !IS_PAIR(DATA) || lisp_is_string(DATA);
+  if (single) {
+    if (!lisp_spit_measure(&chk, DATA)) {
+      return lisp_make_nil(lisp);
+    }
+  } else {
+    FOREACH(DATA, p)
+    {
+      if (!lisp_spit_measure(&chk, p->car)) {
+        return lisp_make_nil(lisp);
+      }
+      NEXT(p);
+    }
+  }
+  /*
+   * Process the CHAN.
+   */
+  switch (CHAN->type) {
+    case T_NIL:
+      fd = 1;
+      break;
+    case T_NUMBER:
+      fd = (int)CHAN->number;
+      break;
+    case T_PAIR:
+      if (!lisp_is_string(CHAN) || lisp_len(CHAN) >= PATH_MAX) {
+        return lisp_make_nil(lisp);
+      }
+      /*
+       * Output files are relative to where the program is run.
+       */
+      lisp_make_cstring(CHAN, file_buf, PATH_MAX, 0);
+      const char* path =
+        lisp_get_fullpath(lisp, getenv("PWD"), file_buf, path_buf);
+      if (path == NULL) {
+        ERROR("Cannot get the full path for %s", file_buf);
+        return lisp_make_nil(lisp);
+      }
+      fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+      if (fd < 0) {
+        ERROR("Cannot open file %s", path);
+        return lisp_make_nil(lisp);
+      }
+      owned = true;
+      break;
+    default:
+      return lisp_make_nil(lisp);
+  }
+  /*
+   * Build the IO vector.
+   */
+  chk.iov = (struct iovec*)malloc(chk.count * sizeof(struct iovec) + 1);
+  chk.scratch = (char*)malloc(chk.chars + 1);
+  if (chk.iov == NULL || chk.scratch == NULL) {
+    free(chk.iov);
+    free(chk.scratch);
+    if (owned) {
+      close(fd);
+    }
+    return lisp_make_nil(lisp);
+  }
+  char* next = chk.scratch;
+  const size_t count = chk.count;
+  chk.count = 0;
+  if (single) {
+    lisp_spit_add(&chk, &next, DATA);
+  } else {
+    FOREACH(DATA, p)
+    {
+      lisp_spit_add(&chk, &next, p->car);
+      NEXT(p);
+    }
+  }
+  /*
+   * Flush the printed output and write the chunks.
+   */
+  lisp_flush(lisp);
+  ssize_t ret = lisp_spit_writev(fd, chk.iov, count);
+  free(chk.iov);
+  free(chk.scratch);
+  if (owned) {
+    close(fd);
+  }
+  return ret < 0 ? lisp_make_nil(lisp) : lisp_make_number(lisp, ret);
+}
+
+LISP_MODULE_SETUP(spit, spit, CHAN, DATA, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -2,7 +2,7 @@
 #include <mnml/module.h>
 #include <mnml/slab.h>
 
-BINARY_NUMBER_GEN(add, +, X, Y);
+BINARY_NUMBER_GEN(add, X, Y);
 LISP_MODULE_SETUP(add, +, X, Y, NIL)
 
 // vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,190 @@
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/record.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <string.h>
+
+/*
+ * Generated functions. The descriptor is bound to TYPE and the offset of the
+ * field to SLOT in their definition-site closure, so accessors never look up
+ * the field by name.
+ */
+
+static atom_t
+lisp_record_new(const lisp_t lisp, const atom_t closure)
+{
+  MAKE_SYMBOL_STATIC(type, "TYPE");
+  /*
+   * Count the field bindings that precede the descriptor.
+   */
+  size_t count = 0;
+  atom_t p = closure;
+  while (!lisp_symbol_match(CAR(CAR(p)), type)) {
+    count += 1;
+    p = CDR(p);
+  }
+  /*
+   * Build the record. The fields are bound in reverse order.
+   */
+  atom_t R = lisp_make_record(lisp, UP(CDR(CAR(p))), count);
+  if (!IS_RECD(R)) {
+    return R;
+  }
+  p = closure;
+  for (size_t i = count; i > 0; i -= 1) {
+    RECORD_FIELD(R, i - 1) = UP(CDR(CAR(p)));
+    p = CDR(p);
+  }
+  return R;
+}
+
+static atom_t
+lisp_record_is(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, TYPE, X);
+  if (IS_RECD(X) && RECORD_DESC(X) == TYPE) {
+    return lisp_make_true(lisp);
+  }
+  return lisp_make_nil(lisp);
+}
+
+static atom_t
+lisp_record_get(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, TYPE, SLOT, R);
+  if (IS_RECD(R) && RECORD_DESC(R) == TYPE) {
+    return UP(RECORD_FIELD(R, SLOT->number));
+  }
+  return lisp_make_nil(lisp);
+}
+
+/*
+ * Definition helpers.
+ */
+
+static atom_t
+lisp_record_closure(const lisp_t lisp, const atom_t desc, const int64_t slot)
+{
+  MAKE_SYMBOL_STATIC(type, "TYPE");
+  atom_t sym = lisp_make_symbol(lisp, type);
+  atom_t kvp = lisp_cons(lisp, sym, UP(desc));
+  atom_t res = lisp_cons(lisp, kvp, lisp_make_nil(lisp));
+  /*
+   * Prepend the offset of the field for accessors.
+   */
+  if (slot >= 0) {
+    MAKE_SYMBOL_STATIC(name, "SLOT");
+    atom_t key = lisp_make_symbol(lisp, name);
+    atom_t val = lisp_cons(lisp, key, lisp_make_number(lisp, slot));
+    res = lisp_cons(lisp, val, res);
+  }
+  return res;
+}
+
+static void
+lisp_record_define(const lisp_t lisp, const char* const name, const size_t len,
+                   const atom_t args, const atom_t dscl, const function_t fun)
+{
+  atom_t sym = lisp_make_symbol_from_string(lisp, name, len);
+  atom_t adr = lisp_make_number(lisp, (uintptr_t)fun);
+  atom_t cn0 = lisp_cons(lisp, dscl, adr);
+  atom_t val = lisp_cons(lisp, args, cn0);
+  atom_t cns = lisp_cons(lisp, sym, val);
+  lisp->globals = lisp_setq(lisp, lisp->globals, cns);
+}
+
+static bool
+lisp_record_check(const atom_t name, const atom_t flds)
+{
+  MAKE_SYMBOL_STATIC(type, "TYPE");
+  const size_t len = strnlen(name->symbol.val, LISP_SYMBOL_LENGTH);
+  /*
+   * Check that the predicate name fits in a symbol.
+   */
+  if (len + 1 > LISP_SYMBOL_LENGTH) {
+    ERROR("Record name too long: %.16s", name->symbol.val);
+    return false;
+  }
+  /*
+   * Check the fields and the accessor names.
+   */
+  FOREACH(flds, p)
+  {
+    atom_t fld = p->car;
+    if (!IS_SYMB(fld) || lisp_symbol_match(fld, type)) {
+      ERROR("Invalid record field for %.16s", name->symbol.val);
+      return false;
+    }
+    if (len + 1 + strnlen(fld->symbol.val, LISP_SYMBOL_LENGTH) >
+        LISP_SYMBOL_LENGTH) {
+      ERROR("Record accessor too long: %.16s/%.16s", name->symbol.val,
+            fld->symbol.val);
+      return false;
+    }
+    NEXT(p);
+  }
+  return true;
+}
+
+/*
+ * (defrecord NAME (FIELD ...)) defines the constructor NAME, the predicate
+ * NAME? and the accessors NAME/FIELD.
+ */
+
+static atom_t USED
+lisp_function_defrecord(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, ANY);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_PAIR(ANY) || !IS_SYMB(CAR(ANY)) || !IS_PAIR(CDR(ANY)) ||
+      !IS_LIST(CAR(CDR(ANY)))) {
+    return lisp_make_nil(lisp);
+  }
+  atom_t name = CAR(ANY);
+  atom_t flds = CAR(CDR(ANY));
+  if (!lisp_record_check(name, flds)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Build the descriptor.
+   */
+  char buf[LISP_SYMBOL_LENGTH];
+  const size_t len = strnlen(name->symbol.val, LISP_SYMBOL_LENGTH);
+  atom_t desc = lisp_cons(lisp, UP(name), UP(flds));
+  /*
+   * Define the constructor and the predicate.
+   */
+  memcpy(buf, name->symbol.val, len);
+  lisp_record_define(lisp, buf, len, UP(flds),
+                     lisp_record_closure(lisp, desc, -1), lisp_record_new);
+  LISP_CONS(lisp, arg, X, NIL);
+  buf[len] = '?';
+  lisp_record_define(lisp, buf, len + 1, arg,
+                     lisp_record_closure(lisp, desc, -1), lisp_record_is);
+  /*
+   * Define the accessors.
+   */
+  int64_t slot = 0;
+  LISP_CONS(lisp, acc, R, NIL);
+  buf[len] = '/';
+  FOREACH(flds, p)
+  {
+    const size_t fln = strnlen(p->car->symbol.val, LISP_SYMBOL_LENGTH);
+    memcpy(buf + len + 1, p->car->symbol.val, fln);
+    lisp_record_define(lisp, buf, len + 1 + fln, UP(acc),
+                       lisp_record_closure(lisp, desc, slot), lisp_record_get);
+    slot += 1;
+    NEXT(p);
+  }
+  /*
+   */
+  X(lisp, acc, desc);
+  return UP(name);
+}
+
+LISP_MODULE_SETUP(defrecord, defrecord, ANY)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
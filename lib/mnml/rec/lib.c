@@ -0,0 +1,24 @@
+#include <mnml/module.h>
+
+LISP_MODULE_DECL(defrecord);
+LISP_MODULE_DECL(isrec);
+LISP_MODULE_DECL(lst);
+
+module_entry_t ENTRIES[] = { LISP_MODULE_REGISTER(defrecord),
+                             LISP_MODULE_REGISTER(isrec),
+                             LISP_MODULE_REGISTER(lst),
+                             { NULL, NULL } };
+
+const char* USED
+lisp_module_name()
+{
+  return "rec";
+}
+
+const module_entry_t* USED
+lisp_module_entries()
+{
+  return ENTRIES;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
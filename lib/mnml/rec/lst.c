@@ -0,0 +1,18 @@
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/record.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_lst(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, R);
+  if (!IS_RECD(R)) {
+    return lisp_make_nil(lisp);
+  }
+  return lisp_record_to_list(lisp, R);
+}
+
+LISP_MODULE_SETUP(lst, rec/lst, R, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,39 @@
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/rope.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_join(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, LST, SEP);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_LIST(LST)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Join the elements of the list with the separator.
+   */
+  atom_t res = lisp_make_rope(lisp);
+  if (IS_NULL(res)) {
+    return res;
+  }
+  FOREACH(LST, p) {
+    if (p != &LST->pair && !lisp_rope_push(lisp, res, SEP)) {
+      X(lisp, res);
+      return lisp_make_nil(lisp);
+    }
+    if (!lisp_rope_push(lisp, res, p->car)) {
+      X(lisp, res);
+      return lisp_make_nil(lisp);
+    }
+    NEXT(p);
+  }
+  return res;
+}
+
+LISP_MODULE_SETUP(join, rope/join, LST, SEP, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
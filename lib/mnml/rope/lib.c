@@ -0,0 +1,26 @@
+#include <mnml/module.h>
+
+LISP_MODULE_DECL(isrope);
+LISP_MODULE_DECL(join);
+LISP_MODULE_DECL(rope);
+LISP_MODULE_DECL(str);
+
+module_entry_t ENTRIES[] = {
+  LISP_MODULE_REGISTER(isrope), LISP_MODULE_REGISTER(join),
+  LISP_MODULE_REGISTER(rope),   LISP_MODULE_REGISTER(str),
+  { NULL, NULL }
+};
+
+const char* USED
+lisp_module_name()
+{
+  return "rope";
+}
+
+const module_entry_t* USED
+lisp_module_entries()
+{
+  return ENTRIES;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
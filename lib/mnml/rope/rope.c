@@ -0,0 +1,77 @@
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/rope.h>
+#include <mnml/slab.h>
+
+static atom_t
+lisp_rope_all(const lisp_t lisp, const atom_t closure, const atom_t cell,
+              const atom_t result)
+{
+  /*
+   * Return the result if we are done.
+   */
+  if (IS_NULL(cell)) {
+    X(lisp, cell);
+    return result;
+  }
+  /*
+   * Grab CAR and CDR, and evaluate CAR.
+   */
+  atom_t car = lisp_eval(lisp, closure, lisp_car(lisp, cell));
+  atom_t cdr = lisp_cdr(lisp, cell);
+  X(lisp, cell);
+  /*
+   * Append CAR and recurse on CDR.
+   */
+  const bool res = lisp_rope_push(lisp, result, car);
+  X(lisp, car);
+  if (!res) {
+    X(lisp, cdr, result);
+    return lisp_make_nil(lisp);
+  }
+  return lisp_rope_all(lisp, closure, cdr, result);
+}
+
+static atom_t USED
+lisp_function_rope(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, ANY);
+  atom_t cell = UP(ANY);
+  atom_t result;
+  /*
+   * Extend the first argument if it is a rope, start a new rope otherwise.
+   */
+  if (IS_PAIR(cell)) {
+    atom_t car = lisp_eval(lisp, C, lisp_car(lisp, cell));
+    if (IS_ROPE(car)) {
+      atom_t cdr = lisp_cdr(lisp, cell);
+      X(lisp, cell);
+      result = lisp_rope_dup(lisp, car);
+      cell = cdr;
+    } else {
+      result = lisp_make_rope(lisp);
+      if (IS_ROPE(result) && !lisp_rope_push(lisp, result, car)) {
+        X(lisp, result);
+        result = lisp_make_nil(lisp);
+      }
+      atom_t cdr = lisp_cdr(lisp, cell);
+      X(lisp, cell);
+      cell = cdr;
+    }
+    X(lisp, car);
+  } else {
+    result = lisp_make_rope(lisp);
+  }
+  /*
+   * Append the remaining arguments.
+   */
+  if (!IS_ROPE(result)) {
+    X(lisp, cell);
+    return result;
+  }
+  return lisp_rope_all(lisp, C, cell, result);
+}
+
+LISP_MODULE_SETUP(rope, rope, ANY)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
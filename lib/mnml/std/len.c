@@ -1,6 +1,10 @@
+#include <mnml/array.h>
+#include <mnml/buffer.h>
 #include <mnml/types.h>
 #include <mnml/lisp.h>
 #include <mnml/module.h>
+#include <mnml/record.h>
+#include <mnml/rope.h>
 #include <mnml/slab.h>
 #include <mnml/utils.h>
 
@@ -11,6 +15,18 @@ lisp_function_len(const lisp_t lisp, const atom_t closure)
   if (IS_LIST(X)) {
     return lisp_make_number(lisp, (int64_t)lisp_len(X));
   }
+  if (IS_BUFF(X)) {
+    return lisp_make_number(lisp, (int64_t)BUFFER_LEN(X));
+  }
+  if (IS_ARRY(X)) {
+    return lisp_make_number(lisp, (int64_t)ARRAY_LEN(X));
+  }
+  if (IS_ROPE(X)) {
+    return lisp_make_number(lisp, (int64_t)ROPE_LEN(X));
+  }
+  if (IS_RECD(X)) {
+    return lisp_make_number(lisp, (int64_t)RECORD_LEN(X));
+  }
   return lisp_make_nil(lisp);
 }
 
@@ -1,13 +1,42 @@
 #include <mnml/lisp.h>
 #include <mnml/module.h>
+#include <mnml/record.h>
 #include <mnml/slab.h>
 
+static bool atom_match(const atom_t a, const atom_t b);
+
+/*
+ * Match a list pattern with the (NAME FIELD ...) view of a record.
+ */
+
+static bool
+record_match(const atom_t a, const atom_t b)
+{
+  if (!atom_match(CAR(a), RECORD_NAME(b))) {
+    return false;
+  }
+  atom_t p = CDR(a);
+  for (size_t i = 0; i < RECORD_LEN(b); i += 1) {
+    if (IS_WILD(p)) {
+      return true;
+    }
+    if (!IS_PAIR(p) || !atom_match(CAR(p), RECORD_FIELD(b, i))) {
+      return false;
+    }
+    p = CDR(p);
+  }
+  return IS_NULL(p) || IS_WILD(p);
+}
+
 static bool
 atom_match(const atom_t a, const atom_t b)
 {
   if (IS_WILD(a)) {
     return true;
   }
+  if (IS_PAIR(a) && IS_RECD(b)) {
+    return record_match(a, b);
+  }
   if (a->type != b->type) {
     return false;
   }
@@ -19,6 +48,12 @@ atom_match(const atom_t a, const atom_t b)
       return atom_match(CAR(a), CAR(b)) && atom_match(CDR(a), CDR(b));
     case T_SYMBOL:
       return lisp_symbol_match(a, &b->symbol);
+    case T_BUFFER:
+    case T_ARRAY:
+    case T_BIGNUM:
+    case T_ROPE:
+    case T_RECORD:
+      return lisp_equ(a, b);
     default:
       return true;
   }
@@ -0,0 +1,23 @@
+#include "thread.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_chan(const lisp_t lisp, UNUSED const atom_t closure)
+{
+  thread_chan_t* chan = lisp_thread_chan_new();
+  if (chan == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  const int64_t handle = lisp_handle_new(&THREAD_CHANS, chan);
+  if (handle < 0) {
+    lisp_thread_chan_delete(chan);
+    return lisp_make_nil(lisp);
+  }
+  return lisp_make_number(lisp, handle);
+}
+
+LISP_MODULE_SETUP(chan, thread/chan)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,27 @@
+#include "thread.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_close(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, CH);
+  thread_chan_t* chan = lisp_handle_get(&THREAD_CHANS, CH);
+  if (chan == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Close the handle and wake up a consumer blocked on the channel.
+   */
+  const bool ok = lisp_handle_close(&THREAD_CHANS, CH);
+  if (ok) {
+    lisp_thread_chan_close(chan);
+  }
+  lisp_handle_put(&THREAD_CHANS, CH);
+  return ok ? lisp_make_true(lisp) : lisp_make_nil(lisp);
+}
+
+LISP_MODULE_SETUP(close, thread/close, CH, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,21 @@
+#include "thread.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_fd(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, CH);
+  thread_chan_t* chan = lisp_handle_get(&THREAD_CHANS, CH);
+  if (chan == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  const int fd = chan->fds[0];
+  lisp_handle_put(&THREAD_CHANS, CH);
+  return lisp_make_number(lisp, fd);
+}
+
+LISP_MODULE_SETUP(fd, thread/fd, CH, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,28 @@
+#include "thread.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_join(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, TH);
+  thread_t* thread = lisp_handle_get(&THREAD_THREADS, TH);
+  if (thread == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Only one caller gets to join the thread.
+   */
+  if (!lisp_handle_close(&THREAD_THREADS, TH)) {
+    lisp_handle_put(&THREAD_THREADS, TH);
+    return lisp_make_nil(lisp);
+  }
+  atom_t res = lisp_thread_join(lisp, thread);
+  lisp_handle_put(&THREAD_THREADS, TH);
+  return res;
+}
+
+LISP_MODULE_SETUP(join, thread/join, TH, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,32 @@
+#include <mnml/module.h>
+
+LISP_MODULE_DECL(chan);
+LISP_MODULE_DECL(close);
+LISP_MODULE_DECL(fd);
+LISP_MODULE_DECL(join);
+LISP_MODULE_DECL(new);
+LISP_MODULE_DECL(recv);
+LISP_MODULE_DECL(send);
+LISP_MODULE_DECL(try);
+
+module_entry_t ENTRIES[] = {
+  LISP_MODULE_REGISTER(chan), LISP_MODULE_REGISTER(close),
+  LISP_MODULE_REGISTER(fd),   LISP_MODULE_REGISTER(join),
+  LISP_MODULE_REGISTER(new),  LISP_MODULE_REGISTER(recv),
+  LISP_MODULE_REGISTER(send), LISP_MODULE_REGISTER(try),
+  { NULL, NULL }
+};
+
+const char* USED
+lisp_module_name()
+{
+  return "thread";
+}
+
+const module_entry_t* USED
+lisp_module_entries()
+{
+  return ENTRIES;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,28 @@
+#include "thread.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_new(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, FN, ARG);
+  if (IS_NULL(FN)) {
+    return lisp_make_nil(lisp);
+  }
+  thread_t* thread = lisp_thread_new(lisp, FN, ARG);
+  if (thread == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  const int64_t handle = lisp_handle_new(&THREAD_THREADS, thread);
+  if (handle < 0) {
+    X(lisp, lisp_thread_join(lisp, thread));
+    lisp_thread_delete(thread);
+    return lisp_make_nil(lisp);
+  }
+  return lisp_make_number(lisp, handle);
+}
+
+LISP_MODULE_SETUP(new, thread/new, FN, ARG, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
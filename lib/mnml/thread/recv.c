@@ -0,0 +1,31 @@
+#include "thread.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <stdlib.h>
+
+static atom_t USED
+lisp_function_recv(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, CH);
+  thread_chan_t* chan = lisp_handle_get(&THREAD_CHANS, CH);
+  if (chan == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Wait for a message and decode it.
+   */
+  thread_message_t msg;
+  const bool ok = lisp_thread_chan_pop(lisp, chan, &msg, true);
+  lisp_handle_put(&THREAD_CHANS, CH);
+  if (!ok) {
+    return lisp_make_nil(lisp);
+  }
+  atom_t res = lisp_thread_decode(lisp, &msg);
+  free(msg.data);
+  return res == NULL ? lisp_make_nil(lisp) : res;
+}
+
+LISP_MODULE_SETUP(recv, thread/recv, CH, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
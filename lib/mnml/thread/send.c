@@ -0,0 +1,30 @@
+#include "thread.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <stdlib.h>
+
+static atom_t USED
+lisp_function_send(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, CH, VAL);
+  thread_chan_t* chan = lisp_handle_get(&THREAD_CHANS, CH);
+  if (chan == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Encode the value and hand the message over to the channel.
+   */
+  thread_message_t msg;
+  bool ok = lisp_thread_encode(lisp, VAL, &msg);
+  if (ok && !lisp_thread_chan_push(chan, &msg)) {
+    free(msg.data);
+    ok = false;
+  }
+  lisp_handle_put(&THREAD_CHANS, CH);
+  return ok ? lisp_make_true(lisp) : lisp_make_nil(lisp);
+}
+
+LISP_MODULE_SETUP(send, thread/send, CH, VAL, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
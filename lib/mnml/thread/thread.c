@@ -0,0 +1,401 @@
+#include "thread.h"
+#include <mnml/binary.h>
+#include <mnml/image.h>
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * Handle tables.
+ */
+
+static void
+lisp_thread_chan_release(void* const ptr)
+{
+  lisp_thread_chan_delete((thread_chan_t*)ptr);
+}
+
+static void
+lisp_thread_release(void* const ptr)
+{
+  lisp_thread_delete((thread_t*)ptr);
+}
+
+handle_table_t THREAD_CHANS = HANDLE_TABLE_INIT(lisp_thread_chan_release);
+handle_table_t THREAD_THREADS = HANDLE_TABLE_INIT(lisp_thread_release);
+
+static void DESTRUCTOR
+lisp_thread_fini()
+{
+  lisp_handle_fini(&THREAD_CHANS);
+  lisp_handle_fini(&THREAD_THREADS);
+}
+
+/*
+ * Messages.
+ */
+
+bool
+lisp_thread_encode(const lisp_t lisp, const atom_t cell,
+                   thread_message_t* const msg)
+{
+  msg->next = NULL;
+  msg->data = NULL;
+  msg->len = 0;
+  FILE* handle = open_memstream(&msg->data, &msg->len);
+  if (handle == NULL) {
+    TRACE("open_memstream() failed: %s", strerror(errno));
+    return false;
+  }
+  const bool ok = lisp_bin_write(lisp, handle, cell);
+  if (fclose(handle) != 0 || !ok) {
+    free(msg->data);
+    msg->data = NULL;
+    return false;
+  }
+  return true;
+}
+
+atom_t
+lisp_thread_decode(const lisp_t lisp, const thread_message_t* const msg)
+{
+  FILE* handle = fmemopen(msg->data, msg->len, "r");
+  if (handle == NULL) {
+    return NULL;
+  }
+  atom_t res = lisp_bin_read(lisp, handle);
+  fclose(handle);
+  return res;
+}
+
+/*
+ * Channels.
+ */
+
+thread_chan_t*
+lisp_thread_chan_new()
+{
+  thread_chan_t* chan;
+  if (posix_memalign((void**)&chan, 64, sizeof(thread_chan_t)) != 0) {
+    return NULL;
+  }
+  /*
+   * The queue starts with a stub message.
+   */
+  thread_message_t* stub = (thread_message_t*)calloc(1, sizeof(*stub));
+  if (stub == NULL) {
+    free(chan);
+    return NULL;
+  }
+  chan->head = stub;
+  chan->tail = stub;
+  chan->count = 0;
+  chan->owner = NULL;
+  chan->closed = false;
+  /*
+   * Create the notification pipe.
+   */
+  if (pipe(chan->fds) < 0) {
+    TRACE("pipe() failed: %s", strerror(errno));
+    free(stub);
+    free(chan);
+    return NULL;
+  }
+  for (size_t i = 0; i < 2; i += 1) {
+    fcntl(chan->fds[i], F_SETFL, fcntl(chan->fds[i], F_GETFL) | O_NONBLOCK);
+    fcntl(chan->fds[i], F_SETFD, FD_CLOEXEC);
+  }
+  return chan;
+}
+
+void
+lisp_thread_chan_delete(thread_chan_t* const chan)
+{
+  thread_message_t* msg = chan->tail;
+  while (msg != NULL) {
+    thread_message_t* next = msg->next;
+    free(msg->data);
+    free(msg);
+    msg = next;
+  }
+  close(chan->fds[0]);
+  close(chan->fds[1]);
+  free(chan);
+}
+
+static void
+lisp_thread_chan_notify(thread_chan_t* const chan)
+{
+  const char c = 0;
+  while (write(chan->fds[1], &c, 1) < 0 && errno == EINTR)
+    ;
+}
+
+void
+lisp_thread_chan_close(thread_chan_t* const chan)
+{
+  __atomic_store_n(&chan->closed, true, __ATOMIC_RELEASE);
+  lisp_thread_chan_notify(chan);
+}
+
+bool
+lisp_thread_chan_push(thread_chan_t* const chan, thread_message_t* const msg)
+{
+  thread_message_t* node = (thread_message_t*)malloc(sizeof(*node));
+  if (node == NULL) {
+    return false;
+  }
+  *node = *msg;
+  node->next = NULL;
+  /*
+   * Link the message after the previous head.
+   */
+  thread_message_t* prev =
+    __atomic_exchange_n(&chan->head, node, __ATOMIC_ACQ_REL);
+  __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+  /*
+   * Notify the consumer if the channel was empty.
+   */
+  if (__atomic_fetch_add(&chan->count, 1, __ATOMIC_ACQ_REL) == 0) {
+    lisp_thread_chan_notify(chan);
+  }
+  return true;
+}
+
+static void
+lisp_thread_chan_drain(thread_chan_t* const chan)
+{
+  char buf[64];
+  ssize_t ret;
+  do {
+    ret = read(chan->fds[0], buf, sizeof(buf));
+  } while (ret > 0 || (ret < 0 && errno == EINTR));
+}
+
+bool
+lisp_thread_chan_pop(const lisp_t lisp, thread_chan_t* const chan,
+                     thread_message_t* const msg, const bool block)
+{
+  /*
+   * Claim the channel, or check that it is ours.
+   */
+  lisp_t owner = NULL;
+  if (!__atomic_compare_exchange_n(&chan->owner, &owner, lisp, false,
+                                   __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE) &&
+      owner != lisp) {
+    TRACE("Channel is owned by another context");
+    return false;
+  }
+  for (;;) {
+    if (__atomic_load_n(&chan->closed, __ATOMIC_ACQUIRE)) {
+      return false;
+    }
+    if (__atomic_load_n(&chan->count, __ATOMIC_ACQUIRE) > 0) {
+      /*
+       * Wait for the producer to link its message. The message becomes the
+       * stub of the queue.
+       */
+      thread_message_t* tail = chan->tail;
+      thread_message_t* next;
+      thread_message_t** const link = &tail->next;
+      while ((next = __atomic_load_n(link, __ATOMIC_ACQUIRE)) == NULL) {
+        sched_yield();
+      }
+      chan->tail = next;
+      msg->next = NULL;
+      msg->data = next->data;
+      msg->len = next->len;
+      next->data = NULL;
+      free(tail);
+      __atomic_fetch_sub(&chan->count, 1, __ATOMIC_ACQ_REL);
+      return true;
+    }
+    /*
+     * Consume the pending notifications, so that an event loop does not wake
+     * up for an empty channel, and check again.
+     */
+    lisp_thread_chan_drain(chan);
+    if (__atomic_load_n(&chan->count, __ATOMIC_ACQUIRE) > 0 ||
+        __atomic_load_n(&chan->closed, __ATOMIC_ACQUIRE)) {
+      continue;
+    }
+    if (!block) {
+      return false;
+    }
+    /*
+     * Wait for a notification.
+     */
+    if (!lisp_wait(lisp, chan->fds[0], POLLIN)) {
+      return false;
+    }
+  }
+}
+
+/*
+ * Threads.
+ */
+
+static atom_t
+lisp_thread_run(const lisp_t lisp, thread_t* const thread)
+{
+  MAKE_SYMBOL_STATIC(fn_s, "FN");
+  /*
+   * Restore the image of the parent context and read the call.
+   */
+  FILE* handle = fmemopen(thread->msg.data, thread->msg.len, "r");
+  if (handle == NULL) {
+    return NULL;
+  }
+  const bool ok = lisp_image_read(lisp, handle);
+  atom_t call = ok ? lisp_bin_read(lisp, handle) : NULL;
+  fclose(handle);
+  if (call == NULL) {
+    return NULL;
+  }
+  if (!IS_PAIR(call)) {
+    X(lisp, call);
+    return NULL;
+  }
+  /*
+   * Bind FN and build (FN 'ARG).
+   */
+  atom_t fun = lisp_make_symbol(lisp, fn_s);
+  atom_t val = lisp_cons(lisp, UP(fun), lisp_car(lisp, call));
+  atom_t env = lisp_cons(lisp, val, lisp_make_nil(lisp));
+  atom_t arg = lisp_cons(lisp, lisp_make_quote(lisp), lisp_cdr(lisp, call));
+  atom_t cn0 = lisp_cons(lisp, arg, lisp_make_nil(lisp));
+  atom_t exp = lisp_cons(lisp, fun, cn0);
+  X(lisp, call);
+  /*
+   * Call the function with the standard channels.
+   */
+  lisp_chan_push(lisp, &lisp->ichan, stdin, thread->pwd);
+  lisp_chan_push(lisp, &lisp->ochan, stdout, thread->pwd);
+  atom_t res = lisp_eval(lisp, env, exp);
+  lisp_chan_pop(lisp, &lisp->ichan);
+  lisp_chan_pop(lisp, &lisp->ochan);
+  X(lisp, env);
+  return res;
+}
+
+static void*
+lisp_thread_main(void* const arg)
+{
+  thread_t* const thread = (thread_t*)arg;
+  /*
+   * Create the context of the thread.
+   */
+  slab_t slab = slab_new();
+  lisp_t lisp = lisp_new(slab);
+  atom_t res = module_init(lisp) ? lisp_thread_run(lisp, thread) : NULL;
+  /*
+   * Replace the image with the result.
+   */
+  free(thread->msg.data);
+  thread->msg.data = NULL;
+  thread->msg.len = 0;
+  if (res != NULL) {
+    lisp_thread_encode(lisp, res, &thread->msg);
+    X(lisp, res);
+  }
+  /*
+   * Destroy the context.
+   */
+  module_fini(lisp);
+  lisp_delete(lisp);
+  slab_delete(slab);
+  return NULL;
+}
+
+thread_t*
+lisp_thread_new(const lisp_t lisp, const atom_t FN, const atom_t ARG)
+{
+  thread_t* thread = (thread_t*)malloc(sizeof(thread_t));
+  if (thread == NULL) {
+    return NULL;
+  }
+  /*
+   * Grab the working directory.
+   */
+  if (!IO_CONTEXT_EMPTY(lisp->ichan)) {
+    strcpy(thread->pwd, IO_CONTEXT(lisp->ichan)->pwd);
+  } else if (getcwd(thread->pwd, PATH_MAX) == NULL) {
+    strcpy(thread->pwd, ".");
+  }
+  /*
+   * Write the image of the context and the call.
+   */
+  thread->msg.data = NULL;
+  thread->msg.len = 0;
+  FILE* handle = open_memstream(&thread->msg.data, &thread->msg.len);
+  if (handle == NULL) {
+    free(thread);
+    return NULL;
+  }
+  atom_t call = lisp_cons(lisp, UP(FN), UP(ARG));
+  bool ok = lisp_image_write(lisp, handle, true) &&
+            lisp_bin_write(lisp, handle, call);
+  X(lisp, call);
+  ok = fclose(handle) == 0 && ok;
+  /*
+   * Flush the output and start the thread.
+   */
+  pthread_attr_t attr;
+  if (ok) {
+    lisp_flush(lisp);
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE);
+    const int rc =
+      pthread_create(&thread->tid, &attr, lisp_thread_main, thread);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+      TRACE("pthread_create() failed: %s", strerror(rc));
+      ok = false;
+    }
+  }
+  if (!ok) {
+    free(thread->msg.data);
+    free(thread);
+    return NULL;
+  }
+  return thread;
+}
+
+atom_t
+lisp_thread_join(const lisp_t lisp, thread_t* const thread)
+{
+  /*
+   * Wait for the thread.
+   */
+  const int rc = pthread_join(thread->tid, NULL);
+  if (rc != 0) {
+    TRACE("pthread_join() failed: %s", strerror(rc));
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Decode its result.
+   */
+  atom_t res = NULL;
+  if (thread->msg.data != NULL) {
+    res = lisp_thread_decode(lisp, &thread->msg);
+  }
+  return res == NULL ? lisp_make_nil(lisp) : res;
+}
+
+void
+lisp_thread_delete(thread_t* const thread)
+{
+  free(thread->msg.data);
+  free(thread);
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <mnml/handle.h>
+#include <mnml/lisp.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Stack size of the threads. The evaluator is recursive.
+ */
+
+#define THREAD_STACK_SIZE (8 * 1024 * 1024)
+
+/*
+ * Values cross threads as binary messages. The atoms of a context belong to its
+ * slab, so a value is encoded by the sender and decoded by the receiver, and
+ * the message itself is handed over without being copied.
+ */
+
+typedef struct thread_message
+{
+  struct thread_message* next;
+  char* data;
+  size_t len;
+} thread_message_t;
+
+bool lisp_thread_encode(const lisp_t lisp, const atom_t cell,
+                        thread_message_t* const msg);
+atom_t lisp_thread_decode(const lisp_t lisp, const thread_message_t* const msg);
+
+/*
+ * Multiple-producer, single-consumer channel. Producers push messages with an
+ * atomic exchange on HEAD and the consumer pops them from TAIL. COUNT is the
+ * number of messages not yet received. The producer that makes it non-zero
+ * writes to the notification pipe, which wakes up a blocked consumer and can be
+ * watched by an event loop.
+ *
+ * The first context that receives from the channel becomes its OWNER, and the
+ * other contexts cannot receive from it. CLOSED is set when the channel is
+ * closed, and wakes up a blocked consumer.
+ */
+
+typedef struct thread_chan
+{
+  thread_message_t* head __attribute__((aligned(64)));
+  thread_message_t* tail __attribute__((aligned(64)));
+  size_t count __attribute__((aligned(64)));
+  lisp_t owner;
+  bool closed;
+  int fds[2];
+} thread_chan_t;
+
+thread_chan_t* lisp_thread_chan_new();
+void lisp_thread_chan_delete(thread_chan_t* const chan);
+void lisp_thread_chan_close(thread_chan_t* const chan);
+
+/*
+ * Channels are shared by threads through their handles. The table is global,
+ * and a channel is deleted once it is closed and no longer in use.
+ */
+
+extern handle_table_t THREAD_CHANS;
+
+bool lisp_thread_chan_push(thread_chan_t* const chan,
+                           thread_message_t* const msg);
+
+/*
+ * Pop a message. Return false if the channel is empty and BLOCK is not set, if
+ * the channel is closed, or if it is owned by another context.
+ */
+
+bool lisp_thread_chan_pop(const lisp_t lisp, thread_chan_t* const chan,
+                          thread_message_t* const msg, const bool block);
+
+/*
+ * Thread. MSG holds the image and the call to run, then the result.
+ */
+
+typedef struct thread
+{
+  pthread_t tid;
+  thread_message_t msg;
+  char pwd[PATH_MAX];
+} thread_t;
+
+thread_t* lisp_thread_new(const lisp_t lisp, const atom_t FN,
+                          const atom_t ARG);
+void lisp_thread_delete(thread_t* const thread);
+
+atom_t lisp_thread_join(const lisp_t lisp, thread_t* const thread);
+
+/*
+ * Handles of the threads. A handle is closed when its thread is joined.
+ */
+
+extern handle_table_t THREAD_THREADS;
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
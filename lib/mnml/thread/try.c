@@ -0,0 +1,34 @@
+#include "thread.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <stdlib.h>
+
+static atom_t USED
+lisp_function_try(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, CH);
+  thread_chan_t* chan = lisp_handle_get(&THREAD_CHANS, CH);
+  if (chan == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Return the message in a list, to tell NIL from an empty channel.
+   */
+  thread_message_t msg;
+  const bool ok = lisp_thread_chan_pop(lisp, chan, &msg, false);
+  lisp_handle_put(&THREAD_CHANS, CH);
+  if (!ok) {
+    return lisp_make_nil(lisp);
+  }
+  atom_t res = lisp_thread_decode(lisp, &msg);
+  free(msg.data);
+  if (res == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  return lisp_cons(lisp, res, lisp_make_nil(lisp));
+}
+
+LISP_MODULE_SETUP(try, thread/try, CH, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -1,38 +1,13 @@
+#include "unix.h"
 #include <mnml/lisp.h>
 #include <mnml/module.h>
 #include <mnml/slab.h>
 #include <arpa/inet.h>
 #include <errno.h>
 #include <netinet/in.h>
+#include <poll.h>
 #include <sys/socket.h>
 
-static atom_t
-convert(const lisp_t lisp, const struct sockaddr_in* const sa)
-{
-  /*
-   * Make sure the protocol is right.
-   */
-  if (sa->sin_family != AF_INET) {
-    TRACE("Unsupported protocol: %d", sa->sin_family);
-    return lisp_make_nil(lisp);
-  }
-  /*
-   * Grab the host.
-   */
-  char buffer[INET_ADDRSTRLEN + 1] = { 0 };
-  inet_ntop(AF_INET, &(sa->sin_addr), buffer, INET_ADDRSTRLEN);
-  atom_t host = lisp_make_string(lisp, buffer, strlen(buffer));
-  /*
-   * Grab the port.
-   */
-  uint16_t pval = ntohs(sa->sin_port);
-  atom_t port = lisp_make_number(lisp, pval);
-  /*
-   * Construct and return the result.
-   */
-  return lisp_cons(lisp, host, port);
-}
-
 static atom_t USED
 lisp_function_accept(const lisp_t lisp, const atom_t closure)
 {
@@ -44,8 +19,13 @@ lisp_function_accept(const lisp_t lisp, const atom_t closure)
     return lisp_make_nil(lisp);
   }
   /*
-   * Call accept() on the file descriptor.
+   * Let the other coroutines run until a connection is pending, and call
+   * accept() on the file descriptor.
    */
+  if (lisp->wait_handler != NULL &&
+      !lisp_wait(lisp, (int)FD->number, POLLIN)) {
+    return lisp_make_nil(lisp);
+  }
   struct sockaddr_in addr;
   socklen_t len = sizeof(addr);
   int res = accept((int)FD->number, (struct sockaddr*)&addr, &len);
@@ -57,7 +37,7 @@ lisp_function_accept(const lisp_t lisp, const atom_t closure)
    * Construct the result.
    */
   atom_t clfd = lisp_make_number(lisp, res);
-  atom_t clad = convert(lisp, &addr);
+  atom_t clad = lisp_unix_address(lisp, &addr);
   return lisp_cons(lisp, clfd, clad);
 }
 
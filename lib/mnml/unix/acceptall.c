@@ -0,0 +1,81 @@
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/*
+ * Default number of connections accepted per call.
+ */
+
+#define ACCEPT_DEFAULT_MAX 64
+
+#if defined(__linux__) || defined(__FreeBSD__) || defined(__OpenBSD__)
+#define HAS_ACCEPT4
+#endif
+
+static int
+lisp_accept_one(const int fd)
+{
+#ifdef HAS_ACCEPT4
+  return accept4(fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+  const int res = accept(fd, NULL, NULL);
+  if (res >= 0) {
+    fcntl(res, F_SETFL, fcntl(res, F_GETFL) | O_NONBLOCK);
+    fcntl(res, F_SETFD, FD_CLOEXEC);
+  }
+  return res;
+#endif
+}
+
+static atom_t USED
+lisp_function_acceptall(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, FD, MAX);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_NUMB(FD) || FD->number < 0 || FD->number >= UINT32_MAX ||
+      !(IS_NULL(MAX) || (IS_NUMB(MAX) && MAX->number > 0))) {
+    return lisp_make_nil(lisp);
+  }
+  const int fd = (int)FD->number;
+  const int64_t max = IS_NULL(MAX) ? ACCEPT_DEFAULT_MAX : MAX->number;
+  /*
+   * Make sure the server socket does not block once drained.
+   */
+  const int flags = fcntl(fd, F_GETFL);
+  if (flags < 0 ||
+      (!(flags & O_NONBLOCK) && fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)) {
+    TRACE("fcntl() failed: %s", strerror(errno));
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Drain the accept queue.
+   */
+  builder_t bld;
+  lisp_builder_init(lisp, &bld);
+  for (int64_t i = 0; i < max; i += 1) {
+    const int res = lisp_accept_one(fd);
+    if (res < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        TRACE("accept() failed: %s", strerror(errno));
+      }
+      break;
+    }
+    lisp_builder_push(lisp, &bld, lisp_make_number(lisp, res));
+  }
+  return bld.head;
+}
+
+LISP_MODULE_SETUP(acceptall, accept-all, FD, MAX, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -37,7 +37,7 @@ lisp_exec_make_strings(const lisp_t lisp, const atom_t cell, char** array,
 }
 
 static atom_t USED
-lisp_function_exec(UNUSED const lisp_t lisp, const atom_t closure)
+lisp_function_exec(const lisp_t lisp, const atom_t closure)
 {
   TRACE_CLOS_SEXP(closure);
   /*
@@ -61,8 +61,9 @@ lisp_function_exec(UNUSED const lisp_t lisp, const atom_t closure)
   char* env_str[MAX_ARGS + 1];
   size_t len = lisp_exec_make_strings(lisp, UP(ENVP), env_str, MAX_ARGS, 0);
   /*
-   * Call execve.
+   * Flush the output and call execve.
    */
+  lisp_flush(lisp);
   execve(buffer, arg_str, len == 0 ? environ : env_str);
   printf("%s\n", strerror(errno));
   exit(errno);
@@ -7,6 +7,10 @@
 static atom_t USED
 lisp_function_fork(const lisp_t lisp, UNUSED const atom_t closure)
 {
+  /*
+   * Flush the output so that it is not duplicated in the child.
+   */
+  lisp_flush(lisp);
   pid_t pid = fork();
   return lisp_make_number(lisp, pid < 0 ? errno : pid);
 }
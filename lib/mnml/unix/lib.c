@@ -1,24 +1,36 @@
 #include <mnml/module.h>
 
 LISP_MODULE_DECL(accept);
+LISP_MODULE_DECL(acceptall);
 LISP_MODULE_DECL(close);
 LISP_MODULE_DECL(connect);
 LISP_MODULE_DECL(dup);
 LISP_MODULE_DECL(exec);
 LISP_MODULE_DECL(fork);
 LISP_MODULE_DECL(listen);
+LISP_MODULE_DECL(peer);
+LISP_MODULE_DECL(pfold);
 LISP_MODULE_DECL(pipe);
+LISP_MODULE_DECL(pmap);
+LISP_MODULE_DECL(prefork);
 LISP_MODULE_DECL(select);
+LISP_MODULE_DECL(sendfile);
+LISP_MODULE_DECL(splice);
+LISP_MODULE_DECL(tee);
 LISP_MODULE_DECL(time);
 LISP_MODULE_DECL(unlink);
 LISP_MODULE_DECL(wait);
 
 module_entry_t ENTRIES[] = {
-  LISP_MODULE_REGISTER(accept),  LISP_MODULE_REGISTER(close),
-  LISP_MODULE_REGISTER(connect), LISP_MODULE_REGISTER(dup),
-  LISP_MODULE_REGISTER(exec),    LISP_MODULE_REGISTER(fork),
-  LISP_MODULE_REGISTER(listen),  LISP_MODULE_REGISTER(pipe),
-  LISP_MODULE_REGISTER(select),  LISP_MODULE_REGISTER(unlink),
+  LISP_MODULE_REGISTER(accept),  LISP_MODULE_REGISTER(acceptall),
+  LISP_MODULE_REGISTER(close),   LISP_MODULE_REGISTER(connect),
+  LISP_MODULE_REGISTER(dup),     LISP_MODULE_REGISTER(exec),
+  LISP_MODULE_REGISTER(fork),    LISP_MODULE_REGISTER(listen),
+  LISP_MODULE_REGISTER(peer),    LISP_MODULE_REGISTER(pfold),
+  LISP_MODULE_REGISTER(pipe),    LISP_MODULE_REGISTER(pmap),
+  LISP_MODULE_REGISTER(prefork), LISP_MODULE_REGISTER(select),
+  LISP_MODULE_REGISTER(sendfile), LISP_MODULE_REGISTER(splice),
+  LISP_MODULE_REGISTER(tee),     LISP_MODULE_REGISTER(unlink),
   LISP_MODULE_REGISTER(wait),    { NULL, NULL }
 };
 
@@ -12,23 +12,16 @@
 #define SOL_TCP IPPROTO_TCP
 #endif
 
-static atom_t USED
-lisp_function_listen(UNUSED const lisp_t lisp, const atom_t closure)
+static int
+lisp_listen(const int port, const int backlog)
 {
-  LISP_ARGS(closure, C, PORT);
-  /*
-   * Make sure the port is valid.
-   */
-  if (!IS_NUMB(PORT) || PORT->number < 0 || PORT->number >= UINT16_MAX) {
-    return lisp_make_nil(lisp);
-  }
   /*
    * Create the TCP socket.
    */
   const int fd = socket(AF_INET, SOCK_STREAM, 0);
   if (fd < 0) {
     TRACE("socket() failed: %s", strerror(errno));
-    return lisp_make_nil(lisp);
+    return -1;
   }
   /*
    * Set TCP_NODELAY and SO_REUSEPORT.
@@ -38,13 +31,13 @@ lisp_function_listen(UNUSED const lisp_t lisp, const atom_t closure)
   if (res < 0) {
     close(fd);
     TRACE("setsockopt(TCP_NODELAY) failed: %s", strerror(errno));
-    return lisp_make_nil(lisp);
+    return -1;
   }
   res = setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
   if (res < 0) {
     close(fd);
     TRACE("setsockopt(SO_REUSEPORT) failed: %s", strerror(errno));
-    return lisp_make_nil(lisp);
+    return -1;
   }
   /*
    * Prepare the socket address.
@@ -53,7 +46,7 @@ lisp_function_listen(UNUSED const lisp_t lisp, const atom_t closure)
   memset(&sa_in, 0, sizeof(sa_in));
   sa_in.sin_family = AF_INET;
   sa_in.sin_addr.s_addr = INADDR_ANY;
-  sa_in.sin_port = htons(PORT->number);
+  sa_in.sin_port = htons(port);
   /*
    * Bind the socket.
    */
@@ -61,23 +54,49 @@ lisp_function_listen(UNUSED const lisp_t lisp, const atom_t closure)
   if (res < 0) {
     close(fd);
     TRACE("bind() failed: %s", strerror(errno));
-    return lisp_make_nil(lisp);
+    return -1;
   }
   /*
    * Listen on the socket.
    */
-  res = listen(fd, 5);
+  res = listen(fd, backlog);
   if (res < 0) {
     close(fd);
     TRACE("listen() failed: %s", strerror(errno));
+    return -1;
+  }
+  return fd;
+}
+
+static atom_t USED
+lisp_function_listen(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, ANY);
+  /*
+   * Grab the arguments.
+   */
+  atom_t port = lisp_eval(lisp, C, lisp_car(lisp, ANY));
+  atom_t cdr = lisp_cdr(lisp, ANY);
+  atom_t blog = lisp_eval(lisp, C, lisp_car(lisp, cdr));
+  X(lisp, cdr);
+  /*
+   * Make sure the port and the backlog are valid.
+   */
+  if (!IS_NUMB(port) || port->number < 0 || port->number >= UINT16_MAX ||
+      !(IS_NULL(blog) || (IS_NUMB(blog) && blog->number > 0 &&
+                          blog->number <= INT32_MAX))) {
+    X(lisp, port, blog);
     return lisp_make_nil(lisp);
   }
   /*
-   * Return the socket.
+   * Listen on the port, with the system backlog by default.
    */
-  return lisp_make_number(lisp, fd);
+  const int backlog = IS_NULL(blog) ? SOMAXCONN : (int)blog->number;
+  const int fd = lisp_listen((int)port->number, backlog);
+  X(lisp, port, blog);
+  return fd < 0 ? lisp_make_nil(lisp) : lisp_make_number(lisp, fd);
 }
 
-LISP_MODULE_SETUP(listen, listen, PORT, NIL)
+LISP_MODULE_SETUP(listen, listen, ANY)
 
 // vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,271 @@
+#include "unix.h"
+#include <mnml/binary.h>
+#include <mnml/lisp.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/*
+ * Results of a worker, as they are received.
+ */
+
+typedef struct worker
+{
+  pid_t pid;
+  int fd;
+  char* data;
+  size_t len;
+  size_t size;
+} worker_t;
+
+/*
+ * Call (FN 'A) or (FN 'A 'B) in CLOSURE. A and B are consumed.
+ */
+
+static atom_t
+lisp_unix_call(const lisp_t lisp, const atom_t closure, const atom_t A,
+               const atom_t B)
+{
+  MAKE_SYMBOL_STATIC(fn_s, "FN");
+  atom_t res = lisp_make_nil(lisp);
+  if (B != NULL) {
+    atom_t qtb = lisp_cons(lisp, lisp_make_quote(lisp), B);
+    res = lisp_cons(lisp, qtb, res);
+  }
+  atom_t qta = lisp_cons(lisp, lisp_make_quote(lisp), A);
+  res = lisp_cons(lisp, qta, res);
+  res = lisp_cons(lisp, lisp_make_symbol(lisp, fn_s), res);
+  return lisp_eval(lisp, closure, res);
+}
+
+/*
+ * Process LEN elements of LST in a worker and write the results to FD.
+ */
+
+static void
+lisp_unix_work(const lisp_t lisp, const atom_t closure, const atom_t lst,
+               const size_t len, const atom_t ACC, const int fd)
+{
+  FILE* handle = fdopen(fd, "w");
+  if (handle == NULL) {
+    _exit(1);
+  }
+  atom_t acc = ACC == NULL ? NULL : UP(ACC);
+  atom_t cur = lst;
+  for (size_t i = 0; i < len; i += 1, cur = CDR(cur)) {
+    atom_t elt = UP(CAR(cur));
+    /*
+     * Folds carry their accumulator, maps write each result.
+     */
+    if (acc != NULL) {
+      acc = lisp_unix_call(lisp, closure, acc, elt);
+      continue;
+    }
+    atom_t res = lisp_unix_call(lisp, closure, elt, NULL);
+    const bool ok = lisp_bin_write(lisp, handle, res);
+    X(lisp, res);
+    if (!ok) {
+      _exit(1);
+    }
+  }
+  if (acc != NULL && !lisp_bin_write(lisp, handle, acc)) {
+    _exit(1);
+  }
+  lisp_flush(lisp);
+  _exit(fclose(handle) == 0 ? 0 : 1);
+}
+
+/*
+ * Start a worker for LEN elements of LST.
+ */
+
+static bool
+lisp_unix_start(const lisp_t lisp, const atom_t closure, const atom_t lst,
+                const size_t len, const atom_t ACC, worker_t* const wrk)
+{
+  int fds[2];
+  if (pipe(fds) < 0) {
+    TRACE("pipe() failed: %s", strerror(errno));
+    return false;
+  }
+  wrk->pid = fork();
+  if (wrk->pid < 0) {
+    TRACE("fork() failed: %s", strerror(errno));
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+  if (wrk->pid == 0) {
+    close(fds[0]);
+    lisp_unix_work(lisp, closure, lst, len, ACC, fds[1]);
+  }
+  close(fds[1]);
+  wrk->fd = fds[0];
+  return true;
+}
+
+/*
+ * Read the output of the workers as it comes, so that none of them blocks on a
+ * full pipe.
+ */
+
+static bool
+lisp_unix_drain(worker_t* const wrks, const size_t count)
+{
+  struct pollfd* pfds = (struct pollfd*)calloc(count, sizeof(struct pollfd));
+  if (pfds == NULL) {
+    return false;
+  }
+  size_t live = count;
+  bool ok = true;
+  while (ok && live > 0) {
+    size_t n = 0;
+    for (size_t i = 0; i < count; i += 1) {
+      if (wrks[i].fd >= 0) {
+        pfds[n++] = (struct pollfd){ .fd = wrks[i].fd, .events = POLLIN };
+      }
+    }
+    if (poll(pfds, n, -1) < 0) {
+      ok = errno == EINTR;
+      continue;
+    }
+    for (size_t i = 0, k = 0; i < count && ok; i += 1) {
+      worker_t* const wrk = &wrks[i];
+      if (wrk->fd < 0 || pfds[k++].revents == 0) {
+        continue;
+      }
+      /*
+       * Grow the result data and read.
+       */
+      if (wrk->size - wrk->len < 4096) {
+        const size_t size = wrk->size == 0 ? 65536 : wrk->size << 1;
+        char* data = (char*)realloc(wrk->data, size);
+        if (data == NULL) {
+          ok = false;
+          break;
+        }
+        wrk->data = data;
+        wrk->size = size;
+      }
+      const ssize_t ret =
+        read(wrk->fd, wrk->data + wrk->len, wrk->size - wrk->len);
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ret <= 0) {
+        ok = ret == 0;
+        close(wrk->fd);
+        wrk->fd = -1;
+        live -= 1;
+        continue;
+      }
+      wrk->len += ret;
+    }
+  }
+  free(pfds);
+  return ok;
+}
+
+/*
+ * Decode the results of a worker. Return the number of decoded values.
+ */
+
+static size_t
+lisp_unix_decode(const lisp_t lisp, const worker_t* const wrk,
+                 builder_t* const bld)
+{
+  size_t count = 0;
+  if (wrk->len == 0) {
+    return 0;
+  }
+  FILE* handle = fmemopen(wrk->data, wrk->len, "r");
+  if (handle == NULL) {
+    return 0;
+  }
+  for (atom_t res = lisp_bin_read(lisp, handle); res != NULL;
+       res = lisp_bin_read(lisp, handle)) {
+    lisp_builder_push(lisp, bld, res);
+    count += 1;
+  }
+  fclose(handle);
+  return count;
+}
+
+bool
+lisp_unix_spread(const lisp_t lisp, const atom_t closure, const size_t count,
+                 const atom_t LST, const atom_t ACC, builder_t* const bld)
+{
+  const size_t total = lisp_len(LST);
+  const size_t n = total < count ? total : count;
+  if (n == 0) {
+    return true;
+  }
+  worker_t* wrks = (worker_t*)calloc(n, sizeof(worker_t));
+  if (wrks == NULL) {
+    return false;
+  }
+  /*
+   * Split the list in contiguous slices and start the workers.
+   */
+  lisp_flush(lisp);
+  bool ok = true;
+  size_t started = 0;
+  atom_t cur = LST;
+  for (size_t i = 0; i < n && ok; i += 1) {
+    const size_t len = (i + 1) * total / n - i * total / n;
+    ok = lisp_unix_start(lisp, closure, cur, len, ACC, &wrks[i]);
+    started += ok ? 1 : 0;
+    for (size_t j = 0; j < len; j += 1) {
+      cur = CDR(cur);
+    }
+  }
+  /*
+   * Collect the results and wait for the workers.
+   */
+  ok = ok && lisp_unix_drain(wrks, n);
+  for (size_t i = 0; i < started; i += 1) {
+    if (wrks[i].fd >= 0) {
+      close(wrks[i].fd);
+    }
+    int state = 0;
+    pid_t pid;
+    do {
+      pid = waitpid(wrks[i].pid, &state, 0);
+    } while (pid < 0 && errno == EINTR);
+    ok = ok && pid > 0 && WIFEXITED(state) && WEXITSTATUS(state) == 0;
+  }
+  /*
+   * Rebuild the results in order.
+   */
+  for (size_t i = 0; i < n && ok; i += 1) {
+    const size_t len = (i + 1) * total / n - i * total / n;
+    const size_t exp = ACC == NULL ? len : 1;
+    ok = lisp_unix_decode(lisp, &wrks[i], bld) == exp;
+  }
+  for (size_t i = 0; i < n; i += 1) {
+    free(wrks[i].data);
+  }
+  free(wrks);
+  return ok;
+}
+
+atom_t
+lisp_unix_fold(const lisp_t lisp, const atom_t closure, const atom_t ACC,
+               const atom_t LST)
+{
+  atom_t acc = UP(ACC);
+  FOREACH(LST, p)
+  {
+    acc = lisp_unix_call(lisp, closure, acc, UP(p->car));
+    NEXT(p);
+  }
+  return acc;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
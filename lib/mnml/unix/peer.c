@@ -0,0 +1,34 @@
+#include "unix.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+
+static atom_t USED
+lisp_function_peer(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, FD);
+  /*
+   * Check the descriptor.
+   */
+  if (!IS_NUMB(FD) || FD->number < 0 || FD->number >= UINT32_MAX) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Get the address of the peer.
+   */
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  if (getpeername((int)FD->number, (struct sockaddr*)&addr, &len) < 0) {
+    TRACE("getpeername() failed: %s", strerror(errno));
+    return lisp_make_nil(lisp);
+  }
+  return lisp_unix_address(lisp, &addr);
+}
+
+LISP_MODULE_SETUP(peer, peer, FD, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
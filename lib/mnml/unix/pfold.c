@@ -0,0 +1,37 @@
+#include "unix.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+
+static atom_t USED
+lisp_function_pfold(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, N, FN, ACC, LST);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_NUMB(N) || N->number <= 0 || N->number > UINT16_MAX ||
+      IS_NULL(FN) || !IS_LIST(LST)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Fold the slices of LST in the workers.
+   */
+  builder_t bld;
+  lisp_builder_init(lisp, &bld);
+  if (!lisp_unix_spread(lisp, closure, N->number, LST, ACC, &bld)) {
+    X(lisp, bld.head);
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Fold the partial results.
+   */
+  atom_t res = lisp_unix_fold(lisp, closure, ACC, bld.head);
+  X(lisp, bld.head);
+  return res;
+}
+
+LISP_MODULE_SETUP(pfold, pfold, N, FN, ACC, LST, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,32 @@
+#include "unix.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+
+static atom_t USED
+lisp_function_pmap(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, N, FN, LST);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_NUMB(N) || N->number <= 0 || N->number > UINT16_MAX ||
+      IS_NULL(FN) || !IS_LIST(LST)) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Map FN over LST in the workers.
+   */
+  builder_t bld;
+  lisp_builder_init(lisp, &bld);
+  if (!lisp_unix_spread(lisp, closure, N->number, LST, NULL, &bld)) {
+    X(lisp, bld.head);
+    return lisp_make_nil(lisp);
+  }
+  return bld.head;
+}
+
+LISP_MODULE_SETUP(pmap, pmap, N, FN, LST, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
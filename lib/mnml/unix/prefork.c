@@ -0,0 +1,225 @@
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * Signals forwarded to the workers. SIGCHLD comes last and only wakes up the
+ * supervisor.
+ */
+
+static const int SIGNALS[] = { SIGHUP, SIGINT, SIGTERM, SIGCHLD };
+
+#define SIGNALS_LEN (sizeof(SIGNALS) / sizeof(SIGNALS[0]))
+#define SIGNALS_FWD (SIGNALS_LEN - 1)
+
+/*
+ * Delay before restarting a crashed worker, in milliseconds.
+ */
+
+#define PREFORK_RESTART_DELAY 100
+
+static volatile sig_atomic_t prefork_signal = 0;
+
+static void
+lisp_prefork_handler(const int sig)
+{
+  if (sig != SIGCHLD) {
+    prefork_signal = sig;
+  }
+}
+
+/*
+ * Handle the signals and block them. They are only delivered while the
+ * supervisor waits in sigsuspend(), so that none is missed between the check
+ * of PREFORK_SIGNAL and the wait. The previous mask is saved in MASK.
+ */
+
+static void
+lisp_prefork_signals(struct sigaction* const old, sigset_t* const mask)
+{
+  struct sigaction sa;
+  sigset_t set;
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = lisp_prefork_handler;
+  sigemptyset(&sa.sa_mask);
+  sigemptyset(&set);
+  for (size_t i = 0; i < SIGNALS_LEN; i += 1) {
+    sigaddset(&set, SIGNALS[i]);
+  }
+  sigprocmask(SIG_BLOCK, &set, mask);
+  for (size_t i = 0; i < SIGNALS_LEN; i += 1) {
+    sigaction(SIGNALS[i], &sa, &old[i]);
+  }
+}
+
+static void
+lisp_prefork_restore(const struct sigaction* const old,
+                     const sigset_t* const mask)
+{
+  for (size_t i = 0; i < SIGNALS_LEN; i += 1) {
+    sigaction(SIGNALS[i], &old[i], NULL);
+  }
+  sigprocmask(SIG_SETMASK, mask, NULL);
+}
+
+static void
+lisp_prefork_default(const struct sigaction* const old,
+                     const sigset_t* const mask)
+{
+  for (size_t i = 0; i < SIGNALS_FWD; i += 1) {
+    signal(SIGNALS[i], SIG_DFL);
+  }
+  sigaction(SIGCHLD, &old[SIGNALS_FWD], NULL);
+  sigprocmask(SIG_SETMASK, mask, NULL);
+}
+
+/*
+ * Start a worker. The worker calls FN and exits.
+ */
+
+static pid_t
+lisp_prefork_start(const lisp_t lisp, const atom_t closure,
+                   const struct sigaction* const old,
+                   const sigset_t* const mask)
+{
+  MAKE_SYMBOL_STATIC(fn_s, "FN");
+  pid_t pid = fork();
+  if (pid != 0) {
+    return pid;
+  }
+  /*
+   * Let the forwarded signals terminate the worker and call (FN).
+   */
+  lisp_prefork_default(old, mask);
+  atom_t fun = lisp_make_symbol(lisp, fn_s);
+  atom_t cns = lisp_cons(lisp, fun, lisp_make_nil(lisp));
+  atom_t res = lisp_eval(lisp, closure, cns);
+  X(lisp, res);
+  lisp_flush(lisp);
+  _exit(0);
+}
+
+static void
+lisp_prefork_sleep(const int ms)
+{
+  struct timespec ts = { .tv_sec = ms / 1000,
+                         .tv_nsec = (ms % 1000) * 1000000 };
+  nanosleep(&ts, NULL);
+}
+
+static atom_t USED
+lisp_function_prefork(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, N, FN);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_NUMB(N) || N->number <= 0 || N->number > UINT16_MAX || IS_NULL(FN)) {
+    return lisp_make_nil(lisp);
+  }
+  const size_t count = N->number;
+  pid_t* pids = (pid_t*)calloc(count, sizeof(pid_t));
+  if (pids == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Flush the output so that it is not duplicated in the workers, and handle
+   * the signals to forward.
+   */
+  struct sigaction old[SIGNALS_LEN];
+  sigset_t mask;
+  lisp_flush(lisp);
+  prefork_signal = 0;
+  lisp_prefork_signals(old, &mask);
+  /*
+   * Wait with the previous mask, the handled signals unblocked.
+   */
+  sigset_t wait = mask;
+  for (size_t i = 0; i < SIGNALS_LEN; i += 1) {
+    sigdelset(&wait, SIGNALS[i]);
+  }
+  /*
+   * Start the workers.
+   */
+  size_t alive = 0;
+  for (size_t i = 0; i < count; i += 1) {
+    pids[i] = lisp_prefork_start(lisp, closure, old, &mask);
+    if (pids[i] < 0) {
+      TRACE("fork() failed: %s", strerror(errno));
+      continue;
+    }
+    alive += 1;
+  }
+  /*
+   * Supervise the workers.
+   */
+  bool stopping = false;
+  while (alive > 0) {
+    /*
+     * Forward the received signal.
+     */
+    const int sig = prefork_signal;
+    if (sig != 0) {
+      prefork_signal = 0;
+      stopping = true;
+      for (size_t i = 0; i < count; i += 1) {
+        if (pids[i] > 0) {
+          kill(pids[i], sig);
+        }
+      }
+    }
+    /*
+     * Reap a terminated worker, or wait for a signal.
+     */
+    int state;
+    const pid_t pid = waitpid(-1, &state, WNOHANG);
+    if (pid < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      TRACE("waitpid() failed: %s", strerror(errno));
+      break;
+    }
+    if (pid == 0) {
+      sigsuspend(&wait);
+      continue;
+    }
+    size_t idx = 0;
+    for (; idx < count && pids[idx] != pid; idx += 1)
+      ;
+    if (idx == count) {
+      continue;
+    }
+    pids[idx] = 0;
+    alive -= 1;
+    /*
+     * Restart the workers that crashed.
+     */
+    const bool crashed =
+      WIFSIGNALED(state) || (WIFEXITED(state) && WEXITSTATUS(state) != 0);
+    if (crashed && !stopping) {
+      TRACE("Worker %d crashed, restarting", pid);
+      lisp_prefork_sleep(PREFORK_RESTART_DELAY);
+      pids[idx] = lisp_prefork_start(lisp, closure, old, &mask);
+      alive += pids[idx] > 0 ? 1 : 0;
+    }
+  }
+  /*
+   * Clean-up.
+   */
+  lisp_prefork_restore(old, &mask);
+  free(pids);
+  return lisp_make_true(lisp);
+}
+
+LISP_MODULE_SETUP(prefork, prefork, N, FN, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -102,10 +102,10 @@ process_r(const lisp_t lisp, const atom_t closure, const atom_t fds,
 
 static atom_t
 process(const lisp_t lisp, const atom_t closure, const atom_t fds,
-        const char* const cb_name, const fd_set* const set)
+        const atom_t fn, const char* const cb_name, const fd_set* const set)
 {
   MAKE_SYMBOL_STATIC(cb_s, cb_name);
-  atom_t cbk = lisp_make_symbol(lisp, cb_s);
+  atom_t cbk = IS_NULL(fn) ? lisp_make_nil(lisp) : lisp_make_symbol(lisp, cb_s);
   atom_t res = process_r(lisp, closure, fds, cbk, set);
   X(lisp, cbk);
   return res;
@@ -114,7 +114,7 @@ process(const lisp_t lisp, const atom_t closure, const atom_t fds,
 static atom_t USED
 lisp_function_select(const lisp_t lisp, const atom_t closure)
 {
-  LISP_ARGS(closure, C, FDS);
+  LISP_ARGS(closure, C, FDS, ON_READ, ON_ERROR);
   /*
    * Check that the fds argument is a list.
    */
@@ -139,8 +139,8 @@ lisp_function_select(const lisp_t lisp, const atom_t closure)
   /*
    * Process the events.
    */
-  atom_t rres = process(lisp, C, FDS, "ON_READ", &rset);
-  atom_t eres = process(lisp, C, FDS, "ON_ERROR", &eset);
+  atom_t rres = process(lisp, closure, FDS, ON_READ, "ON_READ", &rset);
+  atom_t eres = process(lisp, closure, FDS, ON_ERROR, "ON_ERROR", &eset);
   /*
    * Build the result.
    */
@@ -0,0 +1,174 @@
+#include "unix.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#endif
+
+/*
+ * Largest transfer of a single call.
+ */
+
+#define SENDFILE_CHUNK_LEN 0x7ffff000
+
+/*
+ * Send a chunk of at most LEN bytes. Where sendfile(2) is not available, the
+ * chunk is copied through a bounce buffer.
+ */
+
+static ssize_t
+lisp_sendfile_chunk(UNUSED const lisp_t lisp, const int out, const int in,
+                    off_t* const off, const size_t len)
+{
+#if defined(__linux__)
+  return sendfile(out, in, off, len);
+#else
+  char buf[65536];
+  const size_t cnt = len < sizeof(buf) ? len : sizeof(buf);
+  const ssize_t ret =
+    off == NULL ? read(in, buf, cnt) : pread(in, buf, cnt, *off);
+  if (ret <= 0) {
+    return ret;
+  }
+  ssize_t done = 0;
+  while (done < ret) {
+    const ssize_t w = write(out, buf + done, ret - done);
+    if (w < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if ((errno == EAGAIN || errno == EWOULDBLOCK) &&
+          lisp_wait(lisp, out, POLLOUT)) {
+        continue;
+      }
+      return -1;
+    }
+    done += w;
+  }
+  if (off != NULL) {
+    *off += ret;
+  }
+  return ret;
+#endif
+}
+
+/*
+ * Open the file at PATH, relative to the directory of the current input
+ * channel.
+ */
+
+static int
+lisp_sendfile_open(const lisp_t lisp, const atom_t PATH)
+{
+  char file_buf[PATH_MAX];
+  char path_buf[PATH_MAX];
+  if (lisp_len(PATH) >= PATH_MAX) {
+    return -1;
+  }
+  lisp_make_cstring(PATH, file_buf, PATH_MAX, 0);
+  const char* const dir =
+    IO_CONTEXT_EMPTY(lisp->ichan) ? "." : IO_CONTEXT(lisp->ichan)->pwd;
+  const char* path = lisp_get_fullpath(lisp, dir, file_buf, path_buf);
+  if (path == NULL) {
+    ERROR("Cannot get the full path for %s", file_buf);
+    return -1;
+  }
+  const int fd = open(path, O_RDONLY);
+  if (fd < 0) {
+    ERROR("Cannot open file %s", path);
+  }
+  return fd;
+}
+
+static ssize_t
+lisp_sendfile(const lisp_t lisp, const int out, const int in, off_t* const off,
+              size_t len)
+{
+  ssize_t total = 0;
+  while (len > 0) {
+    const size_t cnt = len < SENDFILE_CHUNK_LEN ? len : SENDFILE_CHUNK_LEN;
+    const ssize_t ret = lisp_sendfile_chunk(lisp, out, in, off, cnt);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if ((errno == EAGAIN || errno == EWOULDBLOCK) &&
+          lisp_wait(lisp, out, POLLOUT)) {
+        continue;
+      }
+      return -1;
+    }
+    /*
+     * Stop at the end of the file.
+     */
+    if (ret == 0) {
+      break;
+    }
+    total += ret;
+    len -= ret;
+  }
+  return total;
+}
+
+static atom_t USED
+lisp_function_sendfile(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, OUT, IN, OFF, LEN);
+  /*
+   * Check the arguments.
+   */
+  if (!IS_NUMB(OUT) || OUT->number < 0 ||
+      !(IS_NULL(OFF) || (IS_NUMB(OFF) && OFF->number >= 0)) ||
+      !(IS_NULL(LEN) || (IS_NUMB(LEN) && LEN->number >= 0))) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Get the input descriptor. Files opened here are read from their start.
+   */
+  int fd;
+  bool owned = false;
+  if (IS_NUMB(IN) && IN->number >= 0) {
+    fd = (int)IN->number;
+  } else if (lisp_is_string(IN)) {
+    fd = lisp_sendfile_open(lisp, IN);
+    if (fd < 0) {
+      return lisp_make_nil(lisp);
+    }
+    owned = true;
+  } else {
+    return lisp_make_nil(lisp);
+  }
+  off_t pos = IS_NUMB(OFF) ? OFF->number : 0;
+  off_t* const off = IS_NUMB(OFF) || owned ? &pos : NULL;
+  /*
+   * Send up to the end of regular files by default.
+   */
+  size_t len = IS_NUMB(LEN) ? (size_t)LEN->number : SIZE_MAX;
+  struct stat st;
+  if (IS_NULL(LEN) && fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+    const off_t cur = off != NULL ? pos : lseek(fd, 0, SEEK_CUR);
+    len = cur >= 0 && cur < st.st_size ? st.st_size - cur : 0;
+  }
+  /*
+   * Flush the printed output and send the file.
+   */
+  lisp_flush(lisp);
+  const ssize_t ret = lisp_sendfile(lisp, (int)OUT->number, fd, off, len);
+  if (owned) {
+    close(fd);
+  }
+  return ret < 0 ? lisp_make_nil(lisp) : lisp_make_number(lisp, ret);
+}
+
+LISP_MODULE_SETUP(sendfile, sendfile, OUT, IN, OFF, LEN, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
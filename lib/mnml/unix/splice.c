@@ -0,0 +1,86 @@
+#include "unix.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+
+/*
+ * Largest transfer of a single call.
+ */
+
+#define SPLICE_CHUNK_LEN 0x7ffff000
+
+static ssize_t
+lisp_splice(const lisp_t lisp, const int in, const int out, loff_t* const off,
+            size_t len)
+{
+  ssize_t total = 0;
+  while (len > 0) {
+    const size_t cnt = len < SPLICE_CHUNK_LEN ? len : SPLICE_CHUNK_LEN;
+    const ssize_t ret =
+      splice(in, off, out, NULL, cnt, SPLICE_F_MOVE | SPLICE_F_MORE);
+    if (ret < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      /*
+       * Wait for the non-blocking ends to be ready.
+       */
+      if ((errno == EAGAIN || errno == EWOULDBLOCK) &&
+          lisp_wait(lisp, out, POLLOUT) && lisp_wait(lisp, in, POLLIN)) {
+        continue;
+      }
+      return -1;
+    }
+    /*
+     * Stop at the end of the input.
+     */
+    if (ret == 0) {
+      break;
+    }
+    total += ret;
+    len -= ret;
+  }
+  return total;
+}
+
+#endif
+
+static atom_t USED
+lisp_function_splice(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, IN, OUT, OFF, LEN);
+#if defined(__linux__)
+  /*
+   * Check the arguments.
+   */
+  if (!IS_NUMB(IN) || IN->number < 0 || !IS_NUMB(OUT) || OUT->number < 0 ||
+      !(IS_NULL(OFF) || (IS_NUMB(OFF) && OFF->number >= 0)) ||
+      !(IS_NULL(LEN) || (IS_NUMB(LEN) && LEN->number >= 0))) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Move the data, up to the end of the input by default.
+   */
+  loff_t pos = IS_NUMB(OFF) ? OFF->number : 0;
+  const size_t len = IS_NUMB(LEN) ? (size_t)LEN->number : SIZE_MAX;
+  lisp_flush(lisp);
+  const ssize_t ret = lisp_splice(lisp, (int)IN->number, (int)OUT->number,
+                                  IS_NUMB(OFF) ? &pos : NULL, len);
+  return ret < 0 ? lisp_make_nil(lisp) : lisp_make_number(lisp, ret);
+#else
+  TRACE("splice() is not supported");
+  return lisp_make_nil(lisp);
+#endif
+}
+
+LISP_MODULE_SETUP(splice, splice, IN, OUT, OFF, LEN, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
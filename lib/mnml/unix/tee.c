@@ -0,0 +1,52 @@
+#include "unix.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+static atom_t USED
+lisp_function_tee(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, IN, OUT, LEN);
+#if defined(__linux__)
+  /*
+   * Check the arguments.
+   */
+  if (!IS_NUMB(IN) || IN->number < 0 || !IS_NUMB(OUT) || OUT->number < 0 ||
+      !IS_NUMB(LEN) || LEN->number < 0) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Duplicate the data once. The input is not consumed, so the call is not
+   * repeated.
+   */
+  const int in = (int)IN->number, out = (int)OUT->number;
+  ssize_t ret;
+  for (;;) {
+    ret = tee(in, out, LEN->number, 0);
+    if (ret >= 0) {
+      break;
+    }
+    if (errno == EINTR) {
+      continue;
+    }
+    if ((errno == EAGAIN || errno == EWOULDBLOCK) &&
+        lisp_wait(lisp, out, POLLOUT) && lisp_wait(lisp, in, POLLIN)) {
+      continue;
+    }
+    break;
+  }
+  return ret < 0 ? lisp_make_nil(lisp) : lisp_make_number(lisp, ret);
+#else
+  TRACE("tee() is not supported");
+  return lisp_make_nil(lisp);
+#endif
+}
+
+LISP_MODULE_SETUP(tee, tee, IN, OUT, LEN, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,35 @@
+#include "unix.h"
+#include <mnml/lisp.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <arpa/inet.h>
+#include <string.h>
+
+atom_t
+lisp_unix_address(const lisp_t lisp, const struct sockaddr_in* const sa)
+{
+  /*
+   * Make sure the protocol is right.
+   */
+  if (sa->sin_family != AF_INET) {
+    TRACE("Unsupported protocol: %d", sa->sin_family);
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Grab the host.
+   */
+  char buffer[INET_ADDRSTRLEN + 1] = { 0 };
+  inet_ntop(AF_INET, &(sa->sin_addr), buffer, INET_ADDRSTRLEN);
+  atom_t host = lisp_make_string(lisp, buffer, strlen(buffer));
+  /*
+   * Grab the port.
+   */
+  uint16_t pval = ntohs(sa->sin_port);
+  atom_t port = lisp_make_number(lisp, pval);
+  /*
+   * Construct and return the result.
+   */
+  return lisp_cons(lisp, host, port);
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
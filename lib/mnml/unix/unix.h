@@ -0,0 +1,33 @@
+#pragma once
+
+#include <mnml/lisp.h>
+#include <mnml/utils.h>
+#include <netinet/in.h>
+#include <stdbool.h>
+
+/*
+ * Make the (HOST . PORT) pair of a socket address. Return NIL if the address is
+ * not an IPv4 address.
+ */
+
+atom_t lisp_unix_address(const lisp_t lisp, const struct sockaddr_in* const sa);
+
+/*
+ * Split LST in at most COUNT slices processed by forked workers that call FN in
+ * CLOSURE. If ACC is NULL, the workers map FN over their slice. Otherwise they
+ * fold their slice with FN, starting from ACC. The results are pushed in order
+ * in BLD. Return false on error.
+ */
+
+bool lisp_unix_spread(const lisp_t lisp, const atom_t closure,
+                      const size_t count, const atom_t LST, const atom_t ACC,
+                      builder_t* const bld);
+
+/*
+ * Left-fold FN in CLOSURE over LST, starting from ACC.
+ */
+
+atom_t lisp_unix_fold(const lisp_t lisp, const atom_t closure, const atom_t ACC,
+                      const atom_t LST);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
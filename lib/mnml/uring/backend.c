@@ -0,0 +1,21 @@
+#include "uring.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_backend(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, R);
+  const uring_t ring = lisp_uring_get(lisp, R);
+  if (ring == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  const char* const name = lisp_uring_native(ring) ? "uring" : "epoll";
+  lisp_handle_put(&URING_RINGS, R);
+  return lisp_make_symbol_from_string(lisp, name, strlen(name));
+}
+
+LISP_MODULE_SETUP(backend, uring/backend, R, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,18 @@
+#include "uring.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_close(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, R, FD, TAG);
+  atom_t nil = lisp_make_nil(lisp);
+  atom_t res = lisp_uring_queue(lisp, U_CLOSE, R, FD, nil, TAG);
+  X(lisp, nil);
+  return res;
+}
+
+LISP_MODULE_SETUP(close, uring/close, R, FD, TAG, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
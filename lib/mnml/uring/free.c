@@ -0,0 +1,26 @@
+#include "uring.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_free(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, R);
+  const uring_t ring = lisp_uring_get(lisp, R);
+  if (ring == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * A ring is not freed while it is delivering completions. Otherwise, it is
+   * deleted when the handle is released.
+   */
+  const bool ok =
+    !lisp_uring_waiting(ring) && lisp_handle_close(&URING_RINGS, R);
+  lisp_handle_put(&URING_RINGS, R);
+  return ok ? lisp_make_true(lisp) : lisp_make_nil(lisp);
+}
+
+LISP_MODULE_SETUP(free, uring/free, R, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,38 @@
+#include <mnml/module.h>
+
+LISP_MODULE_DECL(accept);
+LISP_MODULE_DECL(backend);
+LISP_MODULE_DECL(close);
+LISP_MODULE_DECL(free);
+LISP_MODULE_DECL(new);
+LISP_MODULE_DECL(read);
+LISP_MODULE_DECL(recv);
+LISP_MODULE_DECL(send);
+LISP_MODULE_DECL(wait);
+LISP_MODULE_DECL(write);
+
+module_entry_t ENTRIES[] = { LISP_MODULE_REGISTER(accept),
+                             LISP_MODULE_REGISTER(backend),
+                             LISP_MODULE_REGISTER(close),
+                             LISP_MODULE_REGISTER(free),
+                             LISP_MODULE_REGISTER(new),
+                             LISP_MODULE_REGISTER(read),
+                             LISP_MODULE_REGISTER(recv),
+                             LISP_MODULE_REGISTER(send),
+                             LISP_MODULE_REGISTER(wait),
+                             LISP_MODULE_REGISTER(write),
+                             { NULL, NULL } };
+
+const char* USED
+lisp_module_name()
+{
+  return "uring";
+}
+
+const module_entry_t* USED
+lisp_module_entries()
+{
+  return ENTRIES;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
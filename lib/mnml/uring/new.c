@@ -0,0 +1,41 @@
+#include "uring.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_new(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, ENTRIES, BACKEND);
+  /*
+   * Check the arguments. A NIL backend picks io_uring if it is available.
+   */
+  if (!(IS_NULL(ENTRIES) || IS_NUMB(ENTRIES)) ||
+      !(IS_NULL(BACKEND) || IS_SYMB(BACKEND))) {
+    return lisp_make_nil(lisp);
+  }
+  const int64_t entries =
+    IS_NULL(ENTRIES) ? URING_DEFAULT_ENTRIES : ENTRIES->number;
+  const bool native = IS_NULL(BACKEND) || lisp_symbol_equal(BACKEND, "uring");
+  if (entries <= 0 || entries > UINT32_MAX ||
+      !(native || lisp_symbol_equal(BACKEND, "epoll"))) {
+    return lisp_make_nil(lisp);
+  }
+  /*
+   * Create the ring.
+   */
+  const uring_t ring = lisp_uring_new(lisp, (uint32_t)entries, native);
+  if (ring == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  const int64_t handle = lisp_handle_new(&URING_RINGS, ring);
+  if (handle < 0) {
+    lisp_uring_delete(lisp, ring);
+    return lisp_make_nil(lisp);
+  }
+  return lisp_make_number(lisp, handle);
+}
+
+LISP_MODULE_SETUP(new, uring/new, ENTRIES, BACKEND, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
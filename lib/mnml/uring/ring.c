@@ -0,0 +1,895 @@
+#include "uring.h"
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/slab.h>
+#include <mnml/store.h>
+#include <mnml/utils.h>
+#include <linux/io_uring.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#define URING_MAX_ENTRIES 32768
+#define URING_BATCH_LEN 256
+#define URING_NONE UINT32_MAX
+
+/*
+ * User data of the internal timeout and cancel requests. Operations use the
+ * index of their slot.
+ */
+
+#define URING_INTERNAL_DATA UINT64_MAX
+
+/*
+ * Operation slots. Slots are PENDING while the operation is in flight and DONE
+ * until its completion is delivered. With the epoll backend, the pending
+ * operations of a descriptor are linked from FNEXT and FPREV.
+ */
+
+typedef enum uring_state
+{
+  S_FREE,
+  S_PENDING,
+  S_DONE,
+} uring_state_t;
+
+typedef struct uring_op
+{
+  uring_state_t state;
+  uring_kind_t kind;
+  int fd;
+  uint32_t next;
+  uint32_t fnext;
+  uint32_t fprev;
+  atom_t buf;
+  atom_t tag;
+  store_t store;
+  size_t mark;
+  char* data;
+  size_t len;
+  int64_t res;
+} uring_op_t;
+
+struct uring
+{
+  lisp_t lisp;
+  bool native;
+  bool waiting;
+  int fd;
+  uint32_t cap;
+  uint32_t free;
+  uint32_t pending;
+  uring_op_t* ops;
+  /*
+   * Queue of completed operations.
+   */
+  uint32_t* done;
+  uint32_t dhead;
+  uint32_t dcount;
+  /*
+   * Pending operations indexed by descriptor, with the epoll backend.
+   */
+  uint32_t* byfd;
+  size_t nbyfd;
+  /*
+   * io_uring mappings.
+   */
+  void* sq_ptr;
+  size_t sq_len;
+  void* cq_ptr;
+  size_t cq_len;
+  struct io_uring_sqe* sqes;
+  size_t sqes_len;
+  uint32_t* sq_head;
+  uint32_t* sq_tail;
+  uint32_t* sq_mask;
+  uint32_t* sq_array;
+  uint32_t sq_entries;
+  uint32_t* cq_head;
+  uint32_t* cq_tail;
+  uint32_t* cq_mask;
+  struct io_uring_cqe* cqes;
+  uint32_t queued;
+  struct __kernel_timespec ts;
+};
+
+/*
+ * Descriptor index.
+ */
+
+static bool
+lisp_uring_index(const uring_t ring, const int fd)
+{
+  if ((size_t)fd < ring->nbyfd) {
+    return true;
+  }
+  /*
+   * Grow the index to cover FD.
+   */
+  size_t len = ring->nbyfd == 0 ? 64 : ring->nbyfd;
+  while (len <= (size_t)fd) {
+    len <<= 1;
+  }
+  uint32_t* byfd = (uint32_t*)realloc(ring->byfd, len * sizeof(uint32_t));
+  if (byfd == NULL) {
+    return false;
+  }
+  for (size_t i = ring->nbyfd; i < len; i += 1) {
+    byfd[i] = URING_NONE;
+  }
+  ring->byfd = byfd;
+  ring->nbyfd = len;
+  return true;
+}
+
+static void
+lisp_uring_link(const uring_t ring, const uint32_t idx)
+{
+  uring_op_t* const op = &ring->ops[idx];
+  /*
+   * Link the operation at the head of the list of its descriptor.
+   */
+  op->fprev = URING_NONE;
+  op->fnext = ring->byfd[op->fd];
+  if (op->fnext != URING_NONE) {
+    ring->ops[op->fnext].fprev = idx;
+  }
+  ring->byfd[op->fd] = idx;
+}
+
+static void
+lisp_uring_unlink(const uring_t ring, const uint32_t idx)
+{
+  uring_op_t* const op = &ring->ops[idx];
+  if (op->fprev != URING_NONE) {
+    ring->ops[op->fprev].fnext = op->fnext;
+  } else {
+    ring->byfd[op->fd] = op->fnext;
+  }
+  if (op->fnext != URING_NONE) {
+    ring->ops[op->fnext].fprev = op->fprev;
+  }
+}
+
+static uint32_t
+lisp_uring_first(const uring_t ring, const int fd)
+{
+  return (size_t)fd < ring->nbyfd ? ring->byfd[fd] : URING_NONE;
+}
+
+/*
+ * Completion helpers.
+ */
+
+static void
+lisp_uring_complete(const uring_t ring, const uint32_t idx, const int64_t res)
+{
+  if (idx >= ring->cap || ring->ops[idx].state != S_PENDING) {
+    return;
+  }
+  uring_op_t* const op = &ring->ops[idx];
+  if (!ring->native) {
+    lisp_uring_unlink(ring, idx);
+  }
+  op->state = S_DONE;
+  op->res = res;
+  ring->pending -= 1;
+  ring->done[(ring->dhead + ring->dcount) % ring->cap] = idx;
+  ring->dcount += 1;
+}
+
+static void
+lisp_uring_settle(const lisp_t lisp, uring_op_t* const op)
+{
+  const atom_t B = op->buf;
+  /*
+   * Update the buffer if it has not been modified while the operation was in
+   * flight: reads are appended and writes are drained.
+   */
+  if (IS_BUFF(B)) {
+    if (op->res > 0 && B->buffer.store == op->store) {
+      const size_t end = B->buffer.offset + B->buffer.length;
+      switch (op->kind) {
+        case U_READ:
+        case U_RECV:
+          if (end == op->mark) {
+            lisp_buffer_commit(B, op->res);
+          }
+          break;
+        case U_SEND:
+        case U_WRITE:
+          if (B->buffer.offset == op->mark) {
+            lisp_buffer_consume(B, op->res);
+          }
+          break;
+        default:
+          break;
+      }
+    }
+    lisp_store_release(op->store);
+  }
+  X(lisp, op->buf);
+  op->store = NULL;
+}
+
+static void
+lisp_uring_release(const uring_t ring, const uint32_t idx)
+{
+  uring_op_t* const op = &ring->ops[idx];
+  op->state = S_FREE;
+  op->next = ring->free;
+  ring->free = idx;
+}
+
+/*
+ * io_uring backend.
+ */
+
+static int
+lisp_uring_enter(const uring_t ring, const uint32_t min, const uint32_t flags)
+{
+  int ret;
+  do {
+    ret = (int)syscall(__NR_io_uring_enter, ring->fd, ring->queued, min, flags,
+                       NULL, 0);
+  } while (ret < 0 && errno == EINTR);
+  if (ret < 0) {
+    TRACE("io_uring_enter() failed: %s", strerror(errno));
+    return -1;
+  }
+  ring->queued -= (uint32_t)ret < ring->queued ? (uint32_t)ret : ring->queued;
+  return ret;
+}
+
+static struct io_uring_sqe*
+lisp_uring_sqe(const uring_t ring)
+{
+  const uint32_t tail = *ring->sq_tail;
+  /*
+   * Submit the queued entries if the submission queue is full.
+   */
+  if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >=
+      ring->sq_entries) {
+    lisp_uring_enter(ring, 0, 0);
+    if (tail - __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE) >=
+        ring->sq_entries) {
+      return NULL;
+    }
+  }
+  struct io_uring_sqe* sqe = &ring->sqes[tail & *ring->sq_mask];
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  return sqe;
+}
+
+static void
+lisp_uring_push(const uring_t ring, struct io_uring_sqe* const sqe)
+{
+  const uint32_t tail = *ring->sq_tail;
+  const uint32_t idx = tail & *ring->sq_mask;
+  ring->sq_array[idx] = (uint32_t)(sqe - ring->sqes);
+  __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  ring->queued += 1;
+}
+
+static void
+lisp_uring_prep(struct io_uring_sqe* const sqe, const uring_op_t* const op,
+                const uint32_t idx)
+{
+  sqe->fd = op->fd;
+  sqe->user_data = idx;
+  switch (op->kind) {
+    case U_ACCEPT:
+      sqe->opcode = IORING_OP_ACCEPT;
+      sqe->accept_flags = SOCK_CLOEXEC;
+      break;
+    case U_CLOSE:
+      sqe->opcode = IORING_OP_CLOSE;
+      break;
+    case U_READ:
+      sqe->opcode = IORING_OP_READ;
+      sqe->off = (uint64_t)-1;
+      break;
+    case U_RECV:
+      sqe->opcode = IORING_OP_RECV;
+      break;
+    case U_SEND:
+      sqe->opcode = IORING_OP_SEND;
+      sqe->msg_flags = MSG_NOSIGNAL;
+      break;
+    case U_WRITE:
+      sqe->opcode = IORING_OP_WRITE;
+      sqe->off = (uint64_t)-1;
+      break;
+  }
+  sqe->addr = (uint64_t)(uintptr_t)op->data;
+  sqe->len = (uint32_t)op->len;
+}
+
+static void
+lisp_uring_reap(const uring_t ring)
+{
+  uint32_t head = *ring->cq_head;
+  const uint32_t tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+  for (; head != tail; head += 1) {
+    const struct io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+    if (cqe->user_data != URING_INTERNAL_DATA) {
+      lisp_uring_complete(ring, (uint32_t)cqe->user_data, cqe->res);
+    }
+  }
+  __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+}
+
+static bool
+lisp_uring_setup(const uring_t ring, const uint32_t entries)
+{
+  struct io_uring_params p;
+  memset(&p, 0, sizeof(p));
+  const int fd = (int)syscall(__NR_io_uring_setup, entries, &p);
+  if (fd < 0) {
+    TRACE("io_uring_setup() failed: %s", strerror(errno));
+    return false;
+  }
+  /*
+   * Map the rings. Recent kernels map both rings at once.
+   */
+  const bool single = p.features & IORING_FEAT_SINGLE_MMAP;
+  ring->sq_len = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+  ring->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+  if (single && ring->cq_len > ring->sq_len) {
+    ring->sq_len = ring->cq_len;
+  }
+  ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ptr == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+  ring->cq_ptr = ring->sq_ptr;
+  if (!single) {
+    ring->cq_ptr = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ptr == MAP_FAILED) {
+      munmap(ring->sq_ptr, ring->sq_len);
+      close(fd);
+      return false;
+    }
+  }
+  ring->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+  ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (ring->sqes == MAP_FAILED) {
+    if (!single) {
+      munmap(ring->cq_ptr, ring->cq_len);
+    }
+    munmap(ring->sq_ptr, ring->sq_len);
+    close(fd);
+    return false;
+  }
+  /*
+   * Grab the ring pointers.
+   */
+  char* sq = (char*)ring->sq_ptr;
+  char* cq = (char*)ring->cq_ptr;
+  ring->sq_head = (uint32_t*)(sq + p.sq_off.head);
+  ring->sq_tail = (uint32_t*)(sq + p.sq_off.tail);
+  ring->sq_mask = (uint32_t*)(sq + p.sq_off.ring_mask);
+  ring->sq_array = (uint32_t*)(sq + p.sq_off.array);
+  ring->sq_entries = p.sq_entries;
+  ring->cq_head = (uint32_t*)(cq + p.cq_off.head);
+  ring->cq_tail = (uint32_t*)(cq + p.cq_off.tail);
+  ring->cq_mask = (uint32_t*)(cq + p.cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+  /*
+   * Keep one completion entry for the timeout of the wait.
+   */
+  ring->fd = fd;
+  ring->cap = p.cq_entries - 1;
+  ring->native = true;
+  return true;
+}
+
+static void
+lisp_uring_cancel(const uring_t ring)
+{
+  /*
+   * Cancel the pending operations.
+   */
+  for (uint32_t i = 0; i < ring->cap; i += 1) {
+    if (ring->ops[i].state == S_PENDING) {
+      struct io_uring_sqe* sqe = lisp_uring_sqe(ring);
+      if (sqe == NULL) {
+        break;
+      }
+      sqe->opcode = IORING_OP_ASYNC_CANCEL;
+      sqe->addr = i;
+      sqe->user_data = URING_INTERNAL_DATA;
+      lisp_uring_push(ring, sqe);
+    }
+  }
+  /*
+   * Wait until the kernel is done with their buffers.
+   */
+  while (ring->pending > 0) {
+    if (lisp_uring_enter(ring, 1, IORING_ENTER_GETEVENTS) < 0) {
+      break;
+    }
+    lisp_uring_reap(ring);
+  }
+}
+
+/*
+ * epoll backend.
+ */
+
+static void
+lisp_uring_interest(const uring_t ring, const int fd)
+{
+  uint32_t mask = 0;
+  /*
+   * Compute the interest of the pending operations of FD.
+   */
+  uint32_t i = lisp_uring_first(ring, fd);
+  for (; i != URING_NONE; i = ring->ops[i].fnext) {
+    const uring_op_t* const op = &ring->ops[i];
+    switch (op->kind) {
+      case U_ACCEPT:
+      case U_READ:
+      case U_RECV:
+        mask |= EPOLLIN;
+        break;
+      case U_SEND:
+      case U_WRITE:
+        mask |= EPOLLOUT;
+        break;
+      default:
+        break;
+    }
+  }
+  /*
+   * Update the interest set.
+   */
+  struct epoll_event evt = { .events = mask, .data.fd = fd };
+  if (mask == 0) {
+    epoll_ctl(ring->fd, EPOLL_CTL_DEL, fd, NULL);
+    return;
+  }
+  if (epoll_ctl(ring->fd, EPOLL_CTL_MOD, fd, &evt) == 0) {
+    return;
+  }
+  if (errno == ENOENT && epoll_ctl(ring->fd, EPOLL_CTL_ADD, fd, &evt) == 0) {
+    return;
+  }
+  /*
+   * Fail the operations of descriptors that cannot be polled.
+   */
+  const int64_t res = -errno;
+  while ((i = lisp_uring_first(ring, fd)) != URING_NONE) {
+    lisp_uring_complete(ring, i, res);
+  }
+}
+
+static bool
+lisp_uring_perform(const uring_t ring, const uint32_t idx)
+{
+  uring_op_t* const op = &ring->ops[idx];
+  ssize_t ret = 0;
+  switch (op->kind) {
+    case U_ACCEPT:
+      ret = accept4(op->fd, NULL, NULL, SOCK_CLOEXEC);
+      break;
+    case U_CLOSE:
+      /*
+       * Cancel the other operations of the descriptor.
+       */
+      for (uint32_t i = lisp_uring_first(ring, op->fd); i != URING_NONE;) {
+        const uint32_t next = ring->ops[i].fnext;
+        if (i != idx) {
+          lisp_uring_complete(ring, i, -ECANCELED);
+        }
+        i = next;
+      }
+      epoll_ctl(ring->fd, EPOLL_CTL_DEL, op->fd, NULL);
+      ret = close(op->fd);
+      break;
+    case U_READ:
+      ret = read(op->fd, op->data, op->len);
+      break;
+    case U_RECV:
+      ret = recv(op->fd, op->data, op->len, MSG_DONTWAIT);
+      break;
+    case U_SEND:
+      ret = send(op->fd, op->data, op->len, MSG_DONTWAIT | MSG_NOSIGNAL);
+      break;
+    case U_WRITE:
+      ret = write(op->fd, op->data, op->len);
+      break;
+  }
+  if (ret < 0 && op->kind != U_CLOSE &&
+      (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+    return false;
+  }
+  lisp_uring_complete(ring, idx, ret < 0 ? -errno : ret);
+  return true;
+}
+
+static void
+lisp_uring_ready(const uring_t ring, const struct epoll_event* const evt)
+{
+  const int fd = evt->data.fd;
+  const bool err = evt->events & (EPOLLERR | EPOLLHUP);
+  const bool in = err || (evt->events & EPOLLIN);
+  const bool out = err || (evt->events & EPOLLOUT);
+  /*
+   * Perform the operations of FD that can make progress, oldest first. The
+   * list is walked from its tail, as new operations are linked at its head.
+   */
+  uint32_t i = lisp_uring_first(ring, fd);
+  while (i != URING_NONE && ring->ops[i].fnext != URING_NONE) {
+    i = ring->ops[i].fnext;
+  }
+  while (i != URING_NONE) {
+    const uring_op_t* const op = &ring->ops[i];
+    const uint32_t prev = op->fprev;
+    const bool output = op->kind == U_SEND || op->kind == U_WRITE;
+    if ((output && out) || (!output && in)) {
+      lisp_uring_perform(ring, i);
+    }
+    i = prev;
+  }
+  lisp_uring_interest(ring, fd);
+}
+
+static bool
+lisp_uring_direct(const uring_op_t* const op)
+{
+  struct stat st;
+  if (op->kind == U_CLOSE) {
+    return true;
+  }
+  if (op->kind != U_READ && op->kind != U_WRITE) {
+    return false;
+  }
+  /*
+   * Regular files are always ready.
+   */
+  return fstat(op->fd, &st) == 0 && S_ISREG(st.st_mode);
+}
+
+/*
+ * Dispatch.
+ */
+
+static atom_t
+lisp_uring_call(const lisp_t lisp, const atom_t closure, const atom_t tag,
+                const int64_t res)
+{
+  MAKE_SYMBOL_STATIC(fn_s, "FN");
+  /*
+   * Build (FN 'TAG RES).
+   */
+  atom_t rsn = lisp_make_number(lisp, res);
+  atom_t cn0 = lisp_cons(lisp, rsn, lisp_make_nil(lisp));
+  atom_t qte = lisp_cons(lisp, lisp_make_quote(lisp), tag);
+  atom_t cn1 = lisp_cons(lisp, qte, cn0);
+  atom_t cn2 = lisp_cons(lisp, lisp_make_symbol(lisp, fn_s), cn1);
+  return lisp_eval(lisp, closure, cn2);
+}
+
+static int
+lisp_uring_dispatch(const lisp_t lisp, const uring_t ring, const atom_t closure,
+                    builder_t* const bld)
+{
+  int count = 0;
+  /*
+   * Callbacks may queue new operations, so the slot of each completion is
+   * released before its callback is called.
+   */
+  while (ring->dcount > 0) {
+    const uint32_t idx = ring->done[ring->dhead];
+    ring->dhead = (ring->dhead + 1) % ring->cap;
+    ring->dcount -= 1;
+    uring_op_t* const op = &ring->ops[idx];
+    lisp_uring_settle(lisp, op);
+    const atom_t tag = op->tag;
+    const int64_t res = op->res;
+    lisp_uring_release(ring, idx);
+    if (bld != NULL) {
+      atom_t rsn = lisp_make_number(lisp, res);
+      lisp_builder_push(lisp, bld, lisp_cons(lisp, tag, rsn));
+    } else {
+      atom_t ret = lisp_uring_call(lisp, closure, tag, res);
+      X(lisp, ret);
+    }
+    count += 1;
+  }
+  return count;
+}
+
+/*
+ * Ring API.
+ */
+
+static void
+lisp_uring_release_ring(void* const ptr)
+{
+  const uring_t ring = (uring_t)ptr;
+  lisp_uring_delete(ring->lisp, ring);
+}
+
+handle_table_t URING_RINGS = HANDLE_TABLE_INIT(lisp_uring_release_ring);
+
+static void DESTRUCTOR
+lisp_uring_fini()
+{
+  lisp_handle_fini(&URING_RINGS);
+}
+
+uring_t
+lisp_uring_new(const lisp_t lisp, const uint32_t entries, const bool native)
+{
+  if (entries == 0 || entries > URING_MAX_ENTRIES) {
+    return NULL;
+  }
+  uring_t ring = (uring_t)calloc(1, sizeof(struct uring));
+  if (ring == NULL) {
+    return NULL;
+  }
+  ring->lisp = lisp;
+  /*
+   * Set up io_uring and fall back on epoll if that fails.
+   */
+  if (!native || !lisp_uring_setup(ring, entries)) {
+    ring->fd = epoll_create1(EPOLL_CLOEXEC);
+    if (ring->fd < 0) {
+      TRACE("epoll_create1() failed: %s", strerror(errno));
+      free(ring);
+      return NULL;
+    }
+    ring->cap = (entries << 1) - 1;
+  }
+  /*
+   * Allocate the operation slots.
+   */
+  ring->ops = (uring_op_t*)calloc(ring->cap, sizeof(uring_op_t));
+  ring->done = (uint32_t*)calloc(ring->cap, sizeof(uint32_t));
+  if (ring->ops == NULL || ring->done == NULL) {
+    free(ring->ops);
+    ring->ops = NULL;
+    lisp_uring_delete(NULL, ring);
+    return NULL;
+  }
+  for (uint32_t i = 0; i < ring->cap; i += 1) {
+    ring->ops[i].next = i + 1 < ring->cap ? i + 1 : URING_NONE;
+  }
+  ring->free = 0;
+  return ring;
+}
+
+bool
+lisp_uring_delete(const lisp_t lisp, const uring_t ring)
+{
+  if (ring->waiting) {
+    return false;
+  }
+  /*
+   * Release the operations.
+   */
+  if (ring->ops != NULL) {
+    if (ring->native) {
+      lisp_uring_cancel(ring);
+    }
+    for (uint32_t i = 0; i < ring->cap; i += 1) {
+      uring_op_t* const op = &ring->ops[i];
+      if (op->state != S_FREE) {
+        lisp_uring_settle(lisp, op);
+        X(lisp, op->tag);
+      }
+    }
+  }
+  /*
+   * Release the backend.
+   */
+  if (ring->native) {
+    munmap(ring->sqes, ring->sqes_len);
+    if (ring->cq_ptr != ring->sq_ptr) {
+      munmap(ring->cq_ptr, ring->cq_len);
+    }
+    munmap(ring->sq_ptr, ring->sq_len);
+  }
+  close(ring->fd);
+  free(ring->ops);
+  free(ring->done);
+  free(ring->byfd);
+  free(ring);
+  return true;
+}
+
+uring_t
+lisp_uring_get(const lisp_t lisp, const atom_t R)
+{
+  const uring_t ring = lisp_handle_get(&URING_RINGS, R);
+  if (ring != NULL && ring->lisp != lisp) {
+    lisp_handle_put(&URING_RINGS, R);
+    return NULL;
+  }
+  return ring;
+}
+
+bool
+lisp_uring_native(const uring_t ring)
+{
+  return ring->native;
+}
+
+bool
+lisp_uring_waiting(const uring_t ring)
+{
+  return ring->waiting;
+}
+
+bool
+lisp_uring_submit(const uring_t ring, const uring_kind_t kind, const int fd,
+                  const atom_t BUF, const atom_t TAG)
+{
+  uring_op_t op = { .state = S_PENDING, .kind = kind, .fd = fd };
+  if (ring->free == URING_NONE) {
+    TRACE("Ring %d is full", ring->fd);
+    return false;
+  }
+  /*
+   * Grab the area of the buffer. Reads use the room at the end of the buffer.
+   */
+  switch (kind) {
+    case U_READ:
+    case U_RECV:
+      op.data = lisp_buffer_reserve(BUF, BUFFER_DEFAULT_SIZE);
+      if (op.data == NULL) {
+        return false;
+      }
+      op.store = BUF->buffer.store;
+      op.len = op.store->size - (op.data - op.store->data);
+      op.mark = BUF->buffer.offset + BUF->buffer.length;
+      break;
+    case U_SEND:
+    case U_WRITE:
+      op.data = BUFFER_DATA(BUF);
+      op.len = BUFFER_LEN(BUF);
+      op.store = BUF->buffer.store;
+      op.mark = BUF->buffer.offset;
+      break;
+    default:
+      break;
+  }
+  /*
+   * Grab a submission entry, or make room for FD in the descriptor index.
+   */
+  struct io_uring_sqe* sqe = NULL;
+  if (ring->native) {
+    sqe = lisp_uring_sqe(ring);
+    if (sqe == NULL) {
+      return false;
+    }
+  } else if (!lisp_uring_index(ring, fd)) {
+    return false;
+  }
+  /*
+   * Grab a slot. The buffer and its store are held while in flight.
+   */
+  const uint32_t idx = ring->free;
+  ring->free = ring->ops[idx].next;
+  op.buf = UP(BUF);
+  op.tag = UP(TAG);
+  if (op.store != NULL) {
+    op.store->refs += 1;
+  }
+  ring->ops[idx] = op;
+  ring->pending += 1;
+  /*
+   * Submit the operation.
+   */
+  if (ring->native) {
+    lisp_uring_prep(sqe, &ring->ops[idx], idx);
+    lisp_uring_push(ring, sqe);
+    return true;
+  }
+  lisp_uring_link(ring, idx);
+  if (!lisp_uring_direct(&ring->ops[idx]) || !lisp_uring_perform(ring, idx)) {
+    lisp_uring_interest(ring, fd);
+  }
+  return true;
+}
+
+int
+lisp_uring_wait(const lisp_t lisp, const uring_t ring, const int timeout,
+                const atom_t closure, builder_t* const bld)
+{
+  if (ring->waiting) {
+    return -1;
+  }
+  /*
+   * Completions that are already there are delivered without waiting.
+   */
+  if (ring->native) {
+    lisp_uring_reap(ring);
+    if (ring->dcount > 0 || (ring->pending == 0 && timeout < 0)) {
+      if (ring->queued > 0 && lisp_uring_enter(ring, 0, 0) < 0) {
+        return -1;
+      }
+    } else {
+      /*
+       * The timeout expires on its own or after the next completion.
+       */
+      if (timeout >= 0) {
+        struct io_uring_sqe* sqe = lisp_uring_sqe(ring);
+        if (sqe == NULL) {
+          return -1;
+        }
+        ring->ts.tv_sec = timeout / 1000;
+        ring->ts.tv_nsec = (timeout % 1000) * 1000000LL;
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->addr = (uint64_t)(uintptr_t)&ring->ts;
+        sqe->len = 1;
+        sqe->off = 1;
+        sqe->user_data = URING_INTERNAL_DATA;
+        lisp_uring_push(ring, sqe);
+      }
+      if (lisp_uring_enter(ring, 1, IORING_ENTER_GETEVENTS) < 0) {
+        return -1;
+      }
+      lisp_uring_reap(ring);
+    }
+  } else if (ring->dcount == 0 && (ring->pending > 0 || timeout >= 0)) {
+    struct epoll_event evts[URING_BATCH_LEN];
+    int res;
+    do {
+      res = epoll_wait(ring->fd, evts, URING_BATCH_LEN, timeout);
+    } while (res < 0 && errno == EINTR);
+    if (res < 0) {
+      TRACE("epoll_wait() failed: %s", strerror(errno));
+      return -1;
+    }
+    for (int i = 0; i < res; i += 1) {
+      lisp_uring_ready(ring, &evts[i]);
+    }
+  }
+  /*
+   * Deliver the completions.
+   */
+  ring->waiting = true;
+  const int count = lisp_uring_dispatch(lisp, ring, closure, bld);
+  ring->waiting = false;
+  return count;
+}
+
+/*
+ * Argument checking.
+ */
+
+atom_t
+lisp_uring_queue(const lisp_t lisp, const uring_kind_t kind, const atom_t R,
+                 const atom_t FD, const atom_t BUF, const atom_t TAG)
+{
+  if (!IS_NUMB(FD) || FD->number < 0 || FD->number > INT_MAX) {
+    return lisp_make_nil(lisp);
+  }
+  if (kind != U_ACCEPT && kind != U_CLOSE && !IS_BUFF(BUF)) {
+    return lisp_make_nil(lisp);
+  }
+  const uring_t ring = lisp_uring_get(lisp, R);
+  if (ring == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  const int fd = (int)FD->number;
+  const bool ok = lisp_uring_submit(ring, kind, fd, BUF, TAG);
+  lisp_handle_put(&URING_RINGS, R);
+  return ok ? lisp_make_true(lisp) : lisp_make_nil(lisp);
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,15 @@
+#include "uring.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+
+static atom_t USED
+lisp_function_send(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, R, FD, B, TAG);
+  return lisp_uring_queue(lisp, U_SEND, R, FD, B, TAG);
+}
+
+LISP_MODULE_SETUP(send, uring/send, R, FD, B, TAG, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <mnml/handle.h>
+#include <mnml/lisp.h>
+#include <mnml/utils.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Default number of submission entries of a ring.
+ */
+
+#define URING_DEFAULT_ENTRIES 256
+
+/*
+ * Operation kinds.
+ */
+
+typedef enum uring_kind
+{
+  U_ACCEPT,
+  U_CLOSE,
+  U_READ,
+  U_RECV,
+  U_SEND,
+  U_WRITE,
+} uring_kind_t;
+
+/*
+ * Rings are either backed by io_uring or, when it is not available, by epoll.
+ * They belong to the context that creates them and are handed out as handles
+ * of URING_RINGS.
+ */
+
+typedef struct uring* uring_t;
+
+extern handle_table_t URING_RINGS;
+
+/*
+ * Create a ring with ENTRIES submission entries in context LISP. The epoll
+ * backend is used if NATIVE is false or if io_uring cannot be set up. Return
+ * NULL on error.
+ */
+
+uring_t lisp_uring_new(const lisp_t lisp, const uint32_t entries,
+                       const bool native);
+
+/*
+ * Delete a ring. Pending operations are cancelled. Return false if the ring is
+ * delivering completions.
+ */
+
+bool lisp_uring_delete(const lisp_t lisp, const uring_t ring);
+
+/*
+ * Get the ring for the handle R. Return NULL if R is not an open ring of LISP.
+ * The ring must be released with lisp_handle_put.
+ */
+
+uring_t lisp_uring_get(const lisp_t lisp, const atom_t R);
+
+/*
+ * Return true if the ring is backed by io_uring.
+ */
+
+bool lisp_uring_native(const uring_t ring);
+
+/*
+ * Return true if the ring is delivering completions.
+ */
+
+bool lisp_uring_waiting(const uring_t ring);
+
+/*
+ * Queue an operation of kind KIND on descriptor FD. BUF is the buffer read
+ * into or written from, if any. TAG is handed over to the completion callback.
+ * Neither BUF nor TAG is consumed. Return false on error.
+ */
+
+bool lisp_uring_submit(const uring_t ring, const uring_kind_t kind,
+                       const int fd, const atom_t BUF, const atom_t TAG);
+
+/*
+ * Submit the queued operations and wait at most TIMEOUT milliseconds for
+ * completions, or forever if TIMEOUT is negative. If BLD is NULL, the callback
+ * FN in CLOSURE is called with the tag and the result of each completion.
+ * Otherwise, the (TAG . RESULT) pairs are pushed in BLD. Return the number of
+ * completions, or -1 on error.
+ */
+
+int lisp_uring_wait(const lisp_t lisp, const uring_t ring, const int timeout,
+                    const atom_t closure, builder_t* const bld);
+
+/*
+ * Generic argument checking and submission for the operation natives.
+ */
+
+atom_t lisp_uring_queue(const lisp_t lisp, const uring_kind_t kind,
+                        const atom_t R, const atom_t FD, const atom_t BUF,
+                        const atom_t TAG);
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
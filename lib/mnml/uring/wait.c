@@ -0,0 +1,46 @@
+#include "uring.h"
+#include <mnml/lisp.h>
+#include <mnml/module.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+
+static atom_t USED
+lisp_function_wait(const lisp_t lisp, const atom_t closure)
+{
+  LISP_ARGS(closure, C, R, TIMEOUT, FN);
+  /*
+   * Check the arguments. A NIL timeout waits forever.
+   */
+  if (!(IS_NULL(TIMEOUT) || IS_NUMB(TIMEOUT))) {
+    return lisp_make_nil(lisp);
+  }
+  const uring_t ring = lisp_uring_get(lisp, R);
+  if (ring == NULL) {
+    return lisp_make_nil(lisp);
+  }
+  const int tmout = IS_NULL(TIMEOUT) ? -1 : (int)TIMEOUT->number;
+  /*
+   * Return the completions if there is no callback.
+   */
+  if (IS_NULL(FN)) {
+    builder_t bld;
+    lisp_builder_init(lisp, &bld);
+    const int res = lisp_uring_wait(lisp, ring, tmout, closure, &bld);
+    lisp_handle_put(&URING_RINGS, R);
+    if (res < 0) {
+      X(lisp, bld.head);
+      return lisp_make_nil(lisp);
+    }
+    return bld.head;
+  }
+  /*
+   * Otherwise call the callback for each completion and return their count.
+   */
+  const int res = lisp_uring_wait(lisp, ring, tmout, closure, NULL);
+  lisp_handle_put(&URING_RINGS, R);
+  return res < 0 ? lisp_make_nil(lisp) : lisp_make_number(lisp, res);
+}
+
+LISP_MODULE_SETUP(wait, uring/wait, R, TIMEOUT, FN, NIL)
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
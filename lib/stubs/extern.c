@@ -24,15 +24,15 @@ lisp_io_push(const lisp_t lisp)
 {
   char cwd_buf[PATH_MAX];
   const char* const cwd = getcwd(cwd_buf, PATH_MAX);
-  PUSH_IO_CONTEXT(lisp, lisp->ichan, stdin, cwd);
-  PUSH_IO_CONTEXT(lisp, lisp->ochan, stdout, cwd);
+  lisp_chan_push(lisp, &lisp->ichan, stdin, cwd);
+  lisp_chan_push(lisp, &lisp->ochan, stdout, cwd);
 }
 
 void
 lisp_io_pop(const lisp_t lisp)
 {
-  POP_IO_CONTEXT(lisp, lisp->ichan);
-  POP_IO_CONTEXT(lisp, lisp->ochan);
+  lisp_chan_pop(lisp, &lisp->ichan);
+  lisp_chan_pop(lisp, &lisp->ochan);
 }
 
 extern atom_t lisp_make_symbol_from_string(const lisp_t lisp,
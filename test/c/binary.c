@@ -0,0 +1,213 @@
+#include "primitives.h"
+#include <mnml/array.h>
+#include <mnml/binary.h>
+#include <mnml/buffer.h>
+#include <mnml/lisp.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Read a binary message from DATA.
+ */
+
+static atom_t
+lisp_test_read(const lisp_t lisp, const uint8_t* const data, const size_t len)
+{
+  FILE* handle = fmemopen((void*)data, len, "r");
+  if (handle == NULL) {
+    return NULL;
+  }
+  atom_t res = lisp_bin_read(lisp, handle);
+  fclose(handle);
+  return res;
+}
+
+/*
+ * Tests.
+ */
+
+bool
+string_length_test()
+{
+  slab_t slab = slab_new();
+  lisp_t lisp = lisp_new(slab);
+  /*
+   * A string of UINT64_MAX characters.
+   */
+  const uint8_t data[] = { BIN_MAGIC, B_STRING, 0xFF, 0xFF, 0xFF, 0xFF,
+                           0xFF,      0xFF,     0xFF, 0xFF, 0xFF, 0x01 };
+  ASSERT_TRUE(lisp_test_read(lisp, data, sizeof(data)) == NULL);
+  /*
+   * Clean-up.
+   */
+  lisp_delete(lisp);
+  ASSERT_EQUAL(slab->n_alloc, slab->n_free);
+  slab_delete(slab);
+  OK;
+}
+
+bool
+array_length_test()
+{
+  slab_t slab = slab_new();
+  lisp_t lisp = lisp_new(slab);
+  /*
+   * An i64 array and a buffer of UINT32_MAX elements with only 2 of them.
+   */
+  const uint8_t arry[] = { BIN_MAGIC, B_ARRAY, A_I64, 0xFF, 0xFF, 0xFF,
+                           0xFF,      0x0F,    0x02,  0x04 };
+  ASSERT_TRUE(lisp_test_read(lisp, arry, sizeof(arry)) == NULL);
+  const uint8_t buff[] = { BIN_MAGIC, B_BUFFER, 0xFF, 0xFF, 0xFF,
+                           0xFF,      0x0F,     'a',  'b' };
+  ASSERT_TRUE(lisp_test_read(lisp, buff, sizeof(buff)) == NULL);
+  /*
+   * The same values, complete.
+   */
+  const uint8_t full[] = { BIN_MAGIC, B_ARRAY, A_I32, 0x02, 0x02, 0x03 };
+  atom_t res = lisp_test_read(lisp, full, sizeof(full));
+  ASSERT_TRUE(res != NULL && IS_ARRY(res) && ARRAY_LEN(res) == 2);
+  ASSERT_EQUAL(lisp_array_get(res, 0), 1);
+  ASSERT_EQUAL(lisp_array_get(res, 1), -2);
+  X(lisp, res);
+  const uint8_t data[] = { BIN_MAGIC, B_BUFFER, 0x02, 'a', 'b' };
+  res = lisp_test_read(lisp, data, sizeof(data));
+  ASSERT_TRUE(res != NULL && IS_BUFF(res) && BUFFER_LEN(res) == 2);
+  ASSERT_TRUE(memcmp(BUFFER_DATA(res), "ab", 2) == 0);
+  X(lisp, res);
+  /*
+   * Clean-up.
+   */
+  lisp_delete(lisp);
+  ASSERT_EQUAL(slab->n_alloc, slab->n_free);
+  slab_delete(slab);
+  OK;
+}
+
+/*
+ * Write CELL with a module table that covers the test binary, and read it back
+ * without a table.
+ */
+
+static atom_t
+lisp_test_native(const lisp_t lisp, const atom_t cell)
+{
+  Dl_info info;
+  if (dladdr((void*)lisp_test_native, &info) == 0) {
+    return NULL;
+  }
+  const uintptr_t base = (uintptr_t)info.dli_fbase;
+  const bin_modules_t mods = { .count = 1, .bases = &base };
+  char* data = NULL;
+  size_t len = 0;
+  FILE* handle = open_memstream(&data, &len);
+  if (handle == NULL) {
+    return NULL;
+  }
+  const bool res = lisp_bin_write_with(lisp, handle, cell, &mods);
+  fclose(handle);
+  atom_t R = res ? lisp_test_read(lisp, (uint8_t*)data, len) : NULL;
+  free(data);
+  return R;
+}
+
+bool
+native_shape_test()
+{
+  slab_t slab = slab_new();
+  lisp_t lisp = lisp_new(slab);
+  const int64_t addr = (int64_t)(uintptr_t)lisp_test_native;
+  /*
+   * A list of numbers that ends with an address is written as is.
+   */
+  atom_t lst = lisp_cons(lisp, lisp_make_number(lisp, 1),
+                         lisp_cons(lisp, lisp_make_number(lisp, 2),
+                                   lisp_make_number(lisp, addr)));
+  atom_t res = lisp_test_native(lisp, lst);
+  ASSERT_TRUE(res != NULL && lisp_equ(res, lst));
+  X(lisp, lst, res);
+  /*
+   * A native function is written as a relocatable reference, which cannot be
+   * read back without a table.
+   */
+  atom_t fun = lisp_cons(lisp, lisp_make_nil(lisp),
+                         lisp_cons(lisp, lisp_make_nil(lisp),
+                                   lisp_make_number(lisp, addr)));
+  ASSERT_TRUE(lisp_test_native(lisp, fun) == NULL);
+  X(lisp, fun);
+  /*
+   * Clean-up.
+   */
+  lisp_delete(lisp);
+  ASSERT_EQUAL(slab->n_alloc, slab->n_free);
+  slab_delete(slab);
+  OK;
+}
+
+bool
+record_length_test()
+{
+  slab_t slab = slab_new();
+  lisp_t lisp = lisp_new(slab);
+  /*
+   * A record of UINT64_MAX fields.
+   */
+  const uint8_t data[] = { BIN_MAGIC, B_RECORD, B_NIL, 0xFF, 0xFF, 0xFF, 0xFF,
+                           0xFF,      0xFF,     0xFF,  0xFF, 0xFF, 0x01 };
+  ASSERT_TRUE(lisp_test_read(lisp, data, sizeof(data)) == NULL);
+  /*
+   * Clean-up.
+   */
+  lisp_delete(lisp);
+  ASSERT_EQUAL(slab->n_alloc, slab->n_free);
+  slab_delete(slab);
+  OK;
+}
+
+bool
+record_truncated_test()
+{
+  slab_t slab = slab_new();
+  lisp_t lisp = lisp_new(slab);
+  /*
+   * A record of 3 fields with only 2 of them.
+   */
+  const uint8_t data[] = { BIN_MAGIC, B_RECORD, B_NIL, 0x03,
+                           B_NUMBER,  0x02,     B_TRUE };
+  ASSERT_TRUE(lisp_test_read(lisp, data, sizeof(data)) == NULL);
+  /*
+   * The same record, complete.
+   */
+  const uint8_t full[] = { BIN_MAGIC, B_RECORD, B_NIL, 0x03,
+                           B_NUMBER,  0x02,     B_TRUE, B_NIL };
+  atom_t res = lisp_test_read(lisp, full, sizeof(full));
+  ASSERT_TRUE(res != NULL);
+  X(lisp, res);
+  /*
+   * Clean-up.
+   */
+  lisp_delete(lisp);
+  ASSERT_EQUAL(slab->n_alloc, slab->n_free);
+  slab_delete(slab);
+  OK;
+}
+
+/*
+ * Main.
+ */
+
+int
+main(UNUSED const int argc, UNUSED char** const argv)
+{
+  TEST(string_length_test);
+  TEST(array_length_test);
+  TEST(native_shape_test);
+  TEST(record_length_test);
+  TEST(record_truncated_test);
+  return 0;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
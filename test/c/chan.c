@@ -0,0 +1,82 @@
+#include "primitives.h"
+#include <mnml/lisp.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define DEPTH 20
+
+/*
+ * Tests.
+ */
+
+bool
+push_pop_test()
+{
+  slab_t slab = slab_new();
+  lisp_t lisp = lisp_new(slab);
+  char path[] = "/tmp/mnml_chan_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_TRUE(fd >= 0);
+  FILE* handle = fdopen(fd, "w+");
+  ASSERT_TRUE(handle != NULL);
+  /*
+   * Push contexts past the initial capacity of the stack.
+   */
+  char pwd[16];
+  for (size_t i = 0; i < DEPTH; i += 1) {
+    sprintf(pwd, "/dir%lu", i);
+    ASSERT_TRUE(lisp_chan_push(lisp, &lisp->ochan, handle, pwd));
+    ASSERT_TRUE(IS_NULL(IO_CONTEXT_VALUES(lisp->ochan)));
+  }
+  ASSERT_EQUAL(lisp->ochan.depth, DEPTH);
+  ASSERT_TRUE(strcmp(IO_CONTEXT(lisp->ochan)->pwd, "/dir19") == 0);
+  /*
+   * Write in the top context and pop it.
+   */
+  lisp_write(lisp, "abc", 3);
+  void* state = IO_CONTEXT(lisp->ochan)->state;
+  ASSERT_TRUE(state != NULL);
+  lisp_chan_pop(lisp, &lisp->ochan);
+  ASSERT_TRUE(strcmp(IO_CONTEXT(lisp->ochan)->pwd, "/dir18") == 0);
+  /*
+   * Pushing a context again reuses the state of the slot.
+   */
+  ASSERT_TRUE(lisp_chan_push(lisp, &lisp->ochan, handle, "/"));
+  lisp_write(lisp, "def", 3);
+  ASSERT_TRUE(IO_CONTEXT(lisp->ochan)->state == state);
+  /*
+   * Pop all the contexts and check the output.
+   */
+  while (!IO_CONTEXT_EMPTY(lisp->ochan)) {
+    lisp_chan_pop(lisp, &lisp->ochan);
+  }
+  char buffer[8] = { 0 };
+  rewind(handle);
+  ASSERT_EQUAL(fread(buffer, 1, sizeof(buffer), handle), 6);
+  ASSERT_TRUE(strcmp(buffer, "abcdef") == 0);
+  /*
+   * Clean-up.
+   */
+  fclose(handle);
+  unlink(path);
+  lisp_delete(lisp);
+  ASSERT_EQUAL(slab->n_alloc, slab->n_free);
+  slab_delete(slab);
+  OK;
+}
+
+/*
+ * Main.
+ */
+
+int
+main(UNUSED const int argc, UNUSED char** const argv)
+{
+  TEST(push_pop_test);
+  return 0;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
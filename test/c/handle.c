@@ -0,0 +1,113 @@
+#include "primitives.h"
+#include <mnml/handle.h>
+#include <mnml/lisp.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+
+/*
+ * Handle objects.
+ */
+
+static size_t deleted = 0;
+
+static void
+test_delete(UNUSED void* const ptr)
+{
+  deleted += 1;
+}
+
+static handle_table_t TABLE = HANDLE_TABLE_INIT(test_delete);
+
+/*
+ * Tests.
+ */
+
+bool
+handle_close_test()
+{
+  slab_t slab = slab_new();
+  lisp_t lisp = lisp_new(slab);
+  int value = 0;
+  deleted = 0;
+  /*
+   * Open a handle and look it up.
+   */
+  atom_t hnd = lisp_make_number(lisp, lisp_handle_new(&TABLE, &value));
+  ASSERT_TRUE(hnd->number > 0);
+  ASSERT_TRUE(lisp_handle_get(&TABLE, hnd) == &value);
+  /*
+   * Close it while it is in use.
+   */
+  ASSERT_TRUE(lisp_handle_close(&TABLE, hnd));
+  ASSERT_EQUAL(deleted, 0);
+  ASSERT_TRUE(lisp_handle_get(&TABLE, hnd) == NULL);
+  ASSERT_TRUE(!lisp_handle_close(&TABLE, hnd));
+  lisp_handle_put(&TABLE, hnd);
+  ASSERT_EQUAL(deleted, 1);
+  /*
+   * Clean-up.
+   */
+  X(lisp, hnd);
+  lisp_delete(lisp);
+  ASSERT_EQUAL(slab->n_alloc, slab->n_free);
+  slab_delete(slab);
+  OK;
+}
+
+bool
+handle_stale_test()
+{
+  slab_t slab = slab_new();
+  lisp_t lisp = lisp_new(slab);
+  int value = 0;
+  deleted = 0;
+  /*
+   * A closed handle does not give access to the object that reuses its slot.
+   */
+  atom_t hn0 = lisp_make_number(lisp, lisp_handle_new(&TABLE, &value));
+  ASSERT_TRUE(lisp_handle_close(&TABLE, hn0));
+  atom_t hn1 = lisp_make_number(lisp, lisp_handle_new(&TABLE, &value));
+  ASSERT_TRUE(hn0->number != hn1->number);
+  ASSERT_TRUE(lisp_handle_get(&TABLE, hn0) == NULL);
+  ASSERT_TRUE(!lisp_handle_close(&TABLE, hn0));
+  ASSERT_TRUE(lisp_handle_close(&TABLE, hn1));
+  ASSERT_EQUAL(deleted, 2);
+  /*
+   * Numbers that are not handles.
+   */
+  atom_t bad[] = {
+    lisp_make_number(lisp, 0),
+    lisp_make_number(lisp, -1),
+    lisp_make_number(lisp, 5),
+    lisp_make_number(lisp, INT64_MAX),
+    lisp_make_nil(lisp),
+  };
+  for (size_t i = 0; i < sizeof(bad) / sizeof(atom_t); i += 1) {
+    ASSERT_TRUE(lisp_handle_get(&TABLE, bad[i]) == NULL);
+    ASSERT_TRUE(!lisp_handle_close(&TABLE, bad[i]));
+    X(lisp, bad[i]);
+  }
+  /*
+   * Clean-up.
+   */
+  X(lisp, hn0, hn1);
+  lisp_delete(lisp);
+  ASSERT_EQUAL(slab->n_alloc, slab->n_free);
+  slab_delete(slab);
+  OK;
+}
+
+/*
+ * Main.
+ */
+
+int
+main(UNUSED const int argc, UNUSED char** const argv)
+{
+  TEST(handle_close_test);
+  TEST(handle_stale_test);
+  lisp_handle_fini(&TABLE);
+  return 0;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,147 @@
+#include "primitives.h"
+#include <mnml/debug.h>
+#include <mnml/image.h>
+#include <mnml/lexer.h>
+#include <mnml/slab.h>
+#include <mnml/tree.h>
+#include <mnml/utils.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define INPUT(__s) (char*)__s, strlen(__s)
+
+static lexer_t lexer;
+static atom_t result = NULL;
+
+static void
+lisp_consumer(UNUSED const lisp_t lisp, const atom_t cell)
+{
+  result = cell;
+}
+
+static void
+lisp_test_init(const lisp_t lisp)
+{
+  lisp->slab = slab_new();
+  /*
+   * Create the lisp->globals, the lisp->modules and the lexer.
+   */
+  lisp->globals = lisp_make_nil(lisp);
+  lisp->modules = lisp_make_nil(lisp);
+  lexer = lexer_create(lisp, lisp_consumer);
+  /*
+   * Setup the debug variables.
+   */
+#ifdef LISP_ENABLE_DEBUG
+  lisp_debug_parse_flags();
+#endif
+}
+
+static bool
+lisp_test_fini(const lisp_t lisp)
+{
+  X(lisp, lisp->globals, lisp->modules);
+  lexer_destroy(lexer);
+  TRACE("D %ld", lisp->slab->n_alloc - lisp->slab->n_free);
+  SLAB_COLLECT(lisp->slab);
+  bool v = lisp->slab->n_alloc == lisp->slab->n_free;
+  slab_delete(lisp->slab);
+  return v;
+}
+
+static void
+lisp_test_setq(const lisp_t lisp, const char* const input)
+{
+  lexer_parse(lexer, (char*)input, strlen(input), true);
+  lisp->globals = lisp_setq(lisp, lisp->globals, result);
+}
+
+static bool
+lisp_test_check(const lisp_t lisp, const char* const sym,
+                const char* const input)
+{
+  MAKE_SYMBOL_STATIC(key, sym);
+  atom_t val = lisp_tree_get(lisp, lisp->globals, key);
+  lexer_parse(lexer, (char*)input, strlen(input), true);
+  bool res = IS_PAIR(val) && lisp_equ(CDR(val), result);
+  X(lisp, val, result);
+  return res;
+}
+
+/*
+ * Image tests.
+ */
+
+static bool
+image_tests()
+{
+  struct lisp lisp;
+  char path[] = "/tmp/mnml_image_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_TRUE(fd >= 0);
+  close(fd);
+  /*
+   * TEST_00.
+   */
+  STEP("Dump the global bindings");
+  lisp_test_init(&lisp);
+  /*
+   */
+  lisp_test_setq(&lisp, "(A . 1)");
+  lisp_test_setq(&lisp, "(B 1 \"abc\" (c . d))");
+  lisp_test_setq(&lisp, "(F (x) NIL (+ x 1))");
+  lisp_test_setq(&lisp, "(ARGV \"a\" \"b\")");
+  ASSERT_TRUE(lisp_image_dump(&lisp, path));
+  /*
+   */
+  ASSERT_TRUE(lisp_test_fini(&lisp));
+  /*
+   * TEST_01.
+   */
+  STEP("Load the global bindings");
+  lisp_test_init(&lisp);
+  /*
+   */
+  ASSERT_TRUE(lisp_image_load(&lisp, path));
+  ASSERT_TRUE(lisp_test_check(&lisp, "A", "1"));
+  ASSERT_TRUE(lisp_test_check(&lisp, "B", "(1 \"abc\" (c . d))"));
+  ASSERT_TRUE(lisp_test_check(&lisp, "F", "((x) NIL (+ x 1))"));
+  MAKE_SYMBOL_STATIC(argv, "ARGV");
+  atom_t val = lisp_tree_get(&lisp, lisp.globals, argv);
+  ASSERT_TRUE(IS_NULL(val));
+  X(&lisp, val);
+  /*
+   */
+  ASSERT_TRUE(lisp_test_fini(&lisp));
+  /*
+   * TEST_02.
+   */
+  STEP("Reject an invalid image");
+  lisp_test_init(&lisp);
+  /*
+   */
+  FILE* handle = fopen(path, "wb");
+  ASSERT_TRUE(handle != NULL);
+  fputs("(A . 1)", handle);
+  fclose(handle);
+  ASSERT_TRUE(!lisp_image_load(&lisp, path));
+  ASSERT_TRUE(IS_NULL(lisp.globals));
+  /*
+   */
+  ASSERT_TRUE(lisp_test_fini(&lisp));
+  unlink(path);
+  OK;
+}
+
+/*
+ * Main.
+ */
+
+int
+main(UNUSED const int argc, UNUSED char** const argv)
+{
+  TEST(image_tests);
+  return 0;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et
@@ -0,0 +1,223 @@
+#include "primitives.h"
+#include <mnml/debug.h>
+#include <mnml/lexer.h>
+#include <mnml/slab.h>
+#include <mnml/utils.h>
+#include <stdlib.h>
+
+#define INPUT(__s) (char*)__s, strlen(__s)
+
+#define LIST_LENGTH 1000000
+
+static lexer_t lexer;
+static atom_t result = NULL;
+
+static void
+lisp_consumer(UNUSED const lisp_t lisp, const atom_t cell)
+{
+  result = cell;
+}
+
+static void
+lisp_test_init(const lisp_t lisp)
+{
+  lisp->slab = slab_new();
+  /*
+   * Create the lisp->globals and the lexer.
+   */
+  lisp->globals = lisp_make_nil(lisp);
+  lexer = lexer_create(lisp, lisp_consumer);
+  /*
+   * Setup the debug variables.
+   */
+#ifdef LISP_ENABLE_DEBUG
+  lisp_debug_parse_flags();
+#endif
+}
+
+static bool
+lisp_test_fini(const lisp_t lisp)
+{
+  X(lisp, lisp->globals);
+  lexer_destroy(lexer);
+  TRACE("D %ld", lisp->slab->n_alloc - lisp->slab->n_free);
+  SLAB_COLLECT(lisp->slab);
+  bool v = lisp->slab->n_alloc == lisp->slab->n_free;
+  slab_delete(lisp->slab);
+  return v;
+}
+
+/*
+ * List building.
+ */
+
+static bool
+builder_tests()
+{
+  struct lisp lisp;
+  atom_t tmp = NULL;
+  /*
+   * TEST_00.
+   */
+  STEP("Push elements");
+  lisp_test_init(&lisp);
+  /*
+   */
+  builder_t bld;
+  lisp_builder_init(&lisp, &bld);
+  ASSERT_TRUE(IS_NULL(bld.head));
+  for (int64_t i = 1; i <= 3; i += 1) {
+    lisp_builder_push(&lisp, &bld, lisp_make_number(&lisp, i));
+  }
+  lexer_parse(lexer, INPUT("(1 2 3)"), true);
+  ASSERT_TRUE(lisp_equ(bld.head, result));
+  X(&lisp, bld.head, result);
+  /*
+   */
+  ASSERT_TRUE(lisp_test_fini(&lisp));
+  /*
+   * TEST_01.
+   */
+  STEP("Concatenate lists");
+  lisp_test_init(&lisp);
+  /*
+   */
+  lisp_builder_init(&lisp, &bld);
+  lexer_parse(lexer, INPUT("(1 2)"), true);
+  lisp_builder_conc(&lisp, &bld, result);
+  lisp_builder_push(&lisp, &bld, lisp_make_number(&lisp, 3));
+  lexer_parse(lexer, INPUT("(4)"), true);
+  lisp_builder_conc(&lisp, &bld, result);
+  lexer_parse(lexer, INPUT("(1 2 3 4)"), true);
+  ASSERT_TRUE(lisp_equ(bld.head, result));
+  X(&lisp, bld.head, result);
+  /*
+   */
+  ASSERT_TRUE(lisp_test_fini(&lisp));
+  /*
+   * TEST_02.
+   */
+  STEP("Dotted tail");
+  lisp_test_init(&lisp);
+  /*
+   */
+  lisp_builder_init(&lisp, &bld);
+  lisp_builder_push(&lisp, &bld, lisp_make_number(&lisp, 1));
+  lisp_builder_conc(&lisp, &bld, lisp_make_number(&lisp, 2));
+  lexer_parse(lexer, INPUT("(1 . 2)"), true);
+  tmp = result;
+  ASSERT_TRUE(lisp_equ(bld.head, tmp));
+  lisp_builder_push(&lisp, &bld, lisp_make_number(&lisp, 3));
+  lexer_parse(lexer, INPUT("(1 3)"), true);
+  ASSERT_TRUE(lisp_equ(bld.head, result));
+  X(&lisp, bld.head, tmp, result);
+  /*
+   */
+  ASSERT_TRUE(lisp_test_fini(&lisp));
+  OK;
+}
+
+/*
+ * Long strings, comments and blanks.
+ */
+
+static const char* body = "0123456789abcdefghijklmnopqrstuvwxyz0123456789"
+                          "\\\"0123456789abcdefghijklmnopqrstuvwxyz";
+
+static const char* test20 = "(\"0123456789abcdefghijklmnopqrstuvwxyz0123456789"
+                            "\\\"0123456789abcdefghijklmnopqrstuvwxyz\""
+                            "     # A comment longer than a vector register.  \n"
+                            "\t\t\t\t                                          \n"
+                            " 2)";
+
+static bool
+scan_tests()
+{
+  struct lisp lisp;
+  const size_t len = strlen(test20);
+  char* buffer = (char*)malloc(len);
+  /*
+   * Split the input at every possible location.
+   */
+  for (size_t k = 0; k < len; k += 1) {
+    lisp_test_init(&lisp);
+    result = NULL;
+    /*
+     * Parse the first part.
+     */
+    memcpy(buffer, test20, k);
+    lexer_parse(lexer, buffer, k, false);
+    ASSERT_TRUE(result == NULL);
+    /*
+     * Parse the second part after the remainder of the first one.
+     */
+    const size_t rem = lexer->rem;
+    memcpy(buffer + rem, test20 + k, len - k);
+    lexer_parse(lexer, buffer, rem + len - k, true);
+    ASSERT_TRUE(result != NULL && lisp_len(result) == 2);
+    /*
+     * Check the string and the number.
+     */
+    atom_t str = lisp_make_string(&lisp, body, strlen(body));
+    ASSERT_TRUE(lisp_equ(CAR(result), str));
+    ASSERT_TRUE(IS_NUMB(CAR(CDR(result))) && CAR(CDR(result))->number == 2);
+    X(&lisp, str, result);
+    /*
+     */
+    ASSERT_TRUE(lisp_test_fini(&lisp));
+  }
+  free(buffer);
+  OK;
+}
+
+/*
+ * Large literal list.
+ */
+
+static bool
+large_list_tests()
+{
+  struct lisp lisp;
+  /*
+   * Build the input string.
+   */
+  size_t len = 0;
+  char* input = (char*)malloc(LIST_LENGTH * 8 + 2);
+  input[len++] = '(';
+  for (int i = 0; i < LIST_LENGTH; i += 1) {
+    len += sprintf(input + len, "%d ", i);
+  }
+  input[len - 1] = ')';
+  /*
+   * Parse it.
+   */
+  STEP("Parse a 1M-element list");
+  lisp_test_init(&lisp);
+  uint64_t ts = lisp_timestamp();
+  lexer_parse(lexer, input, len, true);
+  uint64_t te = lisp_timestamp();
+  printf("- parsed %d elements in %luus\n", LIST_LENGTH,
+         (unsigned long)((te - ts) / 1000));
+  ASSERT_TRUE(result != NULL && lisp_len(result) == LIST_LENGTH);
+  X(&lisp, result);
+  free(input);
+  /*
+   */
+  ASSERT_TRUE(lisp_test_fini(&lisp));
+  OK;
+}
+
+/*
+ * Main.
+ */
+
+int
+main(UNUSED const int argc, UNUSED char** const argv)
+{
+  TEST(builder_tests);
+  TEST(scan_tests);
+  TEST(large_list_tests);
+  return 0;
+}
+
+// vim: tw=80:sw=2:ts=2:sts=2:et